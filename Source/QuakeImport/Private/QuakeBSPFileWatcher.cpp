@@ -0,0 +1,158 @@
+#include "QuakeBSPFileWatcher.h"
+
+#include "QuakeBSPImportAsset.h"
+
+#include "DirectoryWatcherModule.h"
+#include "Editor.h"
+#include "IDirectoryWatcher.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogQuakeFileWatcher, Log, All);
+
+namespace
+{
+	FString NormalizeWatchedPath(const FString& InPath)
+	{
+		FString Out = InPath;
+		if (FPaths::IsRelative(Out))
+		{
+			Out = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), Out);
+		}
+		FPaths::NormalizeFilename(Out);
+		FPaths::CollapseRelativeDirectories(Out);
+		return Out;
+	}
+
+	IDirectoryWatcher* GetDirectoryWatcher()
+	{
+		FDirectoryWatcherModule& Module = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+		return Module.Get();
+	}
+}
+
+FQuakeBSPFileWatcher::FQuakeBSPFileWatcher(UQuakeBSPImportAsset& InAsset, const TArray<FString>& InFilePaths, float InDebounceSeconds)
+	: Asset(&InAsset)
+	, DebounceSeconds(FMath::Max(0.0f, InDebounceSeconds))
+{
+	IDirectoryWatcher* Watcher = GetDirectoryWatcher();
+	if (!Watcher)
+	{
+		return;
+	}
+
+	for (const FString& FilePath : InFilePaths)
+	{
+		if (FilePath.IsEmpty())
+		{
+			continue;
+		}
+
+		const FString AbsFile = NormalizeWatchedPath(FilePath);
+		WatchedFiles.Add(AbsFile);
+
+		const FString Dir = FPaths::GetPath(AbsFile);
+		const bool bAlreadyWatched = WatchedDirectories.ContainsByPredicate([&Dir](const TPair<FString, FDelegateHandle>& It)
+		{
+			return It.Key.Equals(Dir, ESearchCase::IgnoreCase);
+		});
+		if (bAlreadyWatched)
+		{
+			continue;
+		}
+
+		FDelegateHandle Handle;
+		if (Watcher->RegisterDirectoryChangedCallback_Handle(Dir, IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FQuakeBSPFileWatcher::OnDirectoryChanged), Handle))
+		{
+			WatchedDirectories.Emplace(Dir, Handle);
+		}
+		else
+		{
+			UE_LOG(LogQuakeFileWatcher, Warning, TEXT("Could not watch directory: %s"), *Dir);
+		}
+	}
+
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FQuakeBSPFileWatcher::Tick), 0.25f);
+}
+
+FQuakeBSPFileWatcher::~FQuakeBSPFileWatcher()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	if (FModuleManager::Get().IsModuleLoaded(TEXT("DirectoryWatcher")))
+	{
+		if (IDirectoryWatcher* Watcher = GetDirectoryWatcher())
+		{
+			for (const TPair<FString, FDelegateHandle>& It : WatchedDirectories)
+			{
+				Watcher->UnregisterDirectoryChangedCallback_Handle(It.Key, It.Value);
+			}
+		}
+	}
+}
+
+bool FQuakeBSPFileWatcher::IsWatching(const TArray<FString>& InFilePaths, float InDebounceSeconds) const
+{
+	if (!FMath::IsNearlyEqual(DebounceSeconds, FMath::Max(0.0f, InDebounceSeconds)))
+	{
+		return false;
+	}
+
+	TSet<FString> Files;
+	for (const FString& FilePath : InFilePaths)
+	{
+		if (!FilePath.IsEmpty())
+		{
+			Files.Add(NormalizeWatchedPath(FilePath));
+		}
+	}
+	return Files.Num() == WatchedFiles.Num() && Files.Includes(WatchedFiles);
+}
+
+void FQuakeBSPFileWatcher::OnDirectoryChanged(const TArray<FFileChangeData>& Changes)
+{
+	for (const FFileChangeData& Change : Changes)
+	{
+		if (Change.Action == FFileChangeData::FCA_Removed)
+		{
+			continue;
+		}
+
+		if (WatchedFiles.Contains(NormalizeWatchedPath(Change.Filename)))
+		{
+			// Compilers write the BSP in several steps; restart the debounce on every write.
+			LastChangeTime = FPlatformTime::Seconds();
+			bChangePending = true;
+		}
+	}
+}
+
+bool FQuakeBSPFileWatcher::Tick(float DeltaTime)
+{
+	if (!bChangePending || FPlatformTime::Seconds() - LastChangeTime < DebounceSeconds)
+	{
+		return true;
+	}
+
+	// Never reimport while playing in editor; the change stays pending until PIE ends.
+	if (GEditor && GEditor->PlayWorld)
+	{
+		return true;
+	}
+
+	// A change made during an import stays pending and reimports once it finished.
+	UQuakeBSPImportAsset* ImportAsset = Asset.Get();
+	if (ImportAsset && ImportAsset->IsImportInProgress())
+	{
+		return true;
+	}
+
+	bChangePending = false;
+	if (ImportAsset)
+	{
+		UE_LOG(LogQuakeFileWatcher, Log, TEXT("BSP changed on disk, reimporting %s"), *ImportAsset->GetName());
+		ImportAsset->ReimportFromWatcher();
+	}
+	return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class UQuakeBSPImportAsset;
+struct FFileChangeData;
+
+// Watches the BSP / .lit files of an import asset and triggers a debounced reimport on the game thread.
+class FQuakeBSPFileWatcher
+{
+public:
+	FQuakeBSPFileWatcher(UQuakeBSPImportAsset& InAsset, const TArray<FString>& InFilePaths, float InDebounceSeconds);
+	~FQuakeBSPFileWatcher();
+
+	bool IsWatching(const TArray<FString>& InFilePaths, float InDebounceSeconds) const;
+
+private:
+	void OnDirectoryChanged(const TArray<FFileChangeData>& Changes);
+	bool Tick(float DeltaTime);
+
+	TWeakObjectPtr<UQuakeBSPImportAsset> Asset;
+	TSet<FString> WatchedFiles;
+	TArray<TPair<FString, FDelegateHandle>> WatchedDirectories;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	float DebounceSeconds = 1.0f;
+	double LastChangeTime = 0.0;
+	bool bChangePending = false;
+};
@@ -1,13 +1,42 @@
 #include "QuakeBSPImportAsset.h"
 
+#include "QuakeBSPFileWatcher.h"
 #include "QuakeBSPImportRunner.h"
 #include "QuakeBSPLevelInstanceUtils.h"
+#include "QuakeImportStats.h"
 
+#include "Containers/Ticker.h"
+#include "Editor.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
 #include "Misc/PackageName.h"
 #include "Misc/Paths.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Misc/ScopeExit.h"
+#include "Tasks/Task.h"
+#include "Widgets/Notifications/SNotificationList.h"
 
 #include "UObject/ConstructorHelpers.h"
 
+#define LOCTEXT_NAMESPACE "QuakeBSPImportAsset"
+
+namespace
+{
+	// One file watcher reimport: prepared on background tasks, then committed by a core ticker on the game thread.
+	struct FWatcherReimport
+	{
+		QuakeBspImportRunner::FWorldImportOptions WorldOptions;
+		QuakeBspImportRunner::FEntitiesImportOptions EntitiesOptions;
+		bool bImportEntities = false;
+
+		UE::Tasks::TTask<TUniquePtr<QuakeBspImportRunner::FPreparedImport>> WorldTask;
+		UE::Tasks::TTask<TUniquePtr<QuakeBspImportRunner::FPreparedImport>> EntitiesTask;
+
+		TSharedPtr<SNotificationItem> Notification;
+	};
+}
+
 UQuakeBSPImportAsset::UQuakeBSPImportAsset()
 {
 	static ConstructorHelpers::FObjectFinder<UMaterialInterface> MatSolid(TEXT("/QuakeImport/M_BSP_Solid.M_BSP_Solid"));
@@ -42,82 +71,342 @@ UQuakeBSPImportAsset::UQuakeBSPImportAsset()
 
 void UQuakeBSPImportAsset::ImportBSP()
 {
-const FString PackageName = GetOutermost() ? GetOutermost()->GetName() : TEXT("/Game");
-const FString FolderPath = FPackageName::GetLongPackagePath(PackageName);
-const FString MapName = FPaths::GetBaseFilename(BSPFile.FilePath);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuakeBSPImportAsset::ImportBSP);
 
-TArray<FString> BspMeshes;
-TArray<FString> WaterMeshes;
-TArray<FString> SkyMeshes;
+	if (bImportInProgress)
+	{
+		UE_LOG(LogQuakeImporter, Warning, TEXT("%s: an import is already running"), *GetName());
+		return;
+	}
+	TGuardValue<bool> ImportGuard(bImportInProgress, true);
 
-UMaterialInterface* BspParent = BSPWorldSolidMaterial.LoadSynchronous();
-if (!BspParent)
-{
-BspParent = BSPWorldSolidMaterial.LoadSynchronous();
+	FScopedSlowTask SlowTask(2.f, LOCTEXT("ImportingBspWorld", "Importing BSP world"));
+	SlowTask.MakeDialog(true);
+	SlowTask.EnterProgressFrame(1.f);
+
+	QuakeBspImportRunner::FImportResult Result;
+	const bool bImported = QuakeBspImportRunner::ImportBspWorld(QuakeBspImportRunner::MakeWorldImportOptions(*this), Result);
+
+	SlowTask.EnterProgressFrame(1.f, LOCTEXT("PopulatingLevel", "Populating generated level..."));
+	FinishWorldImport(bImported, Result);
 }
-UMaterialInterface* MaskedParent = BSPWorldMaskedMaterial.LoadSynchronous();
-UMaterialInterface* WaterParent = BSPWorldLiquidMaterial.LoadSynchronous();
-UMaterialInterface* SkyParent = BSPWorldSkyMaterial.LoadSynchronous();
 
-	if (!QuakeBspImportRunner::ImportBspWorld(BSPFile.FilePath, FolderPath, BSPLitFile.FilePath, WorldChunkMode, WorldChunkSize, ImportScale, bBSPWorldImportSky, bBSPWorldImportLiquids, bImportLightmaps, bOverwriteMaterialsAndTextures, BspParent, WaterParent, SkyParent, MaskedParent, BSPWorldSolidCollisionProfile.Name, BSPWorldMaskedCollisionProfile.Name, BSPLiquidCollisionProfile.Name, BSPSkyCollisionProfile.Name, &BspMeshes, &WaterMeshes, &SkyMeshes))
+void UQuakeBSPImportAsset::FinishWorldImport(bool bImported, QuakeBspImportRunner::FImportResult& Result)
 {
-return;
-}
+	const FString PackageName = GetOutermost() ? GetOutermost()->GetName() : TEXT("/Game");
+	const FString FolderPath = FPackageName::GetLongPackagePath(PackageName);
+	const FString MapName = FPaths::GetBaseFilename(BSPFile.FilePath);
+
+	// A cancelled import keeps the meshes it already rebuilt but never touches the generated level.
+	double PopulateStartSeconds = 0.0;
+	ON_SCOPE_EXIT
+	{
+		StoreImportReport(LastWorldImportReport, MoveTemp(Result.Report), PopulateStartSeconds);
+	};
+
+	if (!bImported)
+	{
+		return;
+	}
+
+	PopulateStartSeconds = FPlatformTime::Seconds();
+
+	ULevel* TargetLevel = nullptr;
+	if (!QuakeLevelInstanceUtils::EnsureGeneratedLevelReady(*this, MapName, FolderPath, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld, TargetLevel) || !TargetLevel)
+	{
+		return;
+	}
 
-MarkPackageDirty();
+	TMap<FString, FName> DesiredMeshes;
+	for (const FString& Mesh : Result.SolidMeshObjectPaths)
+	{
+		DesiredMeshes.Add(Mesh, BSPWorldSolidCollisionProfile.Name);
+	}
+	for (const FString& Mesh : Result.LiquidMeshObjectPaths)
+	{
+		DesiredMeshes.Add(Mesh, BSPLiquidCollisionProfile.Name);
+	}
+	for (const FString& Mesh : Result.SkyMeshObjectPaths)
+	{
+		DesiredMeshes.Add(Mesh, BSPSkyCollisionProfile.Name);
+	}
 
-ULevel* TargetLevel = nullptr;
-if (!QuakeLevelInstanceUtils::EnsureGeneratedLevelReady(*this, MapName, FolderPath, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld, TargetLevel) || !TargetLevel)
+	// Rebuilt chunks update in place; only a changed chunk set needs repopulating and reloading.
+	if (QuakeLevelInstanceUtils::IsLevelPopulatedWith(*TargetLevel, DesiredMeshes))
+	{
+		return;
+	}
+
+	QuakeLevelInstanceUtils::ClearGeneratedActors(*TargetLevel, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
+	QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, Result.SolidMeshObjectPaths, BSPWorldSolidCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
+	QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, Result.LiquidMeshObjectPaths, BSPLiquidCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
+	QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, Result.SkyMeshObjectPaths, BSPSkyCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
+	QuakeLevelInstanceUtils::RefreshPlacedLevelInstances(*this, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
+}
+
+void UQuakeBSPImportAsset::ImportEntities()
 {
-return;
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuakeBSPImportAsset::ImportEntities);
+
+	if (bImportInProgress)
+	{
+		UE_LOG(LogQuakeImporter, Warning, TEXT("%s: an import is already running"), *GetName());
+		return;
+	}
+	TGuardValue<bool> ImportGuard(bImportInProgress, true);
+
+	FScopedSlowTask SlowTask(2.f, LOCTEXT("ImportingBspEntities", "Importing BSP entities"));
+	SlowTask.MakeDialog(true);
+	SlowTask.EnterProgressFrame(1.f);
+
+	QuakeBspImportRunner::FImportResult Result;
+	const bool bImported = QuakeBspImportRunner::ImportBspEntities(QuakeBspImportRunner::MakeEntitiesImportOptions(*this), Result);
+
+	SlowTask.EnterProgressFrame(1.f, LOCTEXT("PopulatingLevel", "Populating generated level..."));
+	FinishEntitiesImport(bImported, Result);
 }
 
-QuakeLevelInstanceUtils::ClearGeneratedActors(*TargetLevel, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
-QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, BspMeshes, BSPWorldSolidCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
-QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, WaterMeshes, BSPLiquidCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
-QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, SkyMeshes, BSPSkyCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
-QuakeLevelInstanceUtils::RefreshPlacedLevelInstances(*this, QuakeLevelInstanceUtils::EGenLevelKind::BspWorld);
+void UQuakeBSPImportAsset::FinishEntitiesImport(bool bImported, QuakeBspImportRunner::FImportResult& Result)
+{
+	const FString PackageName = GetOutermost() ? GetOutermost()->GetName() : TEXT("/Game");
+	const FString FolderPath = FPackageName::GetLongPackagePath(PackageName);
+	const FString MapName = FPaths::GetBaseFilename(BSPFile.FilePath);
+
+	double PopulateStartSeconds = 0.0;
+	ON_SCOPE_EXIT
+	{
+		StoreImportReport(LastEntitiesImportReport, MoveTemp(Result.Report), PopulateStartSeconds);
+	};
+
+	if (!bImported)
+	{
+		return;
+	}
+
+	PopulateStartSeconds = FPlatformTime::Seconds();
+
+	ULevel* TargetLevel = nullptr;
+	if (!QuakeLevelInstanceUtils::EnsureGeneratedLevelReady(*this, MapName, FolderPath, QuakeLevelInstanceUtils::EGenLevelKind::Entities, TargetLevel) || !TargetLevel)
+	{
+		return;
+	}
+
+	TMap<FString, FName> DesiredMeshes;
+	for (const FString& Mesh : Result.SolidMeshObjectPaths)
+	{
+		DesiredMeshes.Add(Mesh, BSPEntitySolidCollisionProfile.Name);
+	}
+	for (const FString& Mesh : Result.TriggerMeshObjectPaths)
+	{
+		DesiredMeshes.Add(Mesh, BSPEntityTriggerCollisionProfile.Name);
+	}
+
+	// Rebuilt meshes update in place; only a changed mesh set needs repopulating and reloading.
+	if (QuakeLevelInstanceUtils::IsLevelPopulatedWith(*TargetLevel, DesiredMeshes))
+	{
+		return;
+	}
+
+	QuakeLevelInstanceUtils::ClearGeneratedActors(*TargetLevel, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
+	QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, Result.SolidMeshObjectPaths, BSPEntitySolidCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
+	QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, Result.TriggerMeshObjectPaths, BSPEntityTriggerCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
+	QuakeLevelInstanceUtils::RefreshPlacedLevelInstances(*this, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
 }
 
-void UQuakeBSPImportAsset::ImportEntities()
+void UQuakeBSPImportAsset::StoreImportReport(FQuakeImportReport& Target, FQuakeImportReport&& Report, double PopulateStartSeconds)
 {
-const FString PackageName = GetOutermost() ? GetOutermost()->GetName() : TEXT("/Game");
-const FString FolderPath = FPackageName::GetLongPackagePath(PackageName);
-const FString MapName = FPaths::GetBaseFilename(BSPFile.FilePath);
+	if (!Report.IsValid())
+	{
+		return;
+	}
+
+	if (PopulateStartSeconds > 0.0)
+	{
+		Report.PopulateSeconds = FPlatformTime::Seconds() - PopulateStartSeconds;
+		Report.TotalSeconds += Report.PopulateSeconds;
+	}
+	Report.FlagOutliers(ReportMaxSectionsPerChunk, ReportMinTrianglesPerChunk);
 
-	TArray<FString> SolidEntityMeshes;
-	TArray<FString> TriggerEntityMeshes;
+	UE_LOG(LogQuakeImporter, Log, TEXT("%s %s: %d chunks (%d rebuilt), %d triangles, %d sections, %.1f MB textures, atlas %dx%d at %.0f%% occupancy, %.2fs"),
+		*Report.MapName, *Report.ImportKind, Report.NumChunks, Report.NumRebuilt, Report.NumTriangles, Report.NumSections,
+		double(Report.TextureBytes) / (1024.0 * 1024.0), Report.LightmapAtlasWidth, Report.LightmapAtlasHeight, Report.LightmapAtlasOccupancy * 100.f, Report.TotalSeconds);
 
-	UMaterialInterface* SolidParent = BSPEntitySolidMaterial.LoadSynchronous();
-	if (!SolidParent)
+	if (Report.NumChunksWithTooManySections > 0 || Report.NumNearlyEmptyChunks > 0)
 	{
-		SolidParent = BSPEntitySolidMaterial.LoadSynchronous();
+		UE_LOG(LogQuakeImporter, Warning, TEXT("%s %s: %d chunks with more than %d sections, %d chunks under %d triangles"),
+			*Report.MapName, *Report.ImportKind, Report.NumChunksWithTooManySections, ReportMaxSectionsPerChunk, Report.NumNearlyEmptyChunks, ReportMinTrianglesPerChunk);
+		for (const FQuakeImportChunkReport& Chunk : Report.Chunks)
+		{
+			if (Chunk.bTooManySections || Chunk.bNearlyEmpty)
+			{
+				UE_LOG(LogQuakeImporter, Verbose, TEXT("  %s: %d sections, %d triangles"), *Chunk.MeshName, Chunk.Sections, Chunk.Triangles);
+			}
+		}
 	}
-	UMaterialInterface* MaskedParent = BSPEntityMaskedMaterial.LoadSynchronous();
-	UMaterialInterface* TriggerParent = BSPEntityTriggerMaterial.LoadSynchronous();
-	UMaterialInterface* WaterParent = BSPWorldLiquidMaterial.LoadSynchronous();
-	UMaterialInterface* SkyParent = BSPWorldSkyMaterial.LoadSynchronous();
 
-	if (!QuakeBspImportRunner::ImportBspEntities(BSPFile.FilePath, FolderPath, BSPLitFile.FilePath, ImportScale, bImportFuncDoors, bImportFuncPlats, bImportFuncTriggers, bImportLightmaps, bOverwriteMaterialsAndTextures, SolidParent, WaterParent, SkyParent, TriggerParent, MaskedParent, BSPEntitySolidCollisionProfile.Name, BSPEntityMaskedCollisionProfile.Name, BSPEntityTriggerCollisionProfile.Name, &SolidEntityMeshes, &TriggerEntityMeshes))
+	Target = MoveTemp(Report);
+}
+
+void UQuakeBSPImportAsset::ExportImportReports()
 {
-return;
+	const FString ReportsDir = FPaths::ProjectSavedDir() / TEXT("QuakeImport") / TEXT("Reports");
+
+	for (const FQuakeImportReport* Report : { &LastWorldImportReport, &LastEntitiesImportReport })
+	{
+		if (!Report->IsValid())
+		{
+			continue;
+		}
+
+		const FString BasePath = ReportsDir / FString::Printf(TEXT("%s_%s"), *Report->MapName, *Report->ImportKind);
+		FString Json;
+		if (!Report->ToJsonString(Json) || !FFileHelper::SaveStringToFile(Json, *(BasePath + TEXT(".json"))))
+		{
+			UE_LOG(LogQuakeImporter, Error, TEXT("Failed to write %s.json"), *BasePath);
+			continue;
+		}
+		if (!FFileHelper::SaveStringToFile(Report->ToCsvString(), *(BasePath + TEXT(".csv"))))
+		{
+			UE_LOG(LogQuakeImporter, Error, TEXT("Failed to write %s.csv"), *BasePath);
+			continue;
+		}
+		UE_LOG(LogQuakeImporter, Log, TEXT("Wrote import report %s.json / .csv"), *BasePath);
+	}
 }
 
-	TArray<FString> AllEntityMeshes;
-	AllEntityMeshes.Reserve(SolidEntityMeshes.Num() + TriggerEntityMeshes.Num());
-	AllEntityMeshes.Append(SolidEntityMeshes);
-	AllEntityMeshes.Append(TriggerEntityMeshes);
+void UQuakeBSPImportAsset::PostLoad()
+{
+	Super::PostLoad();
+	UpdateFileWatcher();
+}
 
-MarkPackageDirty();
+void UQuakeBSPImportAsset::BeginDestroy()
+{
+	FileWatcher.Reset();
+	Super::BeginDestroy();
+}
 
-ULevel* TargetLevel = nullptr;
-if (!QuakeLevelInstanceUtils::EnsureGeneratedLevelReady(*this, MapName, FolderPath, QuakeLevelInstanceUtils::EGenLevelKind::Entities, TargetLevel) || !TargetLevel)
+#if WITH_EDITOR
+void UQuakeBSPImportAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
-return;
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	UpdateFileWatcher();
 }
+#endif
 
-	QuakeLevelInstanceUtils::ClearGeneratedActors(*TargetLevel, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
-	QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, SolidEntityMeshes, BSPEntitySolidCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
-	QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision(*TargetLevel, TriggerEntityMeshes, BSPEntityTriggerCollisionProfile.Name, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
-QuakeLevelInstanceUtils::RefreshPlacedLevelInstances(*this, QuakeLevelInstanceUtils::EGenLevelKind::Entities);
+void UQuakeBSPImportAsset::UpdateFileWatcher()
+{
+	if (!bWatchBSPFile || BSPFile.FilePath.IsEmpty() || IsTemplate() || IsRunningCommandlet())
+	{
+		FileWatcher.Reset();
+		return;
+	}
+
+	TArray<FString> Files;
+	Files.Add(BSPFile.FilePath);
+	// Lightmaps and baked vertex lighting both read the .lit colours.
+	if ((bImportLightmaps || bBakeVertexLighting) && !BSPLitFile.FilePath.IsEmpty())
+	{
+		Files.Add(BSPLitFile.FilePath);
+	}
+
+	if (FileWatcher.IsValid() && FileWatcher->IsWatching(Files, WatchDebounceSeconds))
+	{
+		return;
+	}
+
+	FileWatcher = MakeShared<FQuakeBSPFileWatcher>(*this, Files, WatchDebounceSeconds);
 }
+
+void UQuakeBSPImportAsset::ReimportFromWatcher()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuakeBSPImportAsset::ReimportFromWatcher);
+
+	if (bImportInProgress)
+	{
+		return;
+	}
+	bImportInProgress = true;
+
+	// Both prepares run on background tasks while the editor stays responsive; the ticker commits them on the
+	// game thread once they are done. Progress is a notification rather than a modal dialog.
+	TSharedRef<FWatcherReimport> Reimport = MakeShared<FWatcherReimport>();
+	Reimport->WorldOptions = QuakeBspImportRunner::MakeWorldImportOptions(*this);
+	Reimport->WorldTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Options = Reimport->WorldOptions]()
+	{
+		return QuakeBspImportRunner::PrepareBspWorld(Options);
+	});
+
+	Reimport->bImportEntities = bWatchReimportEntities && !GeneratedLevelEntities.IsNull();
+	if (Reimport->bImportEntities)
+	{
+		Reimport->EntitiesOptions = QuakeBspImportRunner::MakeEntitiesImportOptions(*this);
+		Reimport->EntitiesTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Options = Reimport->EntitiesOptions]()
+		{
+			return QuakeBspImportRunner::PrepareBspEntities(Options);
+		});
+	}
+
+	const FText FileName = FText::FromString(FPaths::GetCleanFilename(BSPFile.FilePath));
+	FNotificationInfo Info(FText::Format(LOCTEXT("WatcherReimporting", "Reimporting {0}..."), FileName));
+	Info.bFireAndForget = false;
+	Info.ExpireDuration = 3.f;
+	Reimport->Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (Reimport->Notification.IsValid())
+	{
+		Reimport->Notification->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+
+	TWeakObjectPtr<UQuakeBSPImportAsset> WeakThis(this);
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis, Reimport, FileName](float DeltaTime)
+	{
+		if (!Reimport->WorldTask.IsCompleted() || (Reimport->bImportEntities && !Reimport->EntitiesTask.IsCompleted()))
+		{
+			return true;
+		}
+
+		// Like the watcher itself, never commit while playing in editor.
+		if (GEditor && GEditor->PlayWorld)
+		{
+			return true;
+		}
+
+		TUniquePtr<QuakeBspImportRunner::FPreparedImport> PreparedWorld = MoveTemp(Reimport->WorldTask.GetResult());
+		TUniquePtr<QuakeBspImportRunner::FPreparedImport> PreparedEntities;
+		if (Reimport->bImportEntities)
+		{
+			PreparedEntities = MoveTemp(Reimport->EntitiesTask.GetResult());
+		}
+
+		bool bSucceeded = false;
+		if (UQuakeBSPImportAsset* Asset = WeakThis.Get())
+		{
+			QuakeBspImportRunner::FImportResult WorldResult;
+			bSucceeded = PreparedWorld && QuakeBspImportRunner::CommitBspWorld(*PreparedWorld, Reimport->WorldOptions, WorldResult);
+			PreparedWorld.Reset();
+			Asset->FinishWorldImport(bSucceeded, WorldResult);
+
+			if (bSucceeded && Reimport->bImportEntities)
+			{
+				QuakeBspImportRunner::FImportResult EntitiesResult;
+				bSucceeded = PreparedEntities && QuakeBspImportRunner::CommitBspEntities(*PreparedEntities, Reimport->EntitiesOptions, EntitiesResult);
+				PreparedEntities.Reset();
+				Asset->FinishEntitiesImport(bSucceeded, EntitiesResult);
+			}
+
+			Asset->bImportInProgress = false;
+		}
+
+		if (TSharedPtr<SNotificationItem> Notification = Reimport->Notification)
+		{
+			Notification->SetText(bSucceeded
+				? FText::Format(LOCTEXT("WatcherReimported", "Reimported {0}"), FileName)
+				: FText::Format(LOCTEXT("WatcherReimportFailed", "Reimport of {0} failed, see the output log"), FileName));
+			Notification->SetCompletionState(bSucceeded ? SNotificationItem::CS_Success : SNotificationItem::CS_Fail);
+			Notification->ExpireAndFadeout();
+		}
+		return false;
+	}), 0.1f);
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,33 @@
+#include "QuakeBSPImportReport.h"
+
+#include "JsonObjectConverter.h"
+
+void FQuakeImportReport::FlagOutliers(int32 MaxSectionsPerChunk, int32 MinTrianglesPerChunk)
+{
+	NumChunksWithTooManySections = 0;
+	NumNearlyEmptyChunks = 0;
+
+	for (FQuakeImportChunkReport& Chunk : Chunks)
+	{
+		Chunk.bTooManySections = MaxSectionsPerChunk > 0 && Chunk.Sections > MaxSectionsPerChunk;
+		Chunk.bNearlyEmpty = MinTrianglesPerChunk > 0 && Chunk.Triangles < MinTrianglesPerChunk;
+		NumChunksWithTooManySections += Chunk.bTooManySections ? 1 : 0;
+		NumNearlyEmptyChunks += Chunk.bNearlyEmpty ? 1 : 0;
+	}
+}
+
+bool FQuakeImportReport::ToJsonString(FString& OutJson) const
+{
+	return FJsonObjectConverter::UStructToJsonObjectString(*this, OutJson);
+}
+
+FString FQuakeImportReport::ToCsvString() const
+{
+	FString Out = TEXT("MeshName,Kind,Faces,Triangles,Vertices,Sections,CollisionTriangles,LightmapSize,Rebuilt,TooManySections,NearlyEmpty\n");
+	for (const FQuakeImportChunkReport& Chunk : Chunks)
+	{
+		Out += FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d\n"), *Chunk.MeshName, *Chunk.Kind, Chunk.Faces, Chunk.Triangles, Chunk.Vertices,
+			Chunk.Sections, Chunk.CollisionTriangles, Chunk.LightmapSize, Chunk.bRebuilt ? 1 : 0, Chunk.bTooManySections ? 1 : 0, Chunk.bNearlyEmpty ? 1 : 0);
+	}
+	return Out;
+}
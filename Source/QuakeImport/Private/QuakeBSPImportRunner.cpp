@@ -2,21 +2,35 @@
 
 #include "QuakeBSPUtilities.h"
 #include "QuakeImportCommon.h"
+#include "QuakeImportStats.h"
 
 #include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
 #include "Materials/Material.h"
 #include "Materials/MaterialInterface.h"
 #include "Materials/MaterialInstanceConstant.h"
+#include "Materials/MaterialParameterCollection.h"
 #include "Engine/CollisionProfile.h"
+#include "Engine/Texture2DArray.h"
+#include "HAL/PlatformTime.h"
+#include "Hash/xxhash.h"
 #include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
 #include "Misc/Paths.h"
+#include "Misc/ScopedSlowTask.h"
 #include "Modules/ModuleManager.h"
+#include "Tasks/Task.h"
+#include "UObject/MetaData.h"
 #include "UObject/Package.h"
 
+#define LOCTEXT_NAMESPACE "QuakeBspImportRunner"
+
 DEFINE_LOG_CATEGORY_STATIC(LogQuakeImportRunner, Log, All);
 
 namespace
 {
+	using namespace QuakeBspImportRunner;
+
 	FString SanitizeSurfaceNameForAsset(const FString& InName)
 	{
 		FString Out = InName;
@@ -45,6 +59,12 @@ namespace
 		return TexName.Equals(TEXT("trigger"), ESearchCase::IgnoreCase);
 	}
 
+	// Sky, liquids and triggers are drawn by their configured parents, never by generated ones.
+	bool HasDedicatedParentMaterial(const FString& TexName)
+	{
+		return TexName.StartsWith(TEXT("sky")) || TexName.StartsWith(TEXT("trigger"), ESearchCase::IgnoreCase) || IsTransparentSurfaceName(TexName);
+	}
+
 	UPackage* CreateAssetPackage(const FString& LongPackageName)
 	{
 		UPackage* Pkg = CreatePackage(*LongPackageName);
@@ -55,205 +75,1184 @@ namespace
 		return Pkg;
 	}
 
-	struct FLoadedBsp
+	// Accumulates the wall time of each prepare stage into FPreparedImport::StageSeconds.
+	struct FStageTimer
 	{
-		TArray<uint8> FileData;
-		bsputils::BspLoader Loader;
-		const bsputils::bspformat29::Bsp_29* Model = nullptr;
-
-		FString AbsPath;
-		FString MapName;
-		FString MapPath;
-		FString TexturesPath;
-		FString MaterialsPath;
+		explicit FStageTimer(FPreparedImport& InPrepared)
+			: Prepared(InPrepared)
+		{
+		}
+
+		~FStageTimer()
+		{
+			Stop();
+		}
+
+		void Enter(EPrepareStage Stage)
+		{
+			Stop();
+			CurrentStage = int32(Stage);
+			StartSeconds = FPlatformTime::Seconds();
+		}
+
+		void Stop()
+		{
+			if (CurrentStage >= 0)
+			{
+				Prepared.StageSeconds[CurrentStage] += FPlatformTime::Seconds() - StartSeconds;
+				CurrentStage = -1;
+			}
+		}
+
+		FPreparedImport& Prepared;
+		int32 CurrentStage = -1;
+		double StartSeconds = 0.0;
 	};
 
-	bool LoadBspFile(const FString& BspFilePath, const FString& TargetFolderLongPackagePath, FLoadedBsp& Out)
+	// Returns false when the import was cancelled before entering Stage.
+	bool EnterStage(FImportProgress* Progress, FStageTimer& Timer, EPrepareStage Stage)
 	{
-		Out.AbsPath = BspFilePath;
+		Timer.Enter(Stage);
+		if (!Progress)
+		{
+			return true;
+		}
+
+		Progress->Stage.store(Stage);
+		return !Progress->bCancelRequested.load();
+	}
+
+	FText GetStageText(EPrepareStage Stage)
+	{
+		switch (Stage)
+		{
+		case EPrepareStage::Load:
+			return LOCTEXT("StageLoad", "Reading BSP file...");
+		case EPrepareStage::Textures:
+			return LOCTEXT("StageTextures", "Converting textures...");
+		case EPrepareStage::Atlas:
+			return LOCTEXT("StageAtlas", "Packing lightmap atlas...");
+		case EPrepareStage::Geometry:
+			return LOCTEXT("StageGeometry", "Assembling geometry...");
+		default:
+			return FText::GetEmpty();
+		}
+	}
+
+	// The file data only lives during parsing; BspLoader copies everything it needs.
+	bool LoadBspFile(const FString& BspFilePath, const FString& TargetFolderLongPackagePath, FPreparedImport& Out)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::LoadBspFile);
+
+		FString AbsPath = BspFilePath;
 
-		if (FPaths::IsRelative(Out.AbsPath))
+		if (FPaths::IsRelative(AbsPath))
 		{
-			Out.AbsPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), Out.AbsPath);
+			AbsPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), AbsPath);
 		}
 
-		if (!FPaths::FileExists(Out.AbsPath))
+		if (!FPaths::FileExists(AbsPath))
 		{
-			UE_LOG(LogQuakeImportRunner, Error, TEXT("BSP file not found: %s"), *Out.AbsPath);
+			UE_LOG(LogQuakeImportRunner, Error, TEXT("BSP file not found: %s"), *AbsPath);
 			return false;
 		}
 
-		Out.MapName = FPaths::GetBaseFilename(Out.AbsPath);
+		Out.MapName = FPaths::GetBaseFilename(AbsPath);
 		Out.MapPath = TargetFolderLongPackagePath / Out.MapName;
 		Out.TexturesPath = TargetFolderLongPackagePath / TEXT("Textures");
 		Out.MaterialsPath = Out.MapPath / TEXT("Materials");
+		Out.LightmapsPath = Out.MapPath / TEXT("Lightmaps");
 
-		if (!FFileHelper::LoadFileToArray(Out.FileData, *Out.AbsPath))
+		TArray<uint8> FileData;
+		if (!FFileHelper::LoadFileToArray(FileData, *AbsPath))
 		{
-			UE_LOG(LogQuakeImportRunner, Error, TEXT("Failed to read bsp file: %s"), *Out.AbsPath);
+			UE_LOG(LogQuakeImportRunner, Error, TEXT("Failed to read bsp file: %s"), *AbsPath);
 			return false;
 		}
 
-		const uint8* Buffer = Out.FileData.GetData();
-		Out.Loader.Load(Buffer, Out.FileData.Num());
+		Out.Loader.Load(FileData.GetData(), FileData.Num());
 		Out.Model = Out.Loader.GetBspPtr();
 
-		if (!Out.Model)
+		if (!Out.Model)
+		{
+			UE_LOG(LogQuakeImportRunner, Error, TEXT("Failed to parse bsp file: %s"), *AbsPath);
+			return false;
+		}
+
+		return true;
+	}
+
+	// Palette indices of mip levels 0 to 3 of a texture, as far as the BSP has them. Each level of an animation holds
+	// every frame in order.
+	using FTextureLevels = TArray<TArray<uint8>, TInlineAllocator<4>>;
+
+	struct FTextureImportSettings
+	{
+		bool bMips = true;
+		bool bPaletteIndexed = false;
+		bool bFullbrightInAlpha = false;
+		EBspTextureEncoding Encoding = EBspTextureEncoding::Default;
+	};
+
+	template<typename OptionsType>
+	FTextureImportSettings MakeTextureImportSettings(const OptionsType& Options)
+	{
+		FTextureImportSettings Settings;
+		Settings.bMips = Options.bImportTextureMips;
+		Settings.bPaletteIndexed = Options.bPaletteIndexedTextures;
+		Settings.bFullbrightInAlpha = Options.bFullbrightInAlpha;
+		Settings.Encoding = Options.TextureEncoding;
+		return Settings;
+	}
+
+	void SetContentHash(FPreparedTexture& Prepared)
+	{
+		FXxHash64Builder Builder;
+		const int32 Header[5] = { Prepared.Width, Prepared.Height, Prepared.NumSlices, Prepared.NumMips, int32(Prepared.Format) };
+		Builder.Update(Header, sizeof(Header));
+		Builder.Update(Prepared.Pixels.GetData(), Prepared.Pixels.Num());
+		Prepared.ContentHash = FString::Printf(TEXT("%016llx"), Builder.Finalize().Hash);
+	}
+
+	QuakeCommon::EPaletteTextureFormat SelectTextureFormat(const FTextureImportSettings& Settings, bool bUsesAlpha)
+	{
+		if (Settings.bPaletteIndexed)
+		{
+			return QuakeCommon::EPaletteTextureFormat::Indexed;
+		}
+		switch (Settings.Encoding)
+		{
+		case EBspTextureEncoding::BC1_BC3:
+			return bUsesAlpha ? QuakeCommon::EPaletteTextureFormat::BC3 : QuakeCommon::EPaletteTextureFormat::BC1;
+		case EBspTextureEncoding::BC1_BC7:
+			return bUsesAlpha ? QuakeCommon::EPaletteTextureFormat::BC7 : QuakeCommon::EPaletteTextureFormat::BC1;
+		default:
+			return QuakeCommon::EPaletteTextureFormat::BGRA8;
+		}
+	}
+
+	bool ContainsFullbrightIndex(const TArray<uint8>& Indices)
+	{
+		for (const uint8 Index : Indices)
+		{
+			if (Index >= QuakeCommon::FirstFullbrightIndex)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool PrepareTextures(const bsputils::bspformat29::Bsp_29& Model, const FTextureImportSettings& Settings, TArray<FPreparedTexture>& OutTextures)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::PrepareTextures);
+
+		TArray<QuakeCommon::QColor> QuakePalette;
+		if (!QuakeCommon::LoadPalette(QuakePalette))
+		{
+			UE_LOG(LogQuakeImportRunner, Error, TEXT("Palette.lmp not found."));
+			return false;
+		}
+
+		QuakeCommon::FPaletteLUT OpaqueLUT;
+		QuakeCommon::BuildPaletteLUT(QuakePalette, QuakeCommon::EPaletteLUTVariant::Opaque, OpaqueLUT);
+		QuakeCommon::FPaletteLUT MaskedLUT;
+		QuakeCommon::BuildPaletteLUT(QuakePalette, QuakeCommon::EPaletteLUTVariant::Masked, MaskedLUT);
+		QuakeCommon::FPaletteLUT FullbrightLUT;
+		QuakeCommon::BuildPaletteLUT(QuakePalette, QuakeCommon::EPaletteLUTVariant::Fullbright, FullbrightLUT);
+
+		// Textures are independent, so each is split and expanded on its own worker; results keep BSP order.
+		TArray<TArray<FPreparedTexture, TInlineAllocator<2>>> PerTexture;
+		PerTexture.SetNum(Model.textures.Num());
+		ParallelFor(Model.textures.Num(), [&Model, &QuakePalette, &OpaqueLUT, &MaskedLUT, &FullbrightLUT, &PerTexture, &Settings](int32 TexIndex)
+		{
+			const auto& ItTex = Model.textures[TexIndex];
+
+			// Only the generated parents look palette indices up, so surfaces with a dedicated parent stay BGRA8.
+			FTextureImportSettings TextureSettings = Settings;
+			if (Settings.bPaletteIndexed && HasDedicatedParentMaterial(ItTex.name))
+			{
+				TextureSettings.bPaletteIndexed = false;
+				TextureSettings.Encoding = EBspTextureEncoding::Default;
+			}
+			const int32 NumLevels = Settings.bMips ? 4 : 1;
+			auto GetLevel = [&ItTex](int32 Level) -> const TArray<uint8>&
+			{
+				return Level == 0 ? ItTex.mip0 : ItTex.lowerMips[Level - 1];
+			};
+
+			// The first frame of an animation and its array share their alpha semantics, decided over every frame.
+			TArray<int32> Frames;
+			const bool bAnimated = bsputils::GetTextureSequence(Model, TexIndex, Frames) && Frames.Num() > 1;
+			bool bAnyFrameHasPaletteAlpha = false;
+			bool bAnyFrameHasFullbright = false;
+			if (bAnimated)
+			{
+				for (const int32 FrameIndex : Frames)
+				{
+					bAnyFrameHasPaletteAlpha |= Model.textures[FrameIndex].mip0.Contains(uint8(255));
+					bAnyFrameHasFullbright |= ContainsFullbrightIndex(Model.textures[FrameIndex].mip0);
+				}
+			}
+
+			// Authored levels are kept while their size matches, then the chain is filtered down to 1x1.
+			auto AddTexture = [&](const FString& TexOriginalName, const FString& MaterialTextureName, int32 W, int32 H, const FTextureLevels& InLevels, int32 NumSlices = 1)
+			{
+				if (InLevels.Num() == 0)
+				{
+					return;
+				}
+
+				// Block compressed encodings get power-of-two sizes. Each authored level is resized on its own, so the
+				// mips keep their authored look.
+				FTextureLevels Resized;
+				if (!TextureSettings.bPaletteIndexed && TextureSettings.Encoding != EBspTextureEncoding::Default && (!FMath::IsPowerOfTwo(W) || !FMath::IsPowerOfTwo(H)))
+				{
+					const int32 PotW = int32(FMath::RoundUpToPowerOfTwo(uint32(W)));
+					const int32 PotH = int32(FMath::RoundUpToPowerOfTwo(uint32(H)));
+					for (int32 Level = 0; Level < InLevels.Num() && (W % (1 << Level)) == 0 && (H % (1 << Level)) == 0
+						&& InLevels[Level].Num() == int64(W >> Level) * (H >> Level) * NumSlices; Level++)
+					{
+						const int32 SrcW = W >> Level;
+						const int32 SrcH = H >> Level;
+						const int32 DstW = FMath::Max(PotW >> Level, 1);
+						const int32 DstH = FMath::Max(PotH >> Level, 1);
+						TArray<uint8>& Dst = Resized.AddDefaulted_GetRef();
+						Dst.SetNumUninitialized(DstW * DstH * NumSlices);
+						for (int32 Slice = 0; Slice < NumSlices; Slice++)
+						{
+							QuakeCommon::ResamplePaletteIndicesNearest(InLevels[Level].GetData() + int64(Slice) * SrcW * SrcH, SrcW, SrcH,
+								Dst.GetData() + int64(Slice) * DstW * DstH, DstW, DstH);
+						}
+					}
+					if (Resized.Num() > 0)
+					{
+						W = PotW;
+						H = PotH;
+					}
+				}
+				const FTextureLevels& Levels = Resized.Num() > 0 ? Resized : InLevels;
+
+				FPreparedTexture& Prepared = PerTexture[TexIndex].AddDefaulted_GetRef();
+				Prepared.AssetName = SanitizeSurfaceNameForAsset(TexOriginalName);
+				Prepared.MaterialTextureName = MaterialTextureName;
+				Prepared.Width = W;
+				Prepared.Height = H;
+				Prepared.NumSlices = NumSlices;
+				// Index 255 is transparent. Palette indexed textures follow Quake, where that holds only in textures named
+				// {..., and 255 is an ordinary color elsewhere.
+				Prepared.bHasPaletteAlpha = (bAnyFrameHasPaletteAlpha || Levels[0].Contains(uint8(255)))
+					&& (!TextureSettings.bPaletteIndexed || ItTex.name.StartsWith(TEXT("{")));
+
+				// Masked textures keep alpha for opacity. Sky, liquids and triggers keep their configured parents, which never
+				// read the mask.
+				Prepared.bFullbrightInAlpha = Settings.bFullbrightInAlpha && !Settings.bPaletteIndexed && !Prepared.bHasPaletteAlpha
+					&& !HasDedicatedParentMaterial(ItTex.name) && (bAnyFrameHasFullbright || ContainsFullbrightIndex(Levels[0]));
+				const QuakeCommon::FPaletteLUT& LUT = Prepared.bFullbrightInAlpha ? FullbrightLUT : Prepared.bHasPaletteAlpha ? MaskedLUT : OpaqueLUT;
+				Prepared.Format = SelectTextureFormat(TextureSettings, Prepared.bHasPaletteAlpha || Prepared.bFullbrightInAlpha);
+
+				int32 NumAuthored = 0;
+				int64 Texels = 0;
+				while (NumAuthored < Levels.Num() && (W % (1 << NumAuthored)) == 0 && (H % (1 << NumAuthored)) == 0
+					&& Levels[NumAuthored].Num() == int64(W >> NumAuthored) * (H >> NumAuthored) * NumSlices)
+				{
+					Texels += Levels[NumAuthored].Num();
+					NumAuthored++;
+				}
+				if (NumAuthored == 0)
+				{
+					PerTexture[TexIndex].Pop();
+					return;
+				}
+
+				if (Prepared.Format == QuakeCommon::EPaletteTextureFormat::Indexed)
+				{
+					Prepared.Pixels.Reserve(int32(Texels));
+					for (int32 Level = 0; Level < NumAuthored; Level++)
+					{
+						Prepared.Pixels.Append(Levels[Level]);
+					}
+					INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, Texels);
+
+					Prepared.NumMips = Settings.bMips ? QuakeCommon::AppendPaletteMipsIndexed(Prepared.Pixels, W, H, NumAuthored, QuakePalette, Prepared.bHasPaletteAlpha, NumSlices) : 1;
+				}
+				else
+				{
+					Prepared.Pixels.SetNumUninitialized(int32(Texels * 4));
+					int64 Offset = 0;
+					for (int32 Level = 0; Level < NumAuthored; Level++)
+					{
+						QuakeCommon::ExpandPaletteIndices(Levels[Level].GetData(), Levels[Level].Num(), LUT, Prepared.Pixels.GetData() + Offset * 4);
+						Offset += Levels[Level].Num();
+					}
+					INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, Texels * 4);
+
+					Prepared.NumMips = Settings.bMips ? QuakeCommon::AppendBoxFilteredMipsBGRA(Prepared.Pixels, W, H, NumAuthored, NumSlices) : 1;
+				}
+
+				SetContentHash(Prepared);
+				INC_DWORD_STAT(STAT_QuakeImport_Textures);
+			};
+
+			if (ItTex.name.StartsWith(TEXT("sky")))
+			{
+				// Front and back layers are the left and right halves of every level.
+				FTextureLevels Front;
+				FTextureLevels Back;
+				for (int32 Level = 0; Level < NumLevels && GetLevel(Level).Num() > 0; Level++)
+				{
+					const int32 LevelW = int32(ItTex.width >> Level);
+					const int32 LevelH = int32(ItTex.height >> Level);
+					TArray<uint8>& FrontLevel = Front.AddDefaulted_GetRef();
+					TArray<uint8>& BackLevel = Back.AddDefaulted_GetRef();
+					FrontLevel.Reserve((LevelW / 2) * LevelH);
+					BackLevel.Reserve((LevelW / 2) * LevelH);
+
+					for (int32 Y = 0; Y < LevelH; Y++)
+					{
+						const uint8* Row = GetLevel(Level).GetData() + Y * LevelW;
+						FrontLevel.Append(Row, LevelW / 2);
+						BackLevel.Append(Row + LevelW / 2, LevelW - LevelW / 2);
+					}
+				}
+
+				AddTexture(SanitizeSurfaceNameForAsset(ItTex.name + TEXT("_front")), FString(), ItTex.width / 2, ItTex.height, Front);
+				AddTexture(SanitizeSurfaceNameForAsset(ItTex.name + TEXT("_back")), ItTex.name, ItTex.width / 2, ItTex.height, Back);
+				return;
+			}
+
+			FTextureLevels Levels;
+			for (int32 Level = 0; Level < NumLevels && GetLevel(Level).Num() > 0; Level++)
+			{
+				Levels.Add(GetLevel(Level));
+			}
+			AddTexture(ItTex.name, ItTex.name, ItTex.width, ItTex.height, Levels);
+
+			// The first frame of an animation keeps its own texture, bound to "Color"; all frames also go into an array,
+			// which the generated animated parent samples.
+			// A level is kept only if every frame has it, at the first frame's size.
+			if (!bAnimated)
+			{
+				return;
+			}
+
+			FTextureLevels FrameLevels;
+			for (int32 Level = 0; Level < NumLevels; Level++)
+			{
+				TArray<uint8> Data;
+				for (const int32 FrameIndex : Frames)
+				{
+					const auto& FrameTex = Model.textures[FrameIndex];
+					const TArray<uint8>& FrameLevel = Level == 0 ? FrameTex.mip0 : FrameTex.lowerMips[Level - 1];
+					if (FrameTex.width != ItTex.width || FrameTex.height != ItTex.height || FrameLevel.Num() == 0)
+					{
+						break;
+					}
+					Data.Append(FrameLevel);
+				}
+				if (Data.Num() != GetLevel(Level).Num() * Frames.Num() || Data.Num() == 0)
+				{
+					break;
+				}
+				FrameLevels.Add(MoveTemp(Data));
+			}
+			AddTexture(ItTex.name, ItTex.name, ItTex.width, ItTex.height, FrameLevels, Frames.Num());
+		});
+
+		for (TArray<FPreparedTexture, TInlineAllocator<2>>& Prepared : PerTexture)
+		{
+			for (FPreparedTexture& Texture : Prepared)
+			{
+				OutTextures.Add(MoveTemp(Texture));
+			}
+		}
+
+		return true;
+	}
+
+	// Expands rows of 256 palette indices into the BGRA8 lookup texture of palette indexed materials.
+	void PreparePaletteLookupTexture(const FString& AssetName, const uint8* Indices, int32 NumRows, const QuakeCommon::FPaletteLUT& LUT, FPreparedTexture& Out)
+	{
+		Out.AssetName = AssetName;
+		Out.Width = 256;
+		Out.Height = NumRows;
+		Out.Pixels.SetNumUninitialized(256 * NumRows * 4);
+		QuakeCommon::ExpandPaletteIndices(Indices, 256 * NumRows, LUT, Out.Pixels.GetData());
+		SetContentHash(Out);
+	}
+
+	// The palette and colormap shared by the material instances of palette indexed textures. Index 255 is transparent
+	// in both, which the generated parents use only for masked ({) textures.
+	bool PreparePaletteLookupTextures(FPreparedImport& Prepared)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::PreparePaletteLookupTextures);
+
+		TArray<QuakeCommon::QColor> QuakePalette;
+		if (!QuakeCommon::LoadPalette(QuakePalette))
+		{
+			UE_LOG(LogQuakeImportRunner, Error, TEXT("Palette.lmp not found."));
+			return false;
+		}
+		QuakeCommon::FPaletteLUT MaskedLUT;
+		QuakeCommon::BuildPaletteLUT(QuakePalette, QuakeCommon::EPaletteLUTVariant::Masked, MaskedLUT);
+
+		uint8 Identity[256];
+		for (int32 Index = 0; Index < 256; Index++)
+		{
+			Identity[Index] = uint8(Index);
+		}
+		PreparePaletteLookupTexture(TEXT("QuakePalette"), Identity, 1, MaskedLUT, Prepared.PaletteTexture);
+
+		TArray<uint8> Colormap;
+		if (QuakeCommon::LoadColormap(Colormap))
+		{
+			PreparePaletteLookupTexture(TEXT("QuakeColormap"), Colormap.GetData(), QuakeCommon::ColormapLevels, MaskedLUT, Prepared.ColormapTexture);
+		}
+		else
+		{
+			UE_LOG(LogQuakeImportRunner, Warning, TEXT("colormap.lmp not found, palette indexed materials get no Colormap texture."));
+		}
+
+		Prepared.bPaletteIndexed = true;
+		return true;
+	}
+
+	UMaterialInterface* SelectParentMaterial(const FString& TextureName, bool bHasPaletteAlpha, const FParentMaterials& Parents)
+	{
+		if (bHasPaletteAlpha && Parents.Masked)
+		{
+			return Parents.Masked;
+		}
+		if (Parents.Trigger && TextureName.StartsWith(TEXT("trigger"), ESearchCase::IgnoreCase))
+		{
+			return Parents.Trigger;
+		}
+		if (TextureName.StartsWith(TEXT("sky")))
+		{
+			return Parents.Sky;
+		}
+		if (TextureName.StartsWith(TEXT("*")))
+		{
+			return Parents.Liquid;
+		}
+		return IsTransparentSurfaceName(TextureName) ? Parents.Liquid : Parents.Solid;
+	}
+
+	static const TCHAR* TextureContentHashKey = TEXT("QuakeImport.ContentHash");
+	static const TCHAR* TextureSourceMapKey = TEXT("QuakeImport.SourceMap");
+
+	UTexture* FindExistingTexture(const FString& TexturesPath, const FString& TexAssetName)
+	{
+		const FString ObjectPath = TexturesPath / TexAssetName + TEXT(".") + TexAssetName;
+		return LoadObject<UTexture>(nullptr, *ObjectPath, nullptr, LOAD_Quiet | LOAD_NoWarn);
+	}
+
+	FString GetTextureMetaData(UTexture& Texture, const TCHAR* Key)
+	{
+		UMetaData* MetaData = Texture.GetOutermost()->GetMetaData();
+		return MetaData ? MetaData->GetValue(&Texture, Key) : FString();
+	}
+
+	// The Textures folder is shared by every map imported next to this one. A texture with matching pixels is reused
+	// without touching its package. One with different pixels is regenerated if this map created it (or it predates
+	// the hash), otherwise another map embeds different pixels under the same name and this map gets its own copy,
+	// suffixed with its hash. Animations are UTexture2DArray assets prefixed TA_ instead of T_.
+	UTexture* CommitTexture(const FPreparedImport& Prepared, const FPreparedTexture& PreparedTex, bool bOverwrite)
+	{
+		const bool bArray = PreparedTex.NumSlices > 1;
+		const FString Prefix = bArray ? TEXT("TA_") : TEXT("T_");
+		FString AssetName = PreparedTex.AssetName;
+		UTexture* Existing = FindExistingTexture(Prepared.TexturesPath, Prefix + AssetName);
+		if (Existing)
+		{
+			const FString ExistingHash = GetTextureMetaData(*Existing, TextureContentHashKey);
+			const FString Owner = GetTextureMetaData(*Existing, TextureSourceMapKey);
+			if (ExistingHash == PreparedTex.ContentHash)
+			{
+				return Existing;
+			}
+			if (!ExistingHash.IsEmpty() && !Owner.IsEmpty() && Owner != Prepared.MapName)
+			{
+				AssetName = FString::Printf(TEXT("%s_%s"), *PreparedTex.AssetName, *PreparedTex.ContentHash.Left(8));
+				UE_LOG(LogQuakeImportRunner, Warning, TEXT("%s: texture %s differs from the one %s imported, using %s%s"),
+					*Prepared.MapName, *PreparedTex.AssetName, *Owner, *Prefix, *AssetName);
+
+				Existing = FindExistingTexture(Prepared.TexturesPath, Prefix + AssetName);
+				if (Existing && GetTextureMetaData(*Existing, TextureContentHashKey) == PreparedTex.ContentHash)
+				{
+					return Existing;
+				}
+			}
+		}
+
+		UPackage* TexPkg = CreateAssetPackage(Prepared.TexturesPath / (Prefix + AssetName));
+		if (!TexPkg)
+		{
+			return nullptr;
+		}
+		UTexture* Texture = nullptr;
+		if (bArray)
+		{
+			Texture = QuakeCommon::CreateOrUpdatePaletteUTexture2DArrayFromBGRA(AssetName, PreparedTex.Width, PreparedTex.Height,
+				PreparedTex.NumSlices, PreparedTex.Pixels, *TexPkg, bOverwrite, PreparedTex.NumMips, PreparedTex.Format);
+		}
+		else
+		{
+			Texture = QuakeCommon::CreateOrUpdatePaletteUTexture2DFromBGRA(AssetName, PreparedTex.Width, PreparedTex.Height,
+				PreparedTex.Pixels, *TexPkg, bOverwrite, PreparedTex.NumMips, PreparedTex.Format);
+		}
+
+		// An existing texture kept as is (bOverwrite off) keeps its hash too.
+		UMetaData* MetaData = TexPkg->GetMetaData();
+		if (Texture && MetaData && (!Existing || bOverwrite))
+		{
+			MetaData->SetValue(Texture, TextureContentHashKey, *PreparedTex.ContentHash);
+			MetaData->SetValue(Texture, TextureSourceMapKey, *Prepared.MapName);
+		}
+		return Texture;
+	}
+
+	// Generated parents (QuakeCommon::GetOrCreateSurfaceMaterial) of the surfaces the configured parents cannot draw.
+	// They are created next to the maps, with MPC_QuakeLightStyles, and shared by every map imported there.
+	struct FSurfaceParents
+	{
+		FString FolderPath;
+		// Lightmap page textures, style layers included, the defaults of the lightmap parameters.
+		TArray<UTexture2D*> LightmapLayers;
+		bool bLightStyles = false;
+		UMaterialParameterCollection* LightStyles = nullptr;
+		// Shared palette row of palette indexed textures.
+		UTexture2D* PaletteLUT = nullptr;
+		TMap<FString, UMaterial*> Materials;
+	};
+
+	// Sky, liquids and triggers keep their configured parents. Returns false when the configured parent can draw the
+	// surface as well.
+	bool GetSurfaceMaterialFeatures(const FPreparedTexture& PreparedTex, bool bAnimated, const FSurfaceParents& SurfaceParents, QuakeCommon::FSurfaceMaterialFeatures& OutFeatures)
+	{
+		if (HasDedicatedParentMaterial(PreparedTex.MaterialTextureName))
+		{
+			return false;
+		}
+
+		OutFeatures.bMasked = PreparedTex.bHasPaletteAlpha;
+		OutFeatures.bAnimated = bAnimated;
+		OutFeatures.bPaletteIndexed = PreparedTex.Format == QuakeCommon::EPaletteTextureFormat::Indexed && SurfaceParents.PaletteLUT;
+		OutFeatures.bFullbrightInAlpha = PreparedTex.bFullbrightInAlpha;
+		OutFeatures.bLightmap = SurfaceParents.LightmapLayers.Num() > 0;
+		OutFeatures.bLightStyles = OutFeatures.bLightmap && SurfaceParents.bLightStyles;
+		OutFeatures.NumStyleLayers = SurfaceParents.LightmapLayers.Num();
+		return OutFeatures.bAnimated || OutFeatures.bPaletteIndexed || OutFeatures.bFullbrightInAlpha || OutFeatures.bLightStyles;
+	}
+
+	UMaterialInterface* GetOrCreateSurfaceParent(FSurfaceParents& SurfaceParents, const QuakeCommon::FSurfaceMaterialFeatures& Features, UTexture2D& Color, UTexture2DArray* Frames)
+	{
+		const FString MaterialName = QuakeCommon::GetSurfaceMaterialName(Features);
+		if (UMaterial** Found = SurfaceParents.Materials.Find(MaterialName))
+		{
+			return *Found;
+		}
+
+		QuakeCommon::FSurfaceMaterialDefaults Defaults;
+		Defaults.Color = &Color;
+		Defaults.ColorArray = Frames;
+		Defaults.PaletteLUT = SurfaceParents.PaletteLUT;
+		Defaults.LightmapLayers = SurfaceParents.LightmapLayers;
+		Defaults.LightStyles = SurfaceParents.LightStyles;
+		UPackage* Package = CreateAssetPackage(SurfaceParents.FolderPath / MaterialName);
+		UMaterial* Material = Package ? QuakeCommon::GetOrCreateSurfaceMaterial(Features, Defaults, *Package) : nullptr;
+		if (!Material)
+		{
+			UE_LOG(LogQuakeImportRunner, Warning, TEXT("Failed to create parent material %s, using the configured parent."), *MaterialName);
+		}
+		SurfaceParents.Materials.Add(MaterialName, Material);
+		return Material;
+	}
+
+	// Creates one texture per progress frame, then the material instances. Returns false if cancelled.
+	bool CommitMaterials(const FPreparedImport& Prepared, bool bOverwriteMaterialsAndTextures, const FParentMaterials& Parents, FSurfaceParents& SurfaceParents,
+		FScopedSlowTask& SlowTask, TMap<FString, UMaterialInterface*>& OutMaterialsByName, TSet<FString>& OutMaskedTextureNames)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::CommitMaterials);
+
+		UTexture2D* PaletteTexture = nullptr;
+		UTexture2D* ColormapTexture = nullptr;
+		if (Prepared.bPaletteIndexed)
+		{
+			PaletteTexture = Cast<UTexture2D>(CommitTexture(Prepared, Prepared.PaletteTexture, bOverwriteMaterialsAndTextures));
+			SurfaceParents.PaletteLUT = PaletteTexture;
+			if (!Prepared.ColormapTexture.Pixels.IsEmpty())
+			{
+				ColormapTexture = Cast<UTexture2D>(CommitTexture(Prepared, Prepared.ColormapTexture, bOverwriteMaterialsAndTextures));
+			}
+		}
+
+		// Every texture exists before the instances, so the first frame of an animation finds its frames array.
+		TArray<UTexture*> CommittedTextures;
+		TMap<FString, int32> FramesByName;
+		CommittedTextures.Reserve(Prepared.Textures.Num());
+		for (const FPreparedTexture& PreparedTex : Prepared.Textures)
+		{
+			if (SlowTask.ShouldCancel())
+			{
+				return false;
+			}
+			SlowTask.EnterProgressFrame(1.f, FText::Format(LOCTEXT("CreatingTexture", "Creating texture {0}"), FText::FromString(PreparedTex.AssetName)));
+
+			UTexture* CommittedTexture = CommitTexture(Prepared, PreparedTex, bOverwriteMaterialsAndTextures);
+			if (Cast<UTexture2DArray>(CommittedTexture) && !PreparedTex.MaterialTextureName.IsEmpty())
+			{
+				FramesByName.Add(PreparedTex.MaterialTextureName, CommittedTextures.Num());
+			}
+			CommittedTextures.Add(CommittedTexture);
+		}
+
+		for (int32 TextureIndex = 0; TextureIndex < Prepared.Textures.Num(); TextureIndex++)
+		{
+			const FPreparedTexture& PreparedTex = Prepared.Textures[TextureIndex];
+			UTexture2D* Texture = Cast<UTexture2D>(CommittedTextures[TextureIndex]);
+			if (!Texture || PreparedTex.MaterialTextureName.IsEmpty())
+			{
+				continue;
+			}
+
+			const FString& TextureName = PreparedTex.MaterialTextureName;
+			if (PreparedTex.bHasPaletteAlpha)
+			{
+				OutMaskedTextureNames.Add(TextureName);
+			}
+
+			const int32* FramesIndex = FramesByName.Find(TextureName);
+			UTexture2DArray* Frames = FramesIndex ? Cast<UTexture2DArray>(CommittedTextures[*FramesIndex]) : nullptr;
+
+			UMaterialInterface* ParentMat = nullptr;
+			QuakeCommon::FSurfaceMaterialFeatures Features;
+			if (GetSurfaceMaterialFeatures(PreparedTex, Frames != nullptr, SurfaceParents, Features))
+			{
+				ParentMat = GetOrCreateSurfaceParent(SurfaceParents, Features, *Texture, Frames);
+			}
+			if (!ParentMat)
+			{
+				ParentMat = SelectParentMaterial(TextureName, PreparedTex.bHasPaletteAlpha, Parents);
+			}
+			if (!ParentMat)
+			{
+				continue;
+			}
+
+			const FString InstanceName = TEXT("MI_") + SanitizeSurfaceNameForAsset(TextureName);
+			UPackage* MatPkg = CreateAssetPackage(Prepared.MaterialsPath / InstanceName);
+			UMaterialInstanceConstant* MI = QuakeCommon::GetOrCreateMaterialInstance(
+				InstanceName, *MatPkg, (*ParentMat), *Texture, bOverwriteMaterialsAndTextures);
+			if (MI)
+			{
+				if (Frames)
+				{
+					QuakeCommon::SetAnimatedTextureParameters(*MI, *Frames, Prepared.Textures[*FramesIndex].NumSlices, bOverwriteMaterialsAndTextures);
+				}
+				const bool bIndexed = PreparedTex.Format == QuakeCommon::EPaletteTextureFormat::Indexed;
+				QuakeCommon::SetPaletteLookupParameters(*MI, bIndexed ? PaletteTexture : nullptr, ColormapTexture, bOverwriteMaterialsAndTextures);
+				QuakeCommon::SetFullbrightInAlphaParameter(*MI, PreparedTex.bFullbrightInAlpha, bOverwriteMaterialsAndTextures);
+				OutMaterialsByName.Add(TextureName, MI);
+			}
+		}
+
+		return true;
+	}
+
+	template<typename OptionsType>
+	bsputils::FLightmapAtlasSettings MakeLightmapAtlasSettings(const OptionsType& Options)
+	{
+		bsputils::FLightmapAtlasSettings Settings;
+		Settings.bLightStyles = Options.bImportLightStyles;
+		Settings.bMips = Options.bLightmapMips;
+		switch (Options.LightmapEncoding)
+		{
+		case ELightmapAtlasEncoding::BC1:
+			Settings.Encoding = bsputils::ELightmapEncoding::BC1;
+			break;
+		case ELightmapAtlasEncoding::BC7:
+			Settings.Encoding = bsputils::ELightmapEncoding::BC7;
+			break;
+		default:
+			Settings.Encoding = bsputils::ELightmapEncoding::BGRA8;
+			break;
+		}
+		return Settings;
+	}
+
+	// Per-chunk atlases give every cluster of LightmapChunkClusterSize consecutive chunk plans pages of its own,
+	// so they are packed once the plans exist.
+	template<typename OptionsType>
+	void PackPreparedLightmapAtlas(FPreparedImport& Prepared, const OptionsType& Options)
+	{
+		if (!Options.bPerChunkLightmapAtlas)
+		{
+			Prepared.bHasLightmapAtlas = bsputils::PackLightmapAtlas(*Prepared.Model, Options.LitFilePath, MakeLightmapAtlasSettings(Options), Prepared.LightmapAtlas);
+			return;
+		}
+
+		TArray<bsputils::FLightmapFaceGroup> Groups;
+		const int32 ClusterSize = FMath::Max(Options.LightmapChunkClusterSize, 1);
+		for (int32 First = 0; First < Prepared.ChunkPlans.Num(); First += ClusterSize)
+		{
+			bsputils::FLightmapFaceGroup& Group = Groups.AddDefaulted_GetRef();
+			Group.Name = Prepared.ChunkPlans[First].MeshName;
+			Group.Name.RemoveFromStart(TEXT("SM_"));
+			const int32 End = FMath::Min(First + ClusterSize, Prepared.ChunkPlans.Num());
+			for (int32 PlanIndex = First; PlanIndex < End; PlanIndex++)
+			{
+				Group.FaceIndices.Append(Prepared.ChunkPlans[PlanIndex].FaceIndices);
+			}
+		}
+		Prepared.bHasLightmapAtlas = bsputils::PackLightmapAtlas(*Prepared.Model, Options.LitFilePath, MakeLightmapAtlasSettings(Options), Prepared.LightmapAtlas, &Groups);
+	}
+
+	// Loads the luxels baked into vertex colours. Tessellated faces grow with their lightmap, so the plan
+	// estimates that bound the assembly batches are redone.
+	template<typename OptionsType>
+	void PrepareVertexLighting(FPreparedImport& Prepared, const OptionsType& Options)
+	{
+		if (!Options.bBakeVertexLighting)
+		{
+			return;
+		}
+
+		bsputils::LoadVertexLighting(*Prepared.Model, Options.LitFilePath, Options.bTessellateVertexLighting, Prepared.VertexLighting);
+		Prepared.bHasVertexLighting = true;
+		if (Options.bTessellateVertexLighting)
+		{
+			for (bsputils::FChunkPlan& Plan : Prepared.ChunkPlans)
+			{
+				Plan.EstimatedBuildBytes = bsputils::EstimateChunkBuildBytes(*Prepared.Model, Plan.FaceIndices, true);
+			}
+		}
+	}
+
+	// PageLayers holds the page texture followed by its style layer textures.
+	void SetLightmapParameter(UMaterialInstanceConstant& MI, const TArray<UTexture2D*>& PageLayers)
+	{
+		MI.PreEditChange(nullptr);
+		MI.SetTextureParameterValueEditorOnly(FMaterialParameterInfo(TEXT("Lightmap")), PageLayers[0]);
+		for (int32 Layer = 1; Layer < PageLayers.Num(); Layer++)
+		{
+			MI.SetTextureParameterValueEditorOnly(FMaterialParameterInfo(*FString::Printf(TEXT("LightmapStyle%d"), Layer)), PageLayers[Layer]);
+		}
+		MI.MarkPackageDirty();
+		MI.PostEditChange();
+	}
+
+	// Intensity of every Quake lightstyle, four per vector: LightStyles<k> holds styles 4k to 4k+3 in RGBA.
+	// Created once next to the maps with all styles at full brightness and never overwritten, so game code
+	// animating it (or edits made to it) survive reimports.
+	UMaterialParameterCollection* GetOrCreateLightStyleCollection(const FString& FolderPath)
+	{
+		static const TCHAR* CollectionName = TEXT("MPC_QuakeLightStyles");
+		static constexpr int32 NumStyleVectors = 16;
+
+		UPackage* Package = CreateAssetPackage(FolderPath / CollectionName);
+		if (!Package)
+		{
+			return nullptr;
+		}
+		if (UMaterialParameterCollection* Existing = QuakeCommon::CheckIfAssetExist<UMaterialParameterCollection>(CollectionName, *Package))
+		{
+			return Existing;
+		}
+
+		UMaterialParameterCollection* Collection = NewObject<UMaterialParameterCollection>(Package, FName(CollectionName), RF_Public | RF_Standalone);
+		if (!Collection)
+		{
+			return nullptr;
+		}
+
+		Collection->PreEditChange(nullptr);
+		for (int32 Index = 0; Index < NumStyleVectors; Index++)
+		{
+			FCollectionVectorParameter& Parameter = Collection->VectorParameters.AddDefaulted_GetRef();
+			Parameter.ParameterName = FName(*FString::Printf(TEXT("LightStyles%d"), Index));
+			Parameter.DefaultValue = FLinearColor(1.f, 1.f, 1.f, 1.f);
+		}
+		FAssetRegistryModule::AssetCreated(Collection);
+		Collection->MarkPackageDirty();
+		Collection->PostEditChange();
+		return Collection;
+	}
+
+	// Creates the atlas page textures ahead of the material instances: the generated surface parents take the first
+	// page as the default of their lightmap parameters. OutPageTextures holds the page texture followed by its style
+	// layer textures for every page, empty for pages that failed to load.
+	//
+	// With light styles, lit surfaces get a generated parent weighting each style layer by the MPC_QuakeLightStyles
+	// entry of the style number stored in the matching vertex colour channel.
+	void CommitLightmapTextures(FPreparedImport& Prepared, bool bOverwriteMaterialsAndTextures, TArray<TArray<UTexture2D*>>& OutPageTextures, FSurfaceParents& OutSurfaceParents)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::CommitLightmapTextures);
+
+		if (!Prepared.bHasLightmapAtlas)
+		{
+			return;
+		}
+
+		bsputils::FLightmapAtlas& Atlas = Prepared.LightmapAtlas;
+		if (!bsputils::CreateLightmapAtlasTexture(Prepared.LightmapsPath, Prepared.MapName, bOverwriteMaterialsAndTextures, Atlas))
+		{
+			UE_LOG(LogQuakeImportRunner, Warning, TEXT("%s: failed to create the lightmap atlas texture."), *Prepared.MapName);
+			return;
+		}
+
+		for (const bsputils::FLightmapAtlasPage& Page : Atlas.Pages)
+		{
+			TArray<UTexture2D*>& Layers = OutPageTextures.AddDefaulted_GetRef();
+			Layers.Add(LoadObject<UTexture2D>(nullptr, *Page.TextureObjectPath, nullptr, LOAD_Quiet | LOAD_NoWarn));
+			for (const bsputils::FLightmapAtlasLayer& Layer : Page.StyleLayers)
+			{
+				Layers.Add(LoadObject<UTexture2D>(nullptr, *Layer.TextureObjectPath, nullptr, LOAD_Quiet | LOAD_NoWarn));
+			}
+			if (Layers.Contains(nullptr))
+			{
+				Layers.Reset();
+			}
+			else if (OutSurfaceParents.LightmapLayers.Num() == 0)
+			{
+				OutSurfaceParents.LightmapLayers = Layers;
+			}
+		}
+
+		if (Atlas.Settings.bLightStyles && Prepared.bHasVertexLighting)
 		{
-			UE_LOG(LogQuakeImportRunner, Error, TEXT("Failed to parse bsp file: %s"), *Out.AbsPath);
-			return false;
+			UE_LOG(LogQuakeImportRunner, Warning, TEXT("%s: vertex colours hold the baked lighting instead of the light style numbers, light styles are not weighted."), *Prepared.MapName);
+		}
+		else if (Atlas.Settings.bLightStyles)
+		{
+			OutSurfaceParents.LightStyles = GetOrCreateLightStyleCollection(OutSurfaceParents.FolderPath);
+			OutSurfaceParents.bLightStyles = OutSurfaceParents.LightStyles != nullptr;
 		}
-
-		return true;
 	}
 
-	bool EnsureMaterials(const bsputils::bspformat29::Bsp_29& Model, const FString& TexturesPath,
-		const FString& MaterialsPath, bool bOverwriteMaterialsAndTextures, UMaterialInterface* BspParentOverride,
-		UMaterialInterface* WaterParentOverride, UMaterialInterface* SkyParentOverride,
-		UMaterialInterface* TriggerParentOverride, UMaterialInterface* MaskedParentOverride,
-		TMap<FString, UMaterialInterface*>& OutMaterialsByName, TSet<FString>& OutMaskedTextureNames)
+	// Page 0 is assigned to the texture material instances themselves. Every texture with faces on a further page
+	// gets a child instance per page (MI_<name>_LM<page>) that only overrides the lightmap, registered in
+	// MaterialsByName under bsputils::GetLightmapPageMaterialName. Per-chunk atlases leave the texture material
+	// instances alone and give every page, the first one included, child instances named after the page group.
+	void CommitLightmapAtlas(const FPreparedImport& Prepared, bool bOverwriteMaterialsAndTextures, const TArray<TArray<UTexture2D*>>& PageTextures, TMap<FString, UMaterialInterface*>& MaterialsByName)
 	{
-		TArray<QuakeCommon::QColor> QuakePalette;
-		if (!QuakeCommon::LoadPalette(QuakePalette))
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::CommitLightmapAtlas);
+
+		if (PageTextures.Num() == 0)
 		{
-			UE_LOG(LogQuakeImportRunner, Error, TEXT("Palette.lmp not found."));
-			return false;
+			return;
 		}
 
-		UMaterialInterface* SurfaceParent = BspParentOverride;
-		UMaterialInterface* TransparentParent = WaterParentOverride;
-		UMaterialInterface* SkyParent = SkyParentOverride;
-		UMaterialInterface* MaskedParent = MaskedParentOverride;
+		const bsputils::FLightmapAtlas& Atlas = Prepared.LightmapAtlas;
+		const bool bPerChunkPages = !Atlas.Pages[0].GroupName.IsEmpty();
+		if (PageTextures[0].Num() == 0 && !bPerChunkPages)
+		{
+			return;
+		}
 
-		auto CreateTexturePackageAndTexture = [&](const FString& TexOriginalName, int32 W, int32 H,
-			const TArray<uint8>& Src, bool& bOutHasPaletteAlpha) -> UTexture2D*
+		if (!bPerChunkPages)
 		{
-			bOutHasPaletteAlpha = false;
-			const FString SafeBaseName = SanitizeSurfaceNameForAsset(TexOriginalName);
-			const FString TexAssetName = TEXT("T_") + SafeBaseName;
-			UPackage* TexPkg = CreateAssetPackage(TexturesPath / TexAssetName);
-			for (const uint8& It : Src)
+			for (const auto& It : MaterialsByName)
 			{
-				if (It == 255)
+				if (UMaterialInstanceConstant* MI = Cast<UMaterialInstanceConstant>(It.Value))
 				{
-					bOutHasPaletteAlpha = true;
-					break;
+					SetLightmapParameter(*MI, PageTextures[0]);
 				}
 			}
-			return QuakeCommon::CreateOrUpdateUTexture2D(SafeBaseName, W, H, Src, *TexPkg, QuakePalette, bOverwriteMaterialsAndTextures, true);
-		};
 
-		auto CreateMaterialForTextureName = [&](const FString& TextureName, const FString& SafeTextureName,
-		                                        UTexture2D* Texture, bool bHasPaletteAlpha) -> void
-		{
-			if (!Texture)
+			if (Atlas.Pages.Num() == 1)
 			{
 				return;
 			}
+		}
 
-			if (bHasPaletteAlpha)
+		const bsputils::bspformat29::Bsp_29& Model = *Prepared.Model;
+		TSet<TPair<FString, int32>> TexturePages;
+		for (int32 FaceIndex = 0; FaceIndex < Atlas.FaceToAtlas.Num(); FaceIndex++)
+		{
+			const int32 Page = Atlas.FaceToAtlas[FaceIndex].Page;
+			if (Page > 0 || (bPerChunkPages && Page != INDEX_NONE))
 			{
-				OutMaskedTextureNames.Add(TextureName);
+				const int32 TexInfo = Model.faces[FaceIndex].texinfo;
+				TexturePages.Add(TPair<FString, int32>(Model.textures[Model.texinfos[TexInfo].miptex].name, Page));
 			}
+		}
 
-			UMaterialInterface* ParentMat = nullptr;
-			if (bHasPaletteAlpha && MaskedParent)
-			{
-				ParentMat = MaskedParent;
-			}
-			else if (TriggerParentOverride && TextureName.StartsWith(TEXT("trigger"), ESearchCase::IgnoreCase))
-			{
-				ParentMat = TriggerParentOverride;
-			}
-			else if (TextureName.StartsWith(TEXT("sky")))
+		for (const TPair<FString, int32>& TexturePage : TexturePages)
+		{
+			UMaterialInstanceConstant* BaseMI = Cast<UMaterialInstanceConstant>(MaterialsByName.FindRef(TexturePage.Key));
+			const TArray<UTexture2D*>& PageLayers = PageTextures[TexturePage.Value];
+			UTexture* Albedo = nullptr;
+			if (!BaseMI || PageLayers.Num() == 0 || !BaseMI->GetTextureParameterValue(FMaterialParameterInfo(TEXT("Color")), Albedo) || !Cast<UTexture2D>(Albedo))
 			{
-				ParentMat = SkyParent;
+				continue;
 			}
-			else if (TextureName.StartsWith(TEXT("*")))
+
+			const FString& GroupName = Atlas.Pages[TexturePage.Value].GroupName;
+			const FString InstanceName = GroupName.IsEmpty()
+				? FString::Printf(TEXT("MI_%s_LM%d"), *SanitizeSurfaceNameForAsset(TexturePage.Key), TexturePage.Value)
+				: FString::Printf(TEXT("MI_%s_LM_%s"), *SanitizeSurfaceNameForAsset(TexturePage.Key), *GroupName);
+			UPackage* MatPkg = CreateAssetPackage(Prepared.MaterialsPath / InstanceName);
+			UMaterialInstanceConstant* PageMI = QuakeCommon::GetOrCreateMaterialInstance(InstanceName, *MatPkg, *BaseMI, *Cast<UTexture2D>(Albedo), bOverwriteMaterialsAndTextures);
+			if (PageMI)
 			{
-				ParentMat = TransparentParent;
+				SetLightmapParameter(*PageMI, PageLayers);
+				MaterialsByName.Add(bsputils::GetLightmapPageMaterialName(TexturePage.Key, TexturePage.Value), PageMI);
 			}
-			else
+		}
+
+		UE_LOG(LogQuakeImportRunner, Log, TEXT("%s: lightmaps %s %d atlas pages"), *Prepared.MapName, bPerChunkPages ? TEXT("split per chunk into") : TEXT("spilled into"), Atlas.Pages.Num());
+	}
+
+	const TCHAR* GetChunkKindName(const FPreparedImport& Prepared, int32 ChunkIndex, const bsputils::FAssembledChunk& Chunk)
+	{
+		if (Prepared.TriggerChunkIndices.Contains(ChunkIndex))
+		{
+			return TEXT("Trigger");
+		}
+		switch (Chunk.Kind)
+		{
+		case bsputils::EChunkSurfaceKind::Liquid:
+			return TEXT("Liquid");
+		case bsputils::EChunkSurfaceKind::Sky:
+			return TEXT("Sky");
+		default:
+			return TEXT("Solid");
+		}
+	}
+
+	FQuakeImportChunkReport MakeChunkReport(const FPreparedImport& Prepared, int32 ChunkIndex, const bsputils::FAssembledChunk& Chunk, const FName& CollisionProfile, bool bRebuilt)
+	{
+		FQuakeImportChunkReport Out;
+		Out.MeshName = Chunk.MeshName;
+		Out.Kind = GetChunkKindName(Prepared, ChunkIndex, Chunk);
+		Out.Faces = Chunk.Build.Faces.Num();
+		Out.Triangles = Chunk.Build.RawMesh.WedgeIndices.Num() / 3;
+		Out.Vertices = Chunk.Build.RawMesh.VertexPositions.Num();
+		Out.Sections = Chunk.Build.SlotToTextureId.Num();
+		Out.CollisionTriangles = CollisionProfile == UCollisionProfile::NoCollision_ProfileName ? 0 : Out.Triangles;
+		Out.LightmapSize = Chunk.LightmapSize;
+		Out.bRebuilt = bRebuilt;
+		return Out;
+	}
+
+	// Fills the report header and totals from the prepared data, the commit timings and the chunk rows already added.
+	void FinishImportReport(const FPreparedImport& Prepared, const TCHAR* ImportKind, FImportResult& InOutResult)
+	{
+		FQuakeImportReport& Report = InOutResult.Report;
+		Report.MapName = Prepared.MapName;
+		Report.ImportKind = ImportKind;
+		Report.Timestamp = FDateTime::Now();
+		Report.bCancelled = InOutResult.bCancelled;
+
+		Report.LoadSeconds = Prepared.StageSeconds[int32(EPrepareStage::Load)];
+		Report.PrepareTexturesSeconds = Prepared.StageSeconds[int32(EPrepareStage::Textures)];
+		Report.PrepareAtlasSeconds = Prepared.StageSeconds[int32(EPrepareStage::Atlas)];
+		Report.GeometrySeconds = Prepared.StageSeconds[int32(EPrepareStage::Geometry)];
+		Report.CommitTexturesSeconds = InOutResult.TexturesSeconds;
+		Report.CommitLightmapSeconds = InOutResult.LightmapSeconds;
+		Report.CommitAssembleSeconds = InOutResult.AssembleSeconds;
+		Report.CommitMeshesSeconds = InOutResult.MeshesSeconds;
+		Report.TotalSeconds = Report.LoadSeconds + Report.PrepareTexturesSeconds + Report.PrepareAtlasSeconds + Report.GeometrySeconds
+			+ Report.CommitTexturesSeconds + Report.CommitLightmapSeconds + Report.CommitAssembleSeconds + Report.CommitMeshesSeconds;
+
+		Report.NumChunks = Report.Chunks.Num();
+		for (const FQuakeImportChunkReport& Chunk : Report.Chunks)
+		{
+			Report.NumRebuilt += Chunk.bRebuilt ? 1 : 0;
+			Report.NumFaces += Chunk.Faces;
+			Report.NumTriangles += Chunk.Triangles;
+			Report.NumVertices += Chunk.Vertices;
+			Report.NumSections += Chunk.Sections;
+			Report.NumCollisionTriangles += Chunk.CollisionTriangles;
+		}
+
+		Report.NumTextures = Prepared.Textures.Num();
+		for (const FPreparedTexture& Texture : Prepared.Textures)
+		{
+			Report.TextureBytes += int64(Texture.Width) * Texture.Height * Texture.NumSlices * QuakeCommon::GetBytesPerTexel(Texture.Format);
+		}
+
+		if (Prepared.bHasLightmapAtlas)
+		{
+			const bsputils::FLightmapAtlas& Atlas = Prepared.LightmapAtlas;
+			int64 AtlasTexels = 0;
+			for (const bsputils::FLightmapAtlasPage& Page : Atlas.Pages)
 			{
-				const bool bTransparent = IsTransparentSurfaceName(TextureName);
-				ParentMat = bTransparent ? TransparentParent : SurfaceParent;
+				AtlasTexels += int64(Page.Width) * Page.Height;
 			}
-			if (!ParentMat)
+			Report.NumLightmapAtlasPages = Atlas.Pages.Num();
+			Report.LightmapAtlasWidth = Atlas.Pages.Num() > 0 ? Atlas.Pages[0].Width : 0;
+			Report.LightmapAtlasHeight = Atlas.Pages.Num() > 0 ? Atlas.Pages[0].Height : 0;
+			Report.LightmapAtlasBytes = bsputils::GetLightmapAtlasBytes(Atlas);
+			Report.TextureBytes += Report.LightmapAtlasBytes;
+
+			// Faces sharing a rect count once.
+			int64 UsedTexels = 0;
+			TSet<FIntVector> UsedRects;
+			for (const bsputils::FLightmapAtlasFace& Face : Atlas.FaceToAtlas)
 			{
-				return;
+				bool bAlreadyCounted = Face.Page == INDEX_NONE;
+				if (!bAlreadyCounted)
+				{
+					UsedRects.Add(FIntVector(Face.Page, Face.X, Face.Y), &bAlreadyCounted);
+				}
+				UsedTexels += bAlreadyCounted ? 0 : int64(Face.W) * Face.H;
 			}
+			Report.LightmapAtlasOccupancy = AtlasTexels > 0 ? float(double(UsedTexels) / double(AtlasTexels)) : 0.f;
+		}
+	}
 
-			const FString InstanceName = TEXT("MI_") + SafeTextureName;
-			UPackage* MatPkg = CreateAssetPackage(MaterialsPath / InstanceName);
-			UMaterialInstanceConstant* MI = QuakeCommon::GetOrCreateMaterialInstance(
-				InstanceName, *MatPkg, (*ParentMat), *Texture, bOverwriteMaterialsAndTextures);
-			if (MI)
-			{
-				OutMaterialsByName.Add(TextureName, MI);
-			}
-		};
+	// Commits textures, materials and lightmap, then builds every chunk. ResolveChunk picks the collision profile
+	// and result list of a chunk. Meshes are built one per progress frame so cancelling never leaves one half built.
+	// OutResult.Report gets one row per built chunk, cancelled or not.
+	template<typename ResolveChunkType>
+	bool CommitPreparedImport(FPreparedImport& Prepared, const TCHAR* ImportKind, int32 MemoryBudgetMB, bool bOverwriteMaterialsAndTextures, bool bImportLightmaps, const FParentMaterials& Parents,
+		const FName& MaskedCollisionProfile, ResolveChunkType&& ResolveChunk, FImportResult& OutResult)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::CommitPreparedImport);
+
+		check(IsInGameThread());
+
+		FScopedSlowTask SlowTask(float(Prepared.Textures.Num() + Prepared.ChunkPlans.Num() + 1), LOCTEXT("Committing", "Creating assets..."));
+
+		// The lightmap textures come first: generated parent materials take them as parameter defaults.
+		SlowTask.EnterProgressFrame(1.f, LOCTEXT("CreatingLightmap", "Creating lightmap atlas..."));
+		double StartSeconds = FPlatformTime::Seconds();
+		FSurfaceParents SurfaceParents;
+		SurfaceParents.FolderPath = FPaths::GetPath(Prepared.MapPath);
+		TArray<TArray<UTexture2D*>> LightmapPageTextures;
+		CommitLightmapTextures(Prepared, bOverwriteMaterialsAndTextures, LightmapPageTextures, SurfaceParents);
+		OutResult.LightmapSeconds = FPlatformTime::Seconds() - StartSeconds;
 
-		for (const auto& ItTex : Model.textures)
+		TMap<FString, UMaterialInterface*> MaterialsByName;
+		TSet<FString> MaskedTextureNames;
+		StartSeconds = FPlatformTime::Seconds();
+		if (!CommitMaterials(Prepared, bOverwriteMaterialsAndTextures, Parents, SurfaceParents, SlowTask, MaterialsByName, MaskedTextureNames))
 		{
-			const FString SafeTexName = SanitizeSurfaceNameForAsset(ItTex.name);
+			OutResult.bCancelled = true;
+		}
+		OutResult.TexturesSeconds = FPlatformTime::Seconds() - StartSeconds;
 
-			if (ItTex.name.StartsWith(TEXT("sky")))
+		if (!OutResult.bCancelled)
+		{
+			StartSeconds = FPlatformTime::Seconds();
+			CommitLightmapAtlas(Prepared, bOverwriteMaterialsAndTextures, LightmapPageTextures, MaterialsByName);
+			OutResult.LightmapSeconds += FPlatformTime::Seconds() - StartSeconds;
+		}
+
+		// Only one batch of assembled chunks is alive at a time; each chunk is released as soon as its mesh is built.
+		const int64 BudgetBytes = int64(FMath::Max(1, MemoryBudgetMB)) * 1024 * 1024;
+		TArray<bsputils::FAssembledChunk> Batch;
+
+		for (int32 FirstPlan = 0; FirstPlan < Prepared.ChunkPlans.Num() && !OutResult.bCancelled;)
+		{
+			const int32 NumPlans = GetChunkBatchSize(Prepared, FirstPlan, BudgetBytes);
+
+			StartSeconds = FPlatformTime::Seconds();
+			AssembleChunkBatch(Prepared, FirstPlan, NumPlans, Batch);
+			OutResult.AssembleSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+			StartSeconds = FPlatformTime::Seconds();
+			for (int32 BatchIndex = 0; BatchIndex < Batch.Num(); BatchIndex++)
 			{
-				TArray<uint8> Front;
-				TArray<uint8> Back;
-				Front.Reserve((ItTex.width / 2) * ItTex.height);
-				Back.Reserve((ItTex.width / 2) * ItTex.height);
+				if (SlowTask.ShouldCancel())
+				{
+					OutResult.bCancelled = true;
+					break;
+				}
 
-				for (unsigned Y = 0; Y < ItTex.height; Y++)
+				const int32 ChunkIndex = FirstPlan + BatchIndex;
+				bsputils::FAssembledChunk& Chunk = Batch[BatchIndex];
+				SlowTask.EnterProgressFrame(1.f, FText::Format(LOCTEXT("BuildingMesh", "Building {0}"), FText::FromString(Prepared.ChunkPlans[ChunkIndex].MeshName)));
+				if (Chunk.MeshName.IsEmpty())
 				{
-					for (unsigned X = 0; X < ItTex.width; X++)
-					{
-						const unsigned Pos = (Y * ItTex.width) + X;
-						if (X < ItTex.width / 2)
-						{
-							Front.Add(ItTex.mip0[Pos]);
-						}
-						else
-						{
-							Back.Add(ItTex.mip0[Pos]);
-						}
-					}
+					continue;
 				}
-				bool bHasPaletteAlpha = false;
-				CreateTexturePackageAndTexture(SanitizeSurfaceNameForAsset(ItTex.name + TEXT("_front")), ItTex.width / 2, ItTex.height, Front, bHasPaletteAlpha);
-				
-				UTexture2D* BackTex = CreateTexturePackageAndTexture(
-					SanitizeSurfaceNameForAsset(ItTex.name + TEXT("_back")), ItTex.width / 2, ItTex.height, Back, bHasPaletteAlpha);
-				CreateMaterialForTextureName(ItTex.name, SafeTexName, BackTex, bHasPaletteAlpha);
-				continue;
-			}
 
-			if (ItTex.name.StartsWith(TEXT("+0")))
-			{
-				TArray<uint8> Data;
-				Data.Append(ItTex.mip0);
+				FName CollisionProfile;
+				TArray<FString>* OutPaths = nullptr;
+				ResolveChunk(ChunkIndex, Chunk, CollisionProfile, OutPaths);
 
-				int32 NumFrames = 1;
-				while (bsputils::AppendNextTextureData(ItTex.name, NumFrames, Model, Data))
+				const int32 NumBuiltBefore = OutResult.BuildStats.NumBuilt;
+				UStaticMesh* StaticMesh = bsputils::BuildAssembledChunk(*Prepared.Model, Prepared.MeshesPath, Chunk, MaterialsByName, MaskedTextureNames,
+					CollisionProfile, MaskedCollisionProfile, &OutResult.BuildStats);
+				if (StaticMesh && OutPaths)
 				{
-					NumFrames++;
+					OutPaths->Add(StaticMesh->GetPathName());
+				}
+				if (StaticMesh)
+				{
+					OutResult.Report.Chunks.Add(MakeChunkReport(Prepared, ChunkIndex, Chunk, CollisionProfile, OutResult.BuildStats.NumBuilt > NumBuiltBefore));
 				}
 
-				bool bHasPaletteAlpha = false;
-				UTexture2D* FlipTex = CreateTexturePackageAndTexture(ItTex.name, ItTex.width, ItTex.height * NumFrames,
-				                                                     Data, bHasPaletteAlpha);
-				CreateMaterialForTextureName(ItTex.name, SafeTexName, FlipTex, bHasPaletteAlpha);
-				continue;
+				Chunk = bsputils::FAssembledChunk();
 			}
+			OutResult.MeshesSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+			Batch.Reset();
+			FirstPlan += NumPlans;
+		}
+
+		FAssetRegistryModule& ARM = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
+		TArray<FString> Paths;
+		Paths.Add(Prepared.MeshesPath);
+		Paths.Add(Prepared.TexturesPath);
+		Paths.Add(Prepared.MaterialsPath);
+		if (bImportLightmaps)
+		{
+			Paths.Add(Prepared.LightmapsPath);
+		}
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(IAssetRegistry::ScanPathsSynchronous);
+			ARM.Get().ScanPathsSynchronous(Paths, true);
+		}
+
+		FinishImportReport(Prepared, ImportKind, OutResult);
 
-			bool bHasPaletteAlpha = false;
-			UTexture2D* Tex = CreateTexturePackageAndTexture(ItTex.name, ItTex.width, ItTex.height, ItTex.mip0, bHasPaletteAlpha);
-			CreateMaterialForTextureName(ItTex.name, SafeTexName, Tex, bHasPaletteAlpha);
+		if (OutResult.bCancelled)
+		{
+			UE_LOG(LogQuakeImportRunner, Warning, TEXT("%s: import cancelled after rebuilding %d meshes; the generated level was left untouched."),
+				*Prepared.MapName, OutResult.BuildStats.NumBuilt);
+			return false;
 		}
 
 		return true;
 	}
 
+	// Runs a prepare function on a background task while the game thread reports its stage and polls for cancellation.
+	template<typename PrepareFuncType>
+	TUniquePtr<FPreparedImport> RunPrepareTask(PrepareFuncType&& PrepareFunc, FImportProgress& Progress)
+	{
+		UE::Tasks::TTask<TUniquePtr<FPreparedImport>> Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, Forward<PrepareFuncType>(PrepareFunc));
+
+		FScopedSlowTask StageProgress(float(int32(EPrepareStage::Num)), GetStageText(EPrepareStage::Load));
+
+		int32 ShownStage = -1;
+		auto ShowStage = [&]()
+		{
+			const int32 Stage = int32(Progress.Stage.load());
+			while (ShownStage < Stage)
+			{
+				ShownStage++;
+				StageProgress.EnterProgressFrame(1.f, GetStageText(EPrepareStage(ShownStage)));
+			}
+		};
+
+		ShowStage();
+		while (!Task.Wait(FTimespan::FromMilliseconds(50.0)))
+		{
+			ShowStage();
+			StageProgress.TickProgress();
+			if (StageProgress.ShouldCancel())
+			{
+				Progress.bCancelRequested.store(true);
+			}
+		}
+
+		return MoveTemp(Task.GetResult());
+	}
+
 	struct FParsedEntity
 	{
 		FString ClassName;
@@ -263,6 +1262,8 @@ namespace
 
 	bool ParseEntitiesForBmodels(const FString& EntitiesText, TArray<FParsedEntity>& Out)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::ParseEntitiesForBmodels);
+
 		Out.Reset();
 
 		int32 EntityIdx = -1;
@@ -336,147 +1337,188 @@ namespace
 
 		return true;
 	}
+
 }
 
 namespace QuakeBspImportRunner
 {
-bool ImportBspWorld(const FString& BspFilePath, const FString& TargetFolderLongPackagePath, const FString& LitFilePath,
-		EWorldChunkMode WorldChunkMode, int32 WorldChunkSize, float ImportScale, bool bIncludeSky,
-		bool bIncludeWater, bool bImportLightmaps, bool bOverwriteMaterialsAndTextures, UMaterialInterface* BspParentOverride,
-	                    UMaterialInterface* WaterParentOverride, UMaterialInterface* SkyParentOverride, UMaterialInterface* MaskedParentOverride,
-	                    const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile,
-	                    const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths,
-	                    TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths)
+	FWorldImportOptions MakeWorldImportOptions(const UQuakeBSPImportAsset& Asset)
+	{
+		const FString PackageName = Asset.GetOutermost() ? Asset.GetOutermost()->GetName() : TEXT("/Game");
+
+		FWorldImportOptions Options;
+		Options.BspFilePath = Asset.BSPFile.FilePath;
+		Options.TargetFolderLongPackagePath = FPackageName::GetLongPackagePath(PackageName);
+		Options.LitFilePath = Asset.BSPLitFile.FilePath;
+		Options.WorldChunkMode = Asset.WorldChunkMode;
+		Options.WorldChunkSize = Asset.WorldChunkSize;
+		Options.ImportScale = Asset.ImportScale;
+		Options.bIncludeSky = Asset.bBSPWorldImportSky;
+		Options.bIncludeWater = Asset.bBSPWorldImportLiquids;
+		Options.bImportLightmaps = Asset.bImportLightmaps;
+		Options.bImportLightStyles = Asset.bImportLightStyles;
+		Options.LightmapEncoding = Asset.LightmapEncoding;
+		Options.bLightmapMips = Asset.bLightmapMips;
+		Options.bPerChunkLightmapAtlas = Asset.bPerChunkLightmapAtlas;
+		Options.LightmapChunkClusterSize = Asset.LightmapChunkClusterSize;
+		Options.bImportTextureMips = Asset.bImportTextureMips;
+		Options.bPaletteIndexedTextures = Asset.bPaletteIndexedTextures;
+		Options.bFullbrightInAlpha = Asset.bFullbrightInAlpha;
+		Options.TextureEncoding = Asset.TextureEncoding;
+		Options.bBakeVertexLighting = Asset.bBakeVertexLighting;
+		Options.bTessellateVertexLighting = Asset.bTessellateVertexLighting;
+		Options.bOverwriteMaterialsAndTextures = Asset.bOverwriteMaterialsAndTextures;
+		Options.ChunkBuildMemoryBudgetMB = Asset.ChunkBuildMemoryBudgetMB;
+		Options.Parents.Solid = Asset.BSPWorldSolidMaterial.LoadSynchronous();
+		Options.Parents.Masked = Asset.BSPWorldMaskedMaterial.LoadSynchronous();
+		Options.Parents.Liquid = Asset.BSPWorldLiquidMaterial.LoadSynchronous();
+		Options.Parents.Sky = Asset.BSPWorldSkyMaterial.LoadSynchronous();
+		Options.SolidCollisionProfile = Asset.BSPWorldSolidCollisionProfile.Name;
+		Options.MaskedCollisionProfile = Asset.BSPWorldMaskedCollisionProfile.Name;
+		Options.LiquidCollisionProfile = Asset.BSPLiquidCollisionProfile.Name;
+		Options.SkyCollisionProfile = Asset.BSPSkyCollisionProfile.Name;
+		return Options;
+	}
+
+	FEntitiesImportOptions MakeEntitiesImportOptions(const UQuakeBSPImportAsset& Asset)
 	{
-		using namespace bsputils;
+		const FString PackageName = Asset.GetOutermost() ? Asset.GetOutermost()->GetName() : TEXT("/Game");
+
+		FEntitiesImportOptions Options;
+		Options.BspFilePath = Asset.BSPFile.FilePath;
+		Options.TargetFolderLongPackagePath = FPackageName::GetLongPackagePath(PackageName);
+		Options.LitFilePath = Asset.BSPLitFile.FilePath;
+		Options.ImportScale = Asset.ImportScale;
+		Options.bImportFuncDoors = Asset.bImportFuncDoors;
+		Options.bImportFuncPlats = Asset.bImportFuncPlats;
+		Options.bImportTriggers = Asset.bImportFuncTriggers;
+		Options.bImportLightmaps = Asset.bImportLightmaps;
+		Options.bImportLightStyles = Asset.bImportLightStyles;
+		Options.LightmapEncoding = Asset.LightmapEncoding;
+		Options.bLightmapMips = Asset.bLightmapMips;
+		Options.bPerChunkLightmapAtlas = Asset.bPerChunkLightmapAtlas;
+		Options.LightmapChunkClusterSize = Asset.LightmapChunkClusterSize;
+		Options.bImportTextureMips = Asset.bImportTextureMips;
+		Options.bPaletteIndexedTextures = Asset.bPaletteIndexedTextures;
+		Options.bFullbrightInAlpha = Asset.bFullbrightInAlpha;
+		Options.TextureEncoding = Asset.TextureEncoding;
+		Options.bBakeVertexLighting = Asset.bBakeVertexLighting;
+		Options.bTessellateVertexLighting = Asset.bTessellateVertexLighting;
+		Options.bOverwriteMaterialsAndTextures = Asset.bOverwriteMaterialsAndTextures;
+		Options.ChunkBuildMemoryBudgetMB = Asset.ChunkBuildMemoryBudgetMB;
+		Options.Parents.Solid = Asset.BSPEntitySolidMaterial.LoadSynchronous();
+		Options.Parents.Masked = Asset.BSPEntityMaskedMaterial.LoadSynchronous();
+		Options.Parents.Liquid = Asset.BSPWorldLiquidMaterial.LoadSynchronous();
+		Options.Parents.Sky = Asset.BSPWorldSkyMaterial.LoadSynchronous();
+		Options.Parents.Trigger = Asset.BSPEntityTriggerMaterial.LoadSynchronous();
+		Options.SolidCollisionProfile = Asset.BSPEntitySolidCollisionProfile.Name;
+		Options.MaskedCollisionProfile = Asset.BSPEntityMaskedCollisionProfile.Name;
+		Options.TriggerCollisionProfile = Asset.BSPEntityTriggerCollisionProfile.Name;
+		return Options;
+	}
+
+	TUniquePtr<FPreparedImport> PrepareBspWorld(const FWorldImportOptions& Options, FImportProgress* Progress)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::PrepareBspWorld);
 
-		FLoadedBsp Ctx;
-		if (!LoadBspFile(BspFilePath, TargetFolderLongPackagePath, Ctx))
+		TUniquePtr<FPreparedImport> Prepared = MakeUnique<FPreparedImport>();
+		FStageTimer Timer(*Prepared);
+		if (!EnterStage(Progress, Timer, EPrepareStage::Load) || !LoadBspFile(Options.BspFilePath, Options.TargetFolderLongPackagePath, *Prepared))
 		{
-			return false;
+			return nullptr;
 		}
+		Prepared->MeshesPath = Prepared->MapPath / TEXT("Meshes") / TEXT("World");
 
-		TMap<FString, UMaterialInterface*> MaterialsByName;
-		TSet<FString> MaskedTextureNames;
-		if (!EnsureMaterials(*Ctx.Model, Ctx.TexturesPath, Ctx.MaterialsPath, bOverwriteMaterialsAndTextures, BspParentOverride, WaterParentOverride,
-			SkyParentOverride, nullptr, MaskedParentOverride, MaterialsByName, MaskedTextureNames))
+		if (!EnterStage(Progress, Timer, EPrepareStage::Textures) || !PrepareTextures(*Prepared->Model, MakeTextureImportSettings(Options), Prepared->Textures))
 		{
-			return false;
+			return nullptr;
+		}
+		if (Options.bPaletteIndexedTextures && !PreparePaletteLookupTextures(*Prepared))
+		{
+			return nullptr;
 		}
 
-		bsputils::FLightmapAtlas Atlas;
-		const bsputils::FLightmapAtlas* AtlasPtr = nullptr;
-		if (bImportLightmaps)
+		if (!EnterStage(Progress, Timer, EPrepareStage::Atlas))
 		{
-			const FString LightmapsPath = Ctx.MapPath / TEXT("Lightmaps");
-			if (bsputils::BuildLightmapAtlas(*Ctx.Model, LightmapsPath, Ctx.MapName, LitFilePath, bOverwriteMaterialsAndTextures, Atlas))
-			{
-				AtlasPtr = &Atlas;
-				UTexture2D* LightmapTex = LoadObject<UTexture2D>(nullptr, *Atlas.LightmapTextureObjectPath, nullptr, LOAD_Quiet | LOAD_NoWarn);
-				if (LightmapTex)
-				{
-					const FMaterialParameterInfo LMInfo(TEXT("Lightmap"));
-					for (auto& It : MaterialsByName)
-					{
-						if (UMaterialInstanceConstant* MI = Cast<UMaterialInstanceConstant>(It.Value))
-						{
-							MI->PreEditChange(nullptr);
-							MI->SetTextureParameterValueEditorOnly(LMInfo, LightmapTex);
-							MI->MarkPackageDirty();
-							MI->PostEditChange();
-						}
-					}
-				}
-			}
+			return nullptr;
+		}
+		if (Options.bImportLightmaps && !Options.bPerChunkLightmapAtlas)
+		{
+			PackPreparedLightmapAtlas(*Prepared, Options);
 		}
 
-		const FString WorldMeshesPath = Ctx.MapPath / TEXT("Meshes") / TEXT("World");
-		const bool bChunkWorld = (WorldChunkMode == EWorldChunkMode::Grid);
-		ModelToStaticmeshes(*Ctx.Model, WorldMeshesPath, Ctx.MapName, MaterialsByName, MaskedTextureNames, bChunkWorld, WorldChunkSize,
-		                    ImportScale, bIncludeSky, bIncludeWater, BspCollisionProfile, MaskedCollisionProfile,
-		                    WaterCollisionProfile, SkyCollisionProfile, OutBspMeshObjectPaths, OutWaterMeshObjectPaths, OutSkyMeshObjectPaths, AtlasPtr);
+		if (!EnterStage(Progress, Timer, EPrepareStage::Geometry))
+		{
+			return nullptr;
+		}
+		const bool bChunkWorld = (Options.WorldChunkMode == EWorldChunkMode::Grid);
+		Prepared->ImportScale = Options.ImportScale;
+		if (!bsputils::PlanWorldChunks(*Prepared->Model, Prepared->MapName, bChunkWorld, Options.WorldChunkSize,
+			Options.bIncludeSky, Options.bIncludeWater, Prepared->ChunkPlans, Progress ? &Progress->bCancelRequested : nullptr))
+		{
+			return nullptr;
+		}
+		PrepareVertexLighting(*Prepared, Options);
 
-		FAssetRegistryModule& ARM = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-		TArray<FString> Paths;
-		Paths.Add(WorldMeshesPath);
-		Paths.Add(Ctx.TexturesPath);
-		Paths.Add(Ctx.MaterialsPath);
-		if (bImportLightmaps)
+		if (Options.bImportLightmaps && Options.bPerChunkLightmapAtlas)
 		{
-			Paths.Add(Ctx.MapPath / TEXT("Lightmaps"));
+			if (!EnterStage(Progress, Timer, EPrepareStage::Atlas))
+			{
+				return nullptr;
+			}
+			PackPreparedLightmapAtlas(*Prepared, Options);
 		}
-		ARM.Get().ScanPathsSynchronous(Paths, true);
 
-		return true;
+		Timer.Stop();
+		return Prepared;
 	}
 
-bool ImportBspEntities(const FString& BspFilePath, const FString& TargetFolderLongPackagePath, const FString& LitFilePath, float ImportScale,
-		bool bImportFuncDoors, bool bImportFuncPlats, bool bImportTriggers, bool bImportLightmaps, bool bOverwriteMaterialsAndTextures,
-		UMaterialInterface* SolidParentOverride, UMaterialInterface* WaterParentOverride,
-		UMaterialInterface* SkyParentOverride, UMaterialInterface* TriggerParentOverride, UMaterialInterface* MaskedParentOverride,
-		const FName& SolidCollisionProfile, const FName& MaskedCollisionProfile, const FName& TriggerCollisionProfile,
-		TArray<FString>* OutSolidEntityMeshObjectPaths, TArray<FString>* OutTriggerEntityMeshObjectPaths)
+	TUniquePtr<FPreparedImport> PrepareBspEntities(const FEntitiesImportOptions& Options, FImportProgress* Progress)
 	{
-		using namespace bsputils;
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::PrepareBspEntities);
 
-		FLoadedBsp Ctx;
-		if (!LoadBspFile(BspFilePath, TargetFolderLongPackagePath, Ctx))
+		TUniquePtr<FPreparedImport> Prepared = MakeUnique<FPreparedImport>();
+		FStageTimer Timer(*Prepared);
+		if (!EnterStage(Progress, Timer, EPrepareStage::Load) || !LoadBspFile(Options.BspFilePath, Options.TargetFolderLongPackagePath, *Prepared))
 		{
-			return false;
+			return nullptr;
 		}
+		Prepared->MeshesPath = Prepared->MapPath / TEXT("Meshes") / TEXT("Entities");
 
-		TMap<FString, UMaterialInterface*> MaterialsByName;
-		TSet<FString> MaskedTextureNames;
-		if (!EnsureMaterials(*Ctx.Model, Ctx.TexturesPath, Ctx.MaterialsPath, bOverwriteMaterialsAndTextures,
-			SolidParentOverride, WaterParentOverride, SkyParentOverride, TriggerParentOverride, MaskedParentOverride, MaterialsByName, MaskedTextureNames))
+		if (!EnterStage(Progress, Timer, EPrepareStage::Textures) || !PrepareTextures(*Prepared->Model, MakeTextureImportSettings(Options), Prepared->Textures))
 		{
-			return false;
+			return nullptr;
 		}
-
-		TArray<FParsedEntity> Parsed;
-		ParseEntitiesForBmodels(Ctx.Model->entities, Parsed);
-
-		const FString EntitiesMeshesPath = Ctx.MapPath / TEXT("Meshes") / TEXT("Entities");
-
-		bsputils::FLightmapAtlas Atlas;
-		const bsputils::FLightmapAtlas* AtlasPtr = nullptr;
-		if (bImportLightmaps)
+		if (Options.bPaletteIndexedTextures && !PreparePaletteLookupTextures(*Prepared))
 		{
-			const FString LightmapsPath = Ctx.MapPath / TEXT("Lightmaps");
-			if (bsputils::BuildLightmapAtlas(*Ctx.Model, LightmapsPath, Ctx.MapName, LitFilePath, bOverwriteMaterialsAndTextures, Atlas))
-			{
-				AtlasPtr = &Atlas;
-				UTexture2D* LightmapTex = LoadObject<UTexture2D>(nullptr, *Atlas.LightmapTextureObjectPath, nullptr, LOAD_Quiet | LOAD_NoWarn);
-				if (LightmapTex)
-				{
-					const FMaterialParameterInfo LMInfo(TEXT("Lightmap"));
-					for (auto& It : MaterialsByName)
-					{
-						if (UMaterialInstanceConstant* MI = Cast<UMaterialInstanceConstant>(It.Value))
-						{
-							MI->PreEditChange(nullptr);
-							MI->SetTextureParameterValueEditorOnly(LMInfo, LightmapTex);
-							MI->MarkPackageDirty();
-							MI->PostEditChange();
-						}
-					}
-				}
-			}
+			return nullptr;
 		}
 
-
-
-		if (OutSolidEntityMeshObjectPaths)
+		if (!EnterStage(Progress, Timer, EPrepareStage::Atlas))
+		{
+			return nullptr;
+		}
+		if (Options.bImportLightmaps && !Options.bPerChunkLightmapAtlas)
 		{
-			OutSolidEntityMeshObjectPaths->Reset();
+			PackPreparedLightmapAtlas(*Prepared, Options);
 		}
-		if (OutTriggerEntityMeshObjectPaths)
+
+		if (!EnterStage(Progress, Timer, EPrepareStage::Geometry))
 		{
-			OutTriggerEntityMeshObjectPaths->Reset();
+			return nullptr;
 		}
 
+		Prepared->ImportScale = Options.ImportScale;
+		TArray<FParsedEntity> Parsed;
+		ParseEntitiesForBmodels(Prepared->Model->entities, Parsed);
+
 		for (const FParsedEntity& E : Parsed)
 		{
+			if (Progress && Progress->bCancelRequested.load())
+			{
+				return nullptr;
+			}
+
 			const bool bIsDoor = E.ClassName.Equals(TEXT("func_door"), ESearchCase::IgnoreCase)
 				|| E.ClassName.Equals(TEXT("func_door_secret"), ESearchCase::IgnoreCase)
 				|| E.ClassName.Equals(TEXT("func_button"), ESearchCase::IgnoreCase)
@@ -485,15 +1527,15 @@ bool ImportBspEntities(const FString& BspFilePath, const FString& TargetFolderLo
 			const bool bIsPlat = E.ClassName.Equals(TEXT("func_plat"), ESearchCase::IgnoreCase);
 			const bool bIsTrigger = E.ClassName.StartsWith(TEXT("trigger"), ESearchCase::IgnoreCase);
 
-			if (bIsDoor && !bImportFuncDoors)
+			if (bIsDoor && !Options.bImportFuncDoors)
 			{
 				continue;
 			}
-			if (bIsPlat && !bImportFuncPlats)
+			if (bIsPlat && !Options.bImportFuncPlats)
 			{
 				continue;
 			}
-			if (bIsTrigger && !bImportTriggers)
+			if (bIsTrigger && !Options.bImportTriggers)
 			{
 				continue;
 			}
@@ -503,45 +1545,166 @@ bool ImportBspEntities(const FString& BspFilePath, const FString& TargetFolderLo
 			}
 
 			const FString SafeClass = SanitizeSurfaceNameForAsset(E.ClassName);
-			const FString MeshName = FString::Printf(TEXT("SM_%s_BSP_Entity_%s_%d"), *Ctx.MapName, *SafeClass, E.EntityIndex);
-
-			const FName UseCollisionProfile = bIsTrigger ? TriggerCollisionProfile : SolidCollisionProfile;
+			const FString MeshName = FString::Printf(TEXT("SM_%s_BSP_Entity_%s_%d"), *Prepared->MapName, *SafeClass, E.EntityIndex);
 
-			FString ObjPath;
-			if (!CreateSubmodelStaticMesh(*Ctx.Model, EntitiesMeshesPath, MeshName, uint8(E.SubModelIndex),
-				MaterialsByName, MaskedTextureNames, ImportScale, UseCollisionProfile.IsNone() ? UCollisionProfile::BlockAll_ProfileName : UseCollisionProfile,
-				MaskedCollisionProfile, ObjPath, AtlasPtr))
+			bsputils::FChunkPlan Plan;
+			if (!bsputils::PlanSubmodelChunk(*Prepared->Model, E.SubModelIndex, MeshName, Plan))
 			{
 				continue;
 			}
 
 			if (bIsTrigger)
 			{
-				if (OutTriggerEntityMeshObjectPaths)
-				{
-					OutTriggerEntityMeshObjectPaths->Add(ObjPath);
-				}
+				Prepared->TriggerChunkIndices.Add(Prepared->ChunkPlans.Num());
 			}
-			else
+			Prepared->ChunkPlans.Add(MoveTemp(Plan));
+		}
+		PrepareVertexLighting(*Prepared, Options);
+
+		if (Options.bImportLightmaps && Options.bPerChunkLightmapAtlas)
+		{
+			if (!EnterStage(Progress, Timer, EPrepareStage::Atlas))
 			{
-				if (OutSolidEntityMeshObjectPaths)
-				{
-					OutSolidEntityMeshObjectPaths->Add(ObjPath);
-				}
+				return nullptr;
 			}
+			PackPreparedLightmapAtlas(*Prepared, Options);
 		}
 
-		FAssetRegistryModule& ARM = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-		TArray<FString> Paths;
-		Paths.Add(EntitiesMeshesPath);
-		Paths.Add(Ctx.TexturesPath);
-		Paths.Add(Ctx.MaterialsPath);
-		if (bImportLightmaps)
+		Timer.Stop();
+		return Prepared;
+	}
+
+	int32 GetChunkBatchSize(const FPreparedImport& Prepared, int32 FirstPlan, int64 BudgetBytes)
+	{
+		int64 BatchBytes = 0;
+		int32 NumPlans = 0;
+		while (FirstPlan + NumPlans < Prepared.ChunkPlans.Num())
+		{
+			const int64 PlanBytes = Prepared.ChunkPlans[FirstPlan + NumPlans].EstimatedBuildBytes;
+			if (NumPlans > 0 && BatchBytes + PlanBytes > BudgetBytes)
+			{
+				break;
+			}
+			BatchBytes += PlanBytes;
+			NumPlans++;
+		}
+		return NumPlans;
+	}
+
+	void AssembleChunkBatch(const FPreparedImport& Prepared, int32 FirstPlan, int32 NumPlans, TArray<bsputils::FAssembledChunk>& OutChunks)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeBspImportRunner::AssembleChunkBatch);
+
+		const bsputils::FLightmapAtlas* LightmapAtlas = Prepared.bHasLightmapAtlas ? &Prepared.LightmapAtlas : nullptr;
+		const bsputils::FVertexLighting* VertexLighting = Prepared.bHasVertexLighting ? &Prepared.VertexLighting : nullptr;
+		OutChunks.Reset();
+		OutChunks.SetNum(NumPlans);
+		ParallelFor(NumPlans, [&Prepared, &OutChunks, FirstPlan, LightmapAtlas, VertexLighting](int32 Index)
+		{
+			if (!bsputils::AssembleChunk(*Prepared.Model, Prepared.ChunkPlans[FirstPlan + Index], Prepared.ImportScale, LightmapAtlas, OutChunks[Index], VertexLighting))
+			{
+				OutChunks[Index] = bsputils::FAssembledChunk();
+			}
+		});
+	}
+
+	bool CommitBspWorld(FPreparedImport& Prepared, const FWorldImportOptions& Options, FImportResult& OutResult)
+	{
+		auto ResolveChunk = [&Options, &OutResult](int32 ChunkIndex, const bsputils::FAssembledChunk& Chunk, FName& OutCollisionProfile, TArray<FString>*& OutPaths)
+		{
+			switch (Chunk.Kind)
+			{
+			case bsputils::EChunkSurfaceKind::Liquid:
+				OutCollisionProfile = Options.LiquidCollisionProfile;
+				OutPaths = &OutResult.LiquidMeshObjectPaths;
+				break;
+			case bsputils::EChunkSurfaceKind::Sky:
+				OutCollisionProfile = Options.SkyCollisionProfile;
+				OutPaths = &OutResult.SkyMeshObjectPaths;
+				break;
+			default:
+				OutCollisionProfile = Options.SolidCollisionProfile;
+				OutPaths = &OutResult.SolidMeshObjectPaths;
+				break;
+			}
+		};
+
+		if (!CommitPreparedImport(Prepared, TEXT("World"), Options.ChunkBuildMemoryBudgetMB, Options.bOverwriteMaterialsAndTextures, Options.bImportLightmaps, Options.Parents,
+			Options.MaskedCollisionProfile, ResolveChunk, OutResult))
+		{
+			return false;
+		}
+
+		UE_LOG(LogQuakeImportRunner, Log, TEXT("%s: rebuilt %d world meshes, %d unchanged"), *Prepared.MapName, OutResult.BuildStats.NumBuilt, OutResult.BuildStats.NumSkipped);
+		return true;
+	}
+
+	bool CommitBspEntities(FPreparedImport& Prepared, const FEntitiesImportOptions& Options, FImportResult& OutResult)
+	{
+		auto ResolveChunk = [&Prepared, &Options, &OutResult](int32 ChunkIndex, const bsputils::FAssembledChunk& Chunk, FName& OutCollisionProfile, TArray<FString>*& OutPaths)
+		{
+			const bool bIsTrigger = Prepared.TriggerChunkIndices.Contains(ChunkIndex);
+			const FName UseCollisionProfile = bIsTrigger ? Options.TriggerCollisionProfile : Options.SolidCollisionProfile;
+
+			OutCollisionProfile = UseCollisionProfile.IsNone() ? UCollisionProfile::BlockAll_ProfileName : UseCollisionProfile;
+			if (Chunk.bHasTriggerTexture)
+			{
+				OutCollisionProfile = UCollisionProfile::NoCollision_ProfileName;
+			}
+			OutPaths = bIsTrigger ? &OutResult.TriggerMeshObjectPaths : &OutResult.SolidMeshObjectPaths;
+		};
+
+		if (!CommitPreparedImport(Prepared, TEXT("Entities"), Options.ChunkBuildMemoryBudgetMB, Options.bOverwriteMaterialsAndTextures, Options.bImportLightmaps, Options.Parents,
+			Options.MaskedCollisionProfile, ResolveChunk, OutResult))
 		{
-			Paths.Add(Ctx.MapPath / TEXT("Lightmaps"));
+			return false;
 		}
-		ARM.Get().ScanPathsSynchronous(Paths, true);
 
+		UE_LOG(LogQuakeImportRunner, Log, TEXT("%s: rebuilt %d entity meshes, %d unchanged"), *Prepared.MapName, OutResult.BuildStats.NumBuilt, OutResult.BuildStats.NumSkipped);
 		return true;
 	}
+
+	bool ImportBspWorld(const FWorldImportOptions& Options, FImportResult& OutResult)
+	{
+		check(IsInGameThread());
+		OutResult = FImportResult();
+
+		FScopedSlowTask SlowTask(2.f, LOCTEXT("ImportingWorld", "Importing BSP world"));
+		SlowTask.MakeDialog(true);
+
+		SlowTask.EnterProgressFrame(1.f);
+		FImportProgress Progress;
+		TUniquePtr<FPreparedImport> Prepared = RunPrepareTask([&Options, &Progress]() { return PrepareBspWorld(Options, &Progress); }, Progress);
+		if (!Prepared)
+		{
+			OutResult.bCancelled = Progress.bCancelRequested.load();
+			return false;
+		}
+
+		SlowTask.EnterProgressFrame(1.f);
+		return CommitBspWorld(*Prepared, Options, OutResult);
+	}
+
+	bool ImportBspEntities(const FEntitiesImportOptions& Options, FImportResult& OutResult)
+	{
+		check(IsInGameThread());
+		OutResult = FImportResult();
+
+		FScopedSlowTask SlowTask(2.f, LOCTEXT("ImportingEntities", "Importing BSP entities"));
+		SlowTask.MakeDialog(true);
+
+		SlowTask.EnterProgressFrame(1.f);
+		FImportProgress Progress;
+		TUniquePtr<FPreparedImport> Prepared = RunPrepareTask([&Options, &Progress]() { return PrepareBspEntities(Options, &Progress); }, Progress);
+		if (!Prepared)
+		{
+			OutResult.bCancelled = Progress.bCancelRequested.load();
+			return false;
+		}
+
+		SlowTask.EnterProgressFrame(1.f);
+		return CommitBspEntities(*Prepared, Options, OutResult);
+	}
 }
+
+#undef LOCTEXT_NAMESPACE
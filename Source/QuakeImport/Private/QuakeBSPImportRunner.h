@@ -2,11 +2,203 @@
 
 #include "CoreMinimal.h"
 #include "QuakeBSPImportAsset.h"
+#include "QuakeBSPImportReport.h"
+#include "QuakeBSPUtilities.h"
+
+#include <atomic>
+
+class UMaterialInterface;
 
 namespace QuakeBspImportRunner
 {
-	bool ImportBspWorld(const FString& BspFilePath, const FString& TargetFolderLongPackagePath, const FString& LitFilePath, EWorldChunkMode WorldChunkMode, int32 WorldChunkSize, float ImportScale, bool bIncludeSky, bool bIncludeWater, bool bImportLightmaps, bool bOverwriteMaterialsAndTextures, class UMaterialInterface* BspParentOverride, class UMaterialInterface* WaterParentOverride, class UMaterialInterface* SkyParentOverride, class UMaterialInterface* MaskedParentOverride, const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile, const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths, TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths);
+	// Parent materials for generated material instances. Null entries leave the matching surfaces on WorldGridMaterial.
+	struct FParentMaterials
+	{
+		UMaterialInterface* Solid = nullptr;
+		UMaterialInterface* Masked = nullptr;
+		UMaterialInterface* Liquid = nullptr;
+		UMaterialInterface* Sky = nullptr;
+		UMaterialInterface* Trigger = nullptr;
+	};
+
+	struct FWorldImportOptions
+	{
+		FString BspFilePath;
+		FString TargetFolderLongPackagePath;
+		FString LitFilePath;
+		EWorldChunkMode WorldChunkMode = EWorldChunkMode::Grid;
+		int32 WorldChunkSize = 512;
+		float ImportScale = 1.0f;
+		bool bIncludeSky = true;
+		bool bIncludeWater = true;
+		bool bImportLightmaps = false;
+		bool bImportLightStyles = false;
+		ELightmapAtlasEncoding LightmapEncoding = ELightmapAtlasEncoding::Uncompressed;
+		bool bLightmapMips = false;
+		bool bPerChunkLightmapAtlas = false;
+		int32 LightmapChunkClusterSize = 1;
+		bool bImportTextureMips = true;
+		bool bPaletteIndexedTextures = false;
+		bool bFullbrightInAlpha = false;
+		EBspTextureEncoding TextureEncoding = EBspTextureEncoding::Default;
+		bool bBakeVertexLighting = false;
+		bool bTessellateVertexLighting = false;
+		bool bOverwriteMaterialsAndTextures = true;
+		int32 ChunkBuildMemoryBudgetMB = 512;
+		FParentMaterials Parents;
+		FName SolidCollisionProfile;
+		FName MaskedCollisionProfile;
+		FName LiquidCollisionProfile;
+		FName SkyCollisionProfile;
+	};
+
+	// Imports brush entities (bmodels) into individual meshes grouped per entity.
+	struct FEntitiesImportOptions
+	{
+		FString BspFilePath;
+		FString TargetFolderLongPackagePath;
+		FString LitFilePath;
+		float ImportScale = 1.0f;
+		bool bImportFuncDoors = true;
+		bool bImportFuncPlats = true;
+		bool bImportTriggers = false;
+		bool bImportLightmaps = false;
+		bool bImportLightStyles = false;
+		ELightmapAtlasEncoding LightmapEncoding = ELightmapAtlasEncoding::Uncompressed;
+		bool bLightmapMips = false;
+		bool bPerChunkLightmapAtlas = false;
+		int32 LightmapChunkClusterSize = 1;
+		bool bImportTextureMips = true;
+		bool bPaletteIndexedTextures = false;
+		bool bFullbrightInAlpha = false;
+		EBspTextureEncoding TextureEncoding = EBspTextureEncoding::Default;
+		bool bBakeVertexLighting = false;
+		bool bTessellateVertexLighting = false;
+		bool bOverwriteMaterialsAndTextures = true;
+		int32 ChunkBuildMemoryBudgetMB = 512;
+		FParentMaterials Parents;
+		FName SolidCollisionProfile;
+		FName MaskedCollisionProfile;
+		FName TriggerCollisionProfile;
+	};
+
+	struct FImportResult
+	{
+		// World: solid chunks. Entities: solid entity meshes.
+		TArray<FString> SolidMeshObjectPaths;
+		TArray<FString> LiquidMeshObjectPaths;
+		TArray<FString> SkyMeshObjectPaths;
+		TArray<FString> TriggerMeshObjectPaths;
+		bsputils::FChunkBuildStats BuildStats;
+		bool bCancelled = false;
+
+		// Commit timings, in seconds. AssembleSeconds is chunk geometry generated in parallel batches,
+		// MeshesSeconds the static mesh builds on the game thread.
+		double TexturesSeconds = 0.0;
+		double LightmapSeconds = 0.0;
+		double AssembleSeconds = 0.0;
+		double MeshesSeconds = 0.0;
+
+		// Stage timings and per-chunk content; PopulateSeconds and outlier flags are left to the caller.
+		FQuakeImportReport Report;
+	};
+
+	// CPU stages run by PrepareBspWorld / PrepareBspEntities, in execution order.
+	// Geometry only plans chunks; they are assembled, built and released in batches during the commit.
+	enum class EPrepareStage : uint8
+	{
+		Load,
+		Textures,
+		Atlas,
+		Geometry,
+		Num
+	};
+
+	// Shared between a background prepare task and the game thread that waits on it.
+	struct FImportProgress
+	{
+		std::atomic<EPrepareStage> Stage { EPrepareStage::Load };
+		std::atomic<bool> bCancelRequested { false };
+	};
+
+	// A texture converted to BGRA8 (or kept as palette indices), waiting for its UTexture2D (and material instance) on
+	// the game thread.
+	struct FPreparedTexture
+	{
+		FString AssetName;
+		// BSP texture name the material instance is created for. Empty for textures without a material (sky front layer).
+		FString MaterialTextureName;
+		int32 Width = 0;
+		int32 Height = 0;
+		// More than one for the frames of an animated texture, written as a texture array.
+		int32 NumSlices = 1;
+		// NumMips levels in Format, mip 0 first, each holding NumSlices images.
+		TArray<uint8> Pixels;
+		QuakeCommon::EPaletteTextureFormat Format = QuakeCommon::EPaletteTextureFormat::BGRA8;
+		int32 NumMips = 1;
+		// Hash of size, format and pixels, stored on the texture asset to skip regenerating unchanged shared textures.
+		FString ContentHash;
+		bool bHasPaletteAlpha = false;
+		// BGRA8 alpha is the fullbright mask (palette indices 224 to 255) rather than opacity.
+		bool bFullbrightInAlpha = false;
+	};
+
+	// Result of the CPU stages (load, textures, atlas, chunk plans). Holds no UObject.
+	struct FPreparedImport
+	{
+		bsputils::BspLoader Loader;
+		const bsputils::bspformat29::Bsp_29* Model = nullptr;
+
+		FString MapName;
+		FString MapPath;
+		FString TexturesPath;
+		FString MaterialsPath;
+		FString LightmapsPath;
+		FString MeshesPath;
+
+		TArray<FPreparedTexture> Textures;
+
+		// Palette indexed textures: the shared palette (256x1) and colormap (256 x light levels) the materials look
+		// indices up in. ColormapTexture is empty when colormap.lmp is missing.
+		bool bPaletteIndexed = false;
+		FPreparedTexture PaletteTexture;
+		FPreparedTexture ColormapTexture;
+
+		bool bHasLightmapAtlas = false;
+		bsputils::FLightmapAtlas LightmapAtlas;
+
+		bool bHasVertexLighting = false;
+		bsputils::FVertexLighting VertexLighting;
+
+		float ImportScale = 1.0f;
+		TArray<bsputils::FChunkPlan> ChunkPlans;
+		// Entities only: plans built with the trigger collision profile.
+		TSet<int32> TriggerChunkIndices;
+
+		// Wall time spent in each prepare stage, in seconds.
+		double StageSeconds[int32(EPrepareStage::Num)] = {};
+	};
+
+	FWorldImportOptions MakeWorldImportOptions(const UQuakeBSPImportAsset& Asset);
+	FEntitiesImportOptions MakeEntitiesImportOptions(const UQuakeBSPImportAsset& Asset);
+
+	// CPU stages. Safe to run off the game thread; returns null on failure or when Progress->bCancelRequested is raised.
+	TUniquePtr<FPreparedImport> PrepareBspWorld(const FWorldImportOptions& Options, FImportProgress* Progress = nullptr);
+	TUniquePtr<FPreparedImport> PrepareBspEntities(const FEntitiesImportOptions& Options, FImportProgress* Progress = nullptr);
+
+	// Number of plans, starting at FirstPlan, to assemble together without exceeding BudgetBytes. Always at least one.
+	int32 GetChunkBatchSize(const FPreparedImport& Prepared, int32 FirstPlan, int64 BudgetBytes);
+
+	// Assembles NumPlans plans starting at FirstPlan, in parallel. Plans without triangles leave an empty MeshName.
+	void AssembleChunkBatch(const FPreparedImport& Prepared, int32 FirstPlan, int32 NumPlans, TArray<bsputils::FAssembledChunk>& OutChunks);
+
+	// Game thread stages: textures, material instances, lightmap texture and mesh build.
+	// Chunks are assembled in batches of at most the options' ChunkBuildMemoryBudgetMB and released once built.
+	// Cancellation is only honored between assets, so everything committed before it is complete.
+	bool CommitBspWorld(FPreparedImport& Prepared, const FWorldImportOptions& Options, FImportResult& OutResult);
+	bool CommitBspEntities(FPreparedImport& Prepared, const FEntitiesImportOptions& Options, FImportResult& OutResult);
 
-    // Imports brush entities (bmodels) into individual meshes grouped per entity.
-	bool ImportBspEntities(const FString& BspFilePath, const FString& TargetFolderLongPackagePath, const FString& LitFilePath, float ImportScale, bool bImportFuncDoors, bool bImportFuncPlats, bool bImportTriggers, bool bImportLightmaps, bool bOverwriteMaterialsAndTextures, class UMaterialInterface* SolidParentOverride, class UMaterialInterface* WaterParentOverride, class UMaterialInterface* SkyParentOverride, class UMaterialInterface* TriggerParentOverride, class UMaterialInterface* MaskedParentOverride, const FName& SolidCollisionProfile, const FName& MaskedCollisionProfile, const FName& TriggerCollisionProfile, TArray<FString>* OutSolidEntityMeshObjectPaths, TArray<FString>* OutTriggerEntityMeshObjectPaths);
+	// Prepare on a background task then commit, with a cancellable progress dialog. Game thread only.
+	bool ImportBspWorld(const FWorldImportOptions& Options, FImportResult& OutResult);
+	bool ImportBspEntities(const FEntitiesImportOptions& Options, FImportResult& OutResult);
 }
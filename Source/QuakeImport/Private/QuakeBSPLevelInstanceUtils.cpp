@@ -1,6 +1,7 @@
 #include "QuakeBSPLevelInstanceUtils.h"
 
 #include "QuakeBSPImportAsset.h"
+#include "QuakeImportStats.h"
 
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "Editor.h"
@@ -78,6 +79,8 @@ namespace
 
 	bool SaveLevelAsset(UWorld& LevelAsset)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeLevelInstanceUtils::SaveLevelAsset);
+
 		UPackage* Pkg = LevelAsset.GetOutermost();
 		if (!Pkg)
 		{
@@ -193,6 +196,8 @@ namespace QuakeLevelInstanceUtils
 	bool EnsureGeneratedLevelReady(UQuakeBSPImportAsset& ImportAsset, const FString& MapName,
 	                               const FString& FolderLongPackagePath, EGenLevelKind Kind, ULevel*& OutLoadedLevel)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeLevelInstanceUtils::EnsureGeneratedLevelReady);
+
 		OutLoadedLevel = nullptr;
 
 		UWorld* EditorWorld = GetEditorWorld();
@@ -265,6 +270,8 @@ namespace QuakeLevelInstanceUtils
 
 	void RefreshPlacedLevelInstances(UQuakeBSPImportAsset& ImportAsset, EGenLevelKind Kind)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeLevelInstanceUtils::RefreshPlacedLevelInstances);
+
 #if QUAKEIMPORT_HAS_LEVELINSTANCE
 		if (!ImportAsset.bAutoSaveGeneratedLevel && !ImportAsset.bAutoReloadPlacedLevelInstances)
 		{
@@ -310,6 +317,8 @@ namespace QuakeLevelInstanceUtils
 
 	void ClearGeneratedActors(ULevel& TargetLevel, EGenLevelKind Kind)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeLevelInstanceUtils::ClearGeneratedActors);
+
 		(void)Kind;
 		TArray<AActor*> ToDestroy;
 		for (AActor* A : TargetLevel.Actors)
@@ -331,6 +340,44 @@ namespace QuakeLevelInstanceUtils
 		}
 	}
 
+	bool IsLevelPopulatedWith(const ULevel& TargetLevel, const TMap<FString, FName>& StaticMeshObjectPathToCollisionProfile)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeLevelInstanceUtils::IsLevelPopulatedWith);
+
+		int32 NumGenerated = 0;
+		for (const AActor* A : TargetLevel.Actors)
+		{
+			if (!A || !A->Tags.Contains(GeneratedTag))
+			{
+				continue;
+			}
+
+			const AStaticMeshActor* SMA = Cast<AStaticMeshActor>(A);
+			const UStaticMeshComponent* Comp = SMA ? SMA->GetStaticMeshComponent() : nullptr;
+			const UStaticMesh* SM = Comp ? Comp->GetStaticMesh() : nullptr;
+			if (!SM)
+			{
+				return false;
+			}
+
+			const FName* Profile = StaticMeshObjectPathToCollisionProfile.Find(SM->GetPathName());
+			if (!Profile)
+			{
+				return false;
+			}
+
+			const FName UseProfile = Profile->IsNone() ? UCollisionProfile::BlockAll_ProfileName : *Profile;
+			if (Comp->GetCollisionProfileName() != UseProfile)
+			{
+				return false;
+			}
+
+			NumGenerated++;
+		}
+
+		return NumGenerated == StaticMeshObjectPathToCollisionProfile.Num();
+	}
+
 	static void PopulateLevelWithMeshesImpl(ULevel& TargetLevel, const TArray<FString>& StaticMeshObjectPaths,
 	                                        const FName& CollisionProfileName, EGenLevelKind Kind)
 	{
@@ -384,6 +431,8 @@ namespace QuakeLevelInstanceUtils
 	void PopulateLevelWithMeshesWithCollision(ULevel& TargetLevel, const TArray<FString>& StaticMeshObjectPaths,
 	                                          const FName& CollisionProfileName, EGenLevelKind Kind)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeLevelInstanceUtils::PopulateLevelWithMeshesWithCollision);
+
 		PopulateLevelWithMeshesImpl(TargetLevel, StaticMeshObjectPaths, CollisionProfileName, Kind);
 	}
 }
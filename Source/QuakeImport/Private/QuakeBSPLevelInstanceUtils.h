@@ -27,6 +27,10 @@ namespace QuakeLevelInstanceUtils
     // Spawns static mesh actors for the provided meshes in the given level and marks them as generated.
     void PopulateLevelWithMeshes(ULevel& TargetLevel, const TArray<FString>& StaticMeshObjectPaths, EGenLevelKind Kind);
 
+    // True if the level's generated actors reference exactly these meshes with these collision profiles,
+    // i.e. repopulating (and reloading placed Level Instances) would not change anything.
+    bool IsLevelPopulatedWith(const ULevel& TargetLevel, const TMap<FString, FName>& StaticMeshObjectPathToCollisionProfile);
+
     // Same as PopulateLevelWithMeshes, but also applies an explicit collision profile to each spawned component.
     void PopulateLevelWithMeshesWithCollision(ULevel& TargetLevel, const TArray<FString>& StaticMeshObjectPaths, const FName& CollisionProfileName, EGenLevelKind Kind);
 }
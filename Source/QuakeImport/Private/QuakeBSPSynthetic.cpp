@@ -0,0 +1,1173 @@
+#include "QuakeBSPSynthetic.h"
+
+#include "QuakeBSPUtilities.h"
+
+namespace bsputils
+{
+    namespace
+    {
+        using namespace bspformat29;
+
+        // On disk plane: the type is a full int32, unlike the in-memory Plane.
+        struct FFilePlane
+        {
+            float normal[3];
+            float dist;
+            int32 type;
+        };
+
+        constexpr int32 BoxSize = 32;
+        constexpr int32 GridHeight = 128;
+        constexpr int32 AmbientLight = 24;
+        constexpr int TEX_SPECIAL = 1;
+
+        struct FSyntheticLight
+        {
+            FVector3f Position;
+            float Radius = 0.0f;
+            float Intensity = 0.0f;
+        };
+
+        // Leaf under construction. Faces and PVS neighbours are collected before the lumps are laid out.
+        struct FLeafBuild
+        {
+            ELeafContentType Contents = ELeafContentType::Empty;
+            FIntVector Mins = FIntVector::ZeroValue;
+            FIntVector Maxs = FIntVector::ZeroValue;
+            TArray<int32> Faces;
+            TArray<int32> Neighbours;
+        };
+
+        // Leaves of one room cell. Corridors lead to the +X and +Y neighbours.
+        struct FRoomCell
+        {
+            int32 Room = INDEX_NONE;
+            int32 Water = INDEX_NONE;
+            int32 CorridorX = INDEX_NONE;
+            int32 CorridorY = INDEX_NONE;
+            FSyntheticLight Light;
+        };
+
+        // Axis aligned rectangle in the (u, v) plane of a face axis: u = axis + 1, v = axis + 2.
+        struct FUVRect
+        {
+            int32 U0 = 0;
+            int32 V0 = 0;
+            int32 U1 = 0;
+            int32 V1 = 0;
+
+            bool IsEmpty() const
+            {
+                return U1 <= U0 || V1 <= V0;
+            }
+        };
+
+        // Where brush entities are stacked, and which light shades them.
+        struct FEntitySlot
+        {
+            FIntVector Origin = FIntVector::ZeroValue;
+            int32 Light = INDEX_NONE;
+        };
+
+        // Tree children while building: >= 0 is a node, < 0 is -(leaf + 1).
+        int32 LeafChild(int32 LeafIndex)
+        {
+            return -(LeafIndex + 1);
+        }
+
+        class FSyntheticBuilder
+        {
+        public:
+            explicit FSyntheticBuilder(const FSyntheticBspDesc& InDesc)
+                : Desc(InDesc)
+                , TileSize(FMath::Max(16, InDesc.TileSize & ~15))
+            {
+            }
+
+            void Build(Bsp_29& Out)
+            {
+                Model = &Out;
+                *Model = Bsp_29();
+
+                // Edge 0 is never referenced: surfedge sign encodes direction, so index 0 has none.
+                Model->edges.Add({ 0, 0 });
+
+                // Leaf 0 is the shared solid leaf; every tree points to it outside the playable space.
+                Leaves.AddDefaulted_GetRef().Contents = ELeafContentType::Solid;
+
+                EntitiesText = FString::Printf(TEXT("{\n\"classname\" \"worldspawn\"\n\"message\" \"%s\"\n}\n"), *Desc.Name);
+
+                BuildTextures();
+                if (Desc.Layout == ESyntheticLayout::Rooms)
+                {
+                    BuildRooms();
+                }
+                else
+                {
+                    BuildFloorGrid();
+                }
+
+                BuildWorldModel();
+                BuildLeaves();
+                BuildVisibility();
+                BuildEntities();
+
+                Model->entities = MoveTemp(EntitiesText);
+            }
+
+        private:
+            // ---- Textures ----
+
+            void BuildTextures()
+            {
+                const int32 NumTextures = FMath::Max(1, Desc.NumTextures);
+                const int32 Size = FMath::Max(16, Desc.TextureSize & ~15);
+
+                for (int32 TexIndex = 0; TexIndex < NumTextures; TexIndex++)
+                {
+                    AddTexture(FString::Printf(TEXT("synth%04d"), TexIndex), Size, Size, uint8((TexIndex * 16) % 224));
+                }
+                NumSurfaceTextures = NumTextures;
+
+                if (Desc.Layout == ESyntheticLayout::Rooms && Desc.bSkyCeilings)
+                {
+                    SkyTexture = AddTexture(TEXT("sky_synth"), Size * 2, Size, 96);
+                }
+                if (Desc.Layout == ESyntheticLayout::Rooms && Desc.WaterRoomInterval > 0)
+                {
+                    WaterTexture = AddTexture(TEXT("*synthwater"), Size, Size, 208);
+                }
+
+                // One axial texinfo per (axis, texture): s along the u axis, t along the v axis.
+                for (int32 Axis = 0; Axis < 3; Axis++)
+                {
+                    for (int32 TexIndex = 0; TexIndex < Model->textures.Num(); TexIndex++)
+                    {
+                        TexInfo Ti;
+                        FMemory::Memzero(Ti);
+                        Ti.vecs[0][(Axis + 1) % 3] = 1.0f;
+                        Ti.vecs[1][(Axis + 2) % 3] = 1.0f;
+                        Ti.miptex = TexIndex;
+                        Ti.flags = IsSpecialTexture(TexIndex) ? TEX_SPECIAL : 0;
+                        Model->texinfos.Add(Ti);
+                    }
+                }
+            }
+
+            // Checker of two palette colors; index 255 (transparent) is never used.
+            int32 AddTexture(const FString& Name, int32 Width, int32 Height, uint8 BaseColor)
+            {
+                Texture& Tex = Model->textures.AddDefaulted_GetRef();
+                Tex.name = Name;
+                Tex.width = Width;
+                Tex.height = Height;
+                Tex.mip0.SetNumUninitialized(Width * Height);
+
+                for (int32 Y = 0; Y < Height; Y++)
+                {
+                    for (int32 X = 0; X < Width; X++)
+                    {
+                        Tex.mip0[Y * Width + X] = (((X >> 3) + (Y >> 3)) & 1) ? BaseColor : uint8(BaseColor + 8);
+                    }
+                }
+                return Model->textures.Num() - 1;
+            }
+
+            bool IsSpecialTexture(int32 TexIndex) const
+            {
+                return TexIndex == SkyTexture || TexIndex == WaterTexture;
+            }
+
+            int32 SurfaceTexture(int32 Seed) const
+            {
+                return Seed % NumSurfaceTextures;
+            }
+
+            // ---- Geometry ----
+
+            int32 FindOrAddPlane(int32 Axis, int32 Dist)
+            {
+                const FIntPoint Key(Axis, Dist);
+                if (const int32* Found = PlaneMap.Find(Key))
+                {
+                    return *Found;
+                }
+
+                Plane P;
+                FMemory::Memzero(P);
+                P.normal[Axis] = 1.0f;
+                P.dist = float(Dist);
+                P.type = char(Axis);
+
+                const int32 Index = Model->planes.Add(P);
+                PlaneMap.Add(Key, Index);
+                return Index;
+            }
+
+            int32 FindOrAddVertex(const FIntVector& P)
+            {
+                if (const int32* Found = VertexMap.Find(P))
+                {
+                    return *Found;
+                }
+
+                const int32 Index = Model->vertices.Add({ float(P.X), float(P.Y), float(P.Z) });
+                VertexMap.Add(P, Index);
+                return Index;
+            }
+
+            static FIntVector MakePoint(int32 Axis, int32 Dist, int32 U, int32 V)
+            {
+                FIntVector P;
+                P[Axis] = Dist;
+                P[(Axis + 1) % 3] = U;
+                P[(Axis + 2) % 3] = V;
+                return P;
+            }
+
+            // Adds an axial quad facing +Axis (Sign > 0) or -Axis. Quake faces wind clockwise seen from their front side.
+            int32 AddQuad(int32 Axis, int32 Sign, int32 Dist, const FUVRect& Rect, int32 TexIndex, std::initializer_list<int32> InLeaves)
+            {
+                // Counter clockwise around +Axis.
+                const int32 Corners[4] = {
+                    FindOrAddVertex(MakePoint(Axis, Dist, Rect.U0, Rect.V0)),
+                    FindOrAddVertex(MakePoint(Axis, Dist, Rect.U1, Rect.V0)),
+                    FindOrAddVertex(MakePoint(Axis, Dist, Rect.U1, Rect.V1)),
+                    FindOrAddVertex(MakePoint(Axis, Dist, Rect.U0, Rect.V1)) };
+
+                Face F;
+                FMemory::Memzero(F);
+                F.planenum = FindOrAddPlane(Axis, Dist);
+                F.side = Sign > 0 ? 0 : 1;
+                F.firstedge = Model->surfedges.Num();
+                F.numedges = 4;
+                F.texinfo = Axis * Model->textures.Num() + TexIndex;
+
+                for (int32 I = 0; I < 4; I++)
+                {
+                    const int32 From = Sign > 0 ? Corners[(4 - I) % 4] : Corners[I];
+                    const int32 To = Sign > 0 ? Corners[3 - I] : Corners[(I + 1) % 4];
+                    const int32 EdgeIndex = Model->edges.Add({ From, To });
+                    Model->surfedges.Add({ EdgeIndex });
+                }
+
+                F.styles[0] = F.styles[1] = F.styles[2] = F.styles[3] = 255;
+                F.lightofs = -1;
+                if (Desc.bLighting && !IsSpecialTexture(TexIndex))
+                {
+                    F.styles[0] = 0;
+                    F.lightofs = Model->lightdata.Num();
+                    AddLightmap(Axis, Sign, Dist, Rect);
+                }
+
+                const int32 FaceIndex = Model->faces.Add(F);
+                for (int32 LeafIndex : InLeaves)
+                {
+                    Leaves[LeafIndex].Faces.Add(FaceIndex);
+                }
+                return FaceIndex;
+            }
+
+            // Same extents rule as the engine (and ComputeFaceLightmapDimensions): one luxel per 16 texels, inclusive.
+            void AddLightmap(int32 Axis, int32 Sign, int32 Dist, const FUVRect& Rect)
+            {
+                const int32 MinS = FMath::FloorToInt(Rect.U0 / 16.0f) * 16;
+                const int32 MinT = FMath::FloorToInt(Rect.V0 / 16.0f) * 16;
+                const int32 W = (FMath::CeilToInt(Rect.U1 / 16.0f) * 16 - MinS) / 16 + 1;
+                const int32 H = (FMath::CeilToInt(Rect.V1 / 16.0f) * 16 - MinT) / 16 + 1;
+
+                for (int32 T = 0; T < H; T++)
+                {
+                    for (int32 S = 0; S < W; S++)
+                    {
+                        const FIntVector P = MakePoint(Axis, Dist, MinS + S * 16, MinT + T * 16);
+                        const FVector3f Luxel(float(P.X), float(P.Y), float(P.Z));
+
+                        float Value = float(AmbientLight);
+                        for (const FSyntheticLight& Light : CurrentLights)
+                        {
+                            // Only lights in front of the surface reach it.
+                            if ((Light.Position[Axis] - float(Dist)) * float(Sign) <= 0.0f)
+                            {
+                                continue;
+                            }
+                            const float Distance = FVector3f::Distance(Light.Position, Luxel);
+                            Value += Light.Intensity * FMath::Max(0.0f, 1.0f - Distance / Light.Radius);
+                        }
+                        Model->lightdata.Add(uint8(FMath::Clamp(FMath::RoundToInt(Value), 0, 255)));
+                    }
+                }
+            }
+
+            // Splits Rect into TileSize squares (the last row and column may be smaller).
+            void AddTiledRect(int32 Axis, int32 Sign, int32 Dist, const FUVRect& Rect, int32 TexIndex, std::initializer_list<int32> InLeaves)
+            {
+                for (int32 V = Rect.V0; V < Rect.V1; V += TileSize)
+                {
+                    for (int32 U = Rect.U0; U < Rect.U1; U += TileSize)
+                    {
+                        const FUVRect Tile = { U, V, FMath::Min(U + TileSize, Rect.U1), FMath::Min(V + TileSize, Rect.V1) };
+                        AddQuad(Axis, Sign, Dist, Tile, TexIndex, InLeaves);
+                    }
+                }
+            }
+
+            // Tiles Rect minus an optional opening (a corridor entrance).
+            void AddWall(int32 Axis, int32 Sign, int32 Dist, const FUVRect& Rect, const FUVRect* Hole, int32 TexIndex, int32 LeafIndex)
+            {
+                if (!Hole)
+                {
+                    AddTiledRect(Axis, Sign, Dist, Rect, TexIndex, { LeafIndex });
+                    return;
+                }
+
+                const FUVRect Pieces[4] = {
+                    { Rect.U0, Rect.V0, Hole->U0, Rect.V1 },
+                    { Hole->U1, Rect.V0, Rect.U1, Rect.V1 },
+                    { Hole->U0, Rect.V0, Hole->U1, Hole->V0 },
+                    { Hole->U0, Hole->V1, Hole->U1, Rect.V1 } };
+
+                for (const FUVRect& Piece : Pieces)
+                {
+                    if (!Piece.IsEmpty())
+                    {
+                        AddTiledRect(Axis, Sign, Dist, Piece, TexIndex, { LeafIndex });
+                    }
+                }
+            }
+
+            int32 AddLeaf(ELeafContentType Contents, const FIntVector& Mins, const FIntVector& Maxs)
+            {
+                FLeafBuild& Leaf = Leaves.AddDefaulted_GetRef();
+                Leaf.Contents = Contents;
+                Leaf.Mins = Mins;
+                Leaf.Maxs = Maxs;
+                return Leaves.Num() - 1;
+            }
+
+            void LinkLeaves(int32 A, int32 B)
+            {
+                Leaves[A].Neighbours.AddUnique(B);
+                Leaves[B].Neighbours.AddUnique(A);
+            }
+
+            // ---- BSP tree ----
+
+            // Nodes are allocated before their children so a tree root always gets the lowest index (node 0 for the world).
+            int32 AllocNode()
+            {
+                return Model->nodes.AddZeroed();
+            }
+
+            void SetNode(int32 NodeIndex, int32 PlaneNum, int32 Front, int32 Back, const FIntVector& Mins, const FIntVector& Maxs)
+            {
+                Node& N = Model->nodes[NodeIndex];
+                N.planenum = PlaneNum;
+                N.children[0] = Front;
+                N.children[1] = Back;
+                for (int32 A = 0; A < 3; A++)
+                {
+                    N.mins[A] = Mins[A];
+                    N.maxs[A] = Maxs[A];
+                }
+                // Faces are reached through leaves and models by the importer; node face ranges stay empty.
+                N.firstface = 0;
+                N.numfaces = 0;
+            }
+
+            // Splits a rectangle of cells in half along its longer side until single cells remain.
+            template<typename CellFuncType>
+            int32 BuildCellTree(int32 CX0, int32 CY0, int32 CX1, int32 CY1, int32 CellWorld, int32 Height, CellFuncType&& CellFunc)
+            {
+                if (CX1 - CX0 == 1 && CY1 - CY0 == 1)
+                {
+                    return CellFunc(CX0, CY0);
+                }
+
+                const int32 NodeIndex = AllocNode();
+                const bool bSplitX = (CX1 - CX0) >= (CY1 - CY0);
+                const int32 Mid = bSplitX ? (CX0 + CX1) / 2 : (CY0 + CY1) / 2;
+
+                const int32 Back = bSplitX ? BuildCellTree(CX0, CY0, Mid, CY1, CellWorld, Height, CellFunc) : BuildCellTree(CX0, CY0, CX1, Mid, CellWorld, Height, CellFunc);
+                const int32 Front = bSplitX ? BuildCellTree(Mid, CY0, CX1, CY1, CellWorld, Height, CellFunc) : BuildCellTree(CX0, Mid, CX1, CY1, CellWorld, Height, CellFunc);
+
+                SetNode(NodeIndex, FindOrAddPlane(bSplitX ? 0 : 1, Mid * CellWorld), Front, Back,
+                    FIntVector(CX0 * CellWorld, CY0 * CellWorld, 0), FIntVector(CX1 * CellWorld, CY1 * CellWorld, Height));
+                return NodeIndex;
+            }
+
+            // ---- Layouts ----
+
+            void BuildFloorGrid()
+            {
+                const int32 NumFaces = FMath::Max(1, Desc.NumWorldFaces);
+                const int32 CellTiles = FMath::Max(1, Desc.LeafCellTiles);
+                const int32 CellWorld = CellTiles * TileSize;
+
+                GridW = FMath::CeilToInt(FMath::Sqrt(float(NumFaces)));
+                GridH = FMath::DivideAndRoundUp(NumFaces, GridW);
+                const int32 CellsX = FMath::DivideAndRoundUp(GridW, CellTiles);
+                const int32 CellsY = FMath::DivideAndRoundUp(GridH, CellTiles);
+
+                for (int32 CY = 0; CY < CellsY; CY++)
+                {
+                    for (int32 CX = 0; CX < CellsX; CX++)
+                    {
+                        const FIntVector Mins(CX * CellWorld, CY * CellWorld, 0);
+                        const FIntVector Maxs(FMath::Min((CX + 1) * CellWorld, GridW * TileSize), FMath::Min((CY + 1) * CellWorld, GridH * TileSize), GridHeight);
+                        AddLeaf(ELeafContentType::Empty, Mins, Maxs);
+
+                        FSyntheticLight& Light = Lights.AddDefaulted_GetRef();
+                        Light.Position = FVector3f(float(Mins.X + Maxs.X) * 0.5f, float(Mins.Y + Maxs.Y) * 0.5f, float(GridHeight));
+                        Light.Radius = float(CellWorld);
+                        Light.Intensity = float(255 - AmbientLight);
+                    }
+                }
+                auto CellLeaf = [CellsX](int32 CX, int32 CY) { return 1 + CY * CellsX + CX; };
+
+                for (int32 CY = 0; CY < CellsY; CY++)
+                {
+                    for (int32 CX = 0; CX < CellsX; CX++)
+                    {
+                        for (int32 NY = FMath::Max(0, CY - 1); NY <= FMath::Min(CellsY - 1, CY + 1); NY++)
+                        {
+                            for (int32 NX = FMath::Max(0, CX - 1); NX <= FMath::Min(CellsX - 1, CX + 1); NX++)
+                            {
+                                if (NX != CX || NY != CY)
+                                {
+                                    LinkLeaves(CellLeaf(CX, CY), CellLeaf(NX, NY));
+                                }
+                            }
+                        }
+                    }
+                }
+                VisDepth = 1;
+
+                for (int32 TileIndex = 0; TileIndex < NumFaces; TileIndex++)
+                {
+                    const int32 X = TileIndex % GridW;
+                    const int32 Y = TileIndex / GridW;
+                    const int32 LeafIndex = CellLeaf(X / CellTiles, Y / CellTiles);
+
+                    CurrentLights = { Lights[LeafIndex - 1] };
+                    AddQuad(2, 1, 0, { X * TileSize, Y * TileSize, (X + 1) * TileSize, (Y + 1) * TileSize }, SurfaceTexture(TileIndex), { LeafIndex });
+                }
+
+                const int32 Root = BuildCellTree(0, 0, CellsX, CellsY, CellWorld, GridHeight,
+                    [&CellLeaf](int32 CX, int32 CY) { return LeafChild(CellLeaf(CX, CY)); });
+                WrapLeafRoot(Root, FIntVector(GridW * TileSize, GridH * TileSize, GridHeight));
+
+                WorldMaxs = FIntVector(GridW * TileSize, GridH * TileSize, GridHeight);
+            }
+
+            void BuildRooms()
+            {
+                const int32 RoomsX = FMath::Max(1, Desc.RoomsX);
+                const int32 RoomsY = FMath::Max(1, Desc.RoomsY);
+                const int32 RoomSize = FMath::Max(64, Desc.RoomSize & ~15);
+                const int32 RoomHeight = FMath::Max(64, Desc.RoomHeight & ~15);
+                const int32 CorridorLength = FMath::Max(16, Desc.CorridorLength & ~15);
+                const int32 CorridorWidth = FMath::Clamp(Desc.CorridorWidth & ~15, 16, RoomSize - 32);
+                const int32 CorridorHeight = FMath::Min(RoomHeight, 128);
+                const int32 WaterLevel = FMath::Max(16, (RoomHeight / 4) & ~15);
+                const int32 Cell = RoomSize + CorridorLength;
+
+                TArray<FRoomCell> Cells;
+                Cells.SetNum(RoomsX * RoomsY);
+
+                // Leaves and lights first, so corridors can be lit by the rooms at both ends.
+                for (int32 RY = 0; RY < RoomsY; RY++)
+                {
+                    for (int32 RX = 0; RX < RoomsX; RX++)
+                    {
+                        const int32 RoomIndex = RY * RoomsX + RX;
+                        FRoomCell& C = Cells[RoomIndex];
+                        const int32 X0 = RX * Cell;
+                        const int32 Y0 = RY * Cell;
+                        const int32 XC = X0 + RoomSize / 2;
+                        const int32 YC = Y0 + RoomSize / 2;
+
+                        C.Room = AddLeaf(ELeafContentType::Empty, FIntVector(X0, Y0, 0), FIntVector(X0 + RoomSize, Y0 + RoomSize, RoomHeight));
+                        if (Desc.WaterRoomInterval > 0 && (RoomIndex % Desc.WaterRoomInterval) == 0)
+                        {
+                            C.Water = AddLeaf(ELeafContentType::Water, FIntVector(X0, Y0, 0), FIntVector(X0 + RoomSize, Y0 + RoomSize, WaterLevel));
+                            LinkLeaves(C.Room, C.Water);
+                        }
+                        if (RX + 1 < RoomsX)
+                        {
+                            C.CorridorX = AddLeaf(ELeafContentType::Empty, FIntVector(X0 + RoomSize, YC - CorridorWidth / 2, 0), FIntVector(X0 + Cell, YC + CorridorWidth / 2, CorridorHeight));
+                            LinkLeaves(C.Room, C.CorridorX);
+                        }
+                        if (RY + 1 < RoomsY)
+                        {
+                            C.CorridorY = AddLeaf(ELeafContentType::Empty, FIntVector(XC - CorridorWidth / 2, Y0 + RoomSize, 0), FIntVector(XC + CorridorWidth / 2, Y0 + Cell, CorridorHeight));
+                            LinkLeaves(C.Room, C.CorridorY);
+                        }
+
+                        C.Light.Position = FVector3f(float(XC), float(YC), float(RoomHeight) * 0.75f);
+                        C.Light.Radius = float(RoomSize);
+                        C.Light.Intensity = float(255 - AmbientLight);
+                        Lights.Add(C.Light);
+                    }
+                }
+
+                for (int32 RY = 0; RY < RoomsY; RY++)
+                {
+                    for (int32 RX = 0; RX < RoomsX; RX++)
+                    {
+                        const FRoomCell& C = Cells[RY * RoomsX + RX];
+                        if (C.CorridorX != INDEX_NONE)
+                        {
+                            LinkLeaves(C.CorridorX, Cells[RY * RoomsX + RX + 1].Room);
+                        }
+                        if (C.CorridorY != INDEX_NONE)
+                        {
+                            LinkLeaves(C.CorridorY, Cells[(RY + 1) * RoomsX + RX].Room);
+                        }
+                    }
+                }
+                // Rooms see through their corridors into the neighbouring rooms.
+                VisDepth = 2;
+
+                for (int32 RY = 0; RY < RoomsY; RY++)
+                {
+                    for (int32 RX = 0; RX < RoomsX; RX++)
+                    {
+                        const int32 RoomIndex = RY * RoomsX + RX;
+                        const FRoomCell& C = Cells[RoomIndex];
+                        const int32 X0 = RX * Cell;
+                        const int32 Y0 = RY * Cell;
+                        const int32 X1 = X0 + RoomSize;
+                        const int32 Y1 = Y0 + RoomSize;
+                        const int32 XC = X0 + RoomSize / 2;
+                        const int32 YC = Y0 + RoomSize / 2;
+                        const int32 Tex = RoomIndex * 4;
+
+                        // Room interior, every surface facing inward. Axis 0: u = y, v = z. Axis 1: u = z, v = x. Axis 2: u = x, v = y.
+                        CurrentLights = { C.Light };
+                        AddTiledRect(2, 1, 0, { X0, Y0, X1, Y1 }, SurfaceTexture(Tex), { C.Room });
+                        AddTiledRect(2, -1, RoomHeight, { X0, Y0, X1, Y1 }, SkyTexture != INDEX_NONE ? SkyTexture : SurfaceTexture(Tex + 1), { C.Room });
+
+                        const FUVRect HoleX = { YC - CorridorWidth / 2, 0, YC + CorridorWidth / 2, CorridorHeight };
+                        const FUVRect HoleY = { 0, XC - CorridorWidth / 2, CorridorHeight, XC + CorridorWidth / 2 };
+                        const bool bCorridorFromX = RX > 0;
+                        const bool bCorridorFromY = RY > 0;
+                        AddWall(0, 1, X0, { Y0, 0, Y1, RoomHeight }, bCorridorFromX ? &HoleX : nullptr, SurfaceTexture(Tex + 2), C.Room);
+                        AddWall(0, -1, X1, { Y0, 0, Y1, RoomHeight }, C.CorridorX != INDEX_NONE ? &HoleX : nullptr, SurfaceTexture(Tex + 2), C.Room);
+                        AddWall(1, 1, Y0, { 0, X0, RoomHeight, X1 }, bCorridorFromY ? &HoleY : nullptr, SurfaceTexture(Tex + 3), C.Room);
+                        AddWall(1, -1, Y1, { 0, X0, RoomHeight, X1 }, C.CorridorY != INDEX_NONE ? &HoleY : nullptr, SurfaceTexture(Tex + 3), C.Room);
+
+                        // Water surfaces are two sided and belong to both the room and the water volume.
+                        if (C.Water != INDEX_NONE)
+                        {
+                            AddTiledRect(2, 1, WaterLevel, { X0, Y0, X1, Y1 }, WaterTexture, { C.Room, C.Water });
+                            AddTiledRect(2, -1, WaterLevel, { X0, Y0, X1, Y1 }, WaterTexture, { C.Room, C.Water });
+                        }
+
+                        if (C.CorridorX != INDEX_NONE)
+                        {
+                            const int32 CX0 = X1;
+                            const int32 CX1 = X0 + Cell;
+                            CurrentLights = { C.Light, Cells[RoomIndex + 1].Light };
+                            AddTiledRect(2, 1, 0, { CX0, YC - CorridorWidth / 2, CX1, YC + CorridorWidth / 2 }, SurfaceTexture(Tex), { C.CorridorX });
+                            AddTiledRect(2, -1, CorridorHeight, { CX0, YC - CorridorWidth / 2, CX1, YC + CorridorWidth / 2 }, SurfaceTexture(Tex + 1), { C.CorridorX });
+                            AddTiledRect(1, 1, YC - CorridorWidth / 2, { 0, CX0, CorridorHeight, CX1 }, SurfaceTexture(Tex + 3), { C.CorridorX });
+                            AddTiledRect(1, -1, YC + CorridorWidth / 2, { 0, CX0, CorridorHeight, CX1 }, SurfaceTexture(Tex + 3), { C.CorridorX });
+                        }
+
+                        if (C.CorridorY != INDEX_NONE)
+                        {
+                            const int32 CY0 = Y1;
+                            const int32 CY1 = Y0 + Cell;
+                            CurrentLights = { C.Light, Cells[RoomIndex + RoomsX].Light };
+                            AddTiledRect(2, 1, 0, { XC - CorridorWidth / 2, CY0, XC + CorridorWidth / 2, CY1 }, SurfaceTexture(Tex), { C.CorridorY });
+                            AddTiledRect(2, -1, CorridorHeight, { XC - CorridorWidth / 2, CY0, XC + CorridorWidth / 2, CY1 }, SurfaceTexture(Tex + 1), { C.CorridorY });
+                            AddTiledRect(0, 1, XC - CorridorWidth / 2, { CY0, 0, CY1, CorridorHeight }, SurfaceTexture(Tex + 2), { C.CorridorY });
+                            AddTiledRect(0, -1, XC + CorridorWidth / 2, { CY0, 0, CY1, CorridorHeight }, SurfaceTexture(Tex + 2), { C.CorridorY });
+                        }
+                    }
+                }
+
+                // Each cell: x = X1 splits off the +X corridor, y = Y1 the +Y corridor, then the water level splits the room.
+                auto CellFunc = [&](int32 RX, int32 RY)
+                {
+                    const FRoomCell& C = Cells[RY * RoomsX + RX];
+                    const FIntVector Mins(RX * Cell, RY * Cell, 0);
+                    const FIntVector Maxs((RX + 1) * Cell, (RY + 1) * Cell, RoomHeight);
+
+                    const int32 NodeX = AllocNode();
+                    const int32 NodeY = AllocNode();
+                    int32 RoomChild = LeafChild(C.Room);
+                    if (C.Water != INDEX_NONE)
+                    {
+                        const int32 NodeWater = AllocNode();
+                        SetNode(NodeWater, FindOrAddPlane(2, WaterLevel), LeafChild(C.Room), LeafChild(C.Water), Mins, FIntVector(Mins.X + RoomSize, Mins.Y + RoomSize, RoomHeight));
+                        RoomChild = NodeWater;
+                    }
+
+                    SetNode(NodeX, FindOrAddPlane(0, Mins.X + RoomSize), C.CorridorX != INDEX_NONE ? LeafChild(C.CorridorX) : LeafChild(0), NodeY, Mins, Maxs);
+                    SetNode(NodeY, FindOrAddPlane(1, Mins.Y + RoomSize), C.CorridorY != INDEX_NONE ? LeafChild(C.CorridorY) : LeafChild(0), RoomChild,
+                        Mins, FIntVector(Mins.X + RoomSize, Maxs.Y, RoomHeight));
+                    return NodeX;
+                };
+                BuildCellTree(0, 0, RoomsX, RoomsY, Cell, RoomHeight, CellFunc);
+
+                WorldMaxs = FIntVector(RoomsX * Cell - CorridorLength, RoomsY * Cell - CorridorLength, RoomHeight);
+                PlayerStart = FIntVector(RoomSize / 2, RoomSize / 2, 24);
+                EntitySlots.Reserve(RoomsX * RoomsY);
+                for (int32 RY = 0; RY < RoomsY; RY++)
+                {
+                    for (int32 RX = 0; RX < RoomsX; RX++)
+                    {
+                        EntitySlots.Add({ FIntVector(RX * Cell + 16, RY * Cell + 16, 16), RY * RoomsX + RX });
+                    }
+                }
+                EntityAreaSize = RoomSize - 32;
+            }
+
+            // A world made of a single leaf still needs a head node.
+            void WrapLeafRoot(int32 Root, const FIntVector& Maxs)
+            {
+                if (Root >= 0)
+                {
+                    return;
+                }
+
+                const int32 NodeIndex = AllocNode();
+                SetNode(NodeIndex, FindOrAddPlane(2, 0), Root, LeafChild(0), FIntVector::ZeroValue, Maxs);
+            }
+
+            // ---- Model lumps ----
+
+            void BuildWorldModel()
+            {
+                // World clip hulls mirror the render tree, leaves turned into their contents.
+                // Hulls 1 and 2 share it unexpanded; the importer never traces against them.
+                for (const Node& N : Model->nodes)
+                {
+                    Clipnode& C = Model->clipnodes.AddDefaulted_GetRef();
+                    C.planenum = N.planenum;
+                    for (int32 Side = 0; Side < 2; Side++)
+                    {
+                        const int32 Child = N.children[Side];
+                        C.children[Side] = Child >= 0 ? Child : int32(Leaves[-Child - 1].Contents);
+                    }
+                }
+
+                SubModel World;
+                FMemory::Memzero(World);
+                for (int32 A = 0; A < 3; A++)
+                {
+                    World.maxs[A] = float(WorldMaxs[A]);
+                }
+                World.visleafs = Leaves.Num() - 1;
+                World.firstface = 0;
+                World.numfaces = Model->faces.Num();
+                Model->submodels.Add(World);
+
+                for (const FSyntheticLight& Light : Lights)
+                {
+                    EntitiesText += FString::Printf(TEXT("{\n\"classname\" \"light\"\n\"origin\" \"%d %d %d\"\n\"light\" \"%d\"\n}\n"),
+                        FMath::RoundToInt(Light.Position.X), FMath::RoundToInt(Light.Position.Y), FMath::RoundToInt(Light.Position.Z), FMath::RoundToInt(Light.Radius));
+                }
+                EntitiesText += FString::Printf(TEXT("{\n\"classname\" \"info_player_start\"\n\"origin\" \"%d %d %d\"\n}\n"), PlayerStart.X, PlayerStart.Y, PlayerStart.Z);
+            }
+
+            void BuildLeaves()
+            {
+                for (const FLeafBuild& Build : Leaves)
+                {
+                    Leaf& L = Model->leaves.AddZeroed_GetRef();
+                    L.contents = Build.Contents;
+                    L.visofs = -1;
+                    for (int32 A = 0; A < 3; A++)
+                    {
+                        L.mins[A] = Build.Mins[A];
+                        L.maxs[A] = Build.Maxs[A];
+                    }
+                    L.firstmarksurface = Model->marksurfaces.Num();
+                    L.nummarksurfaces = Build.Faces.Num();
+                    for (int32 FaceIndex : Build.Faces)
+                    {
+                        Model->marksurfaces.Add({ FaceIndex });
+                    }
+                }
+            }
+
+            // PVS: each leaf sees the leaves within VisDepth links. Rows are run length compressed like vis does:
+            // a zero byte is followed by the number of zero bytes it stands for.
+            void BuildVisibility()
+            {
+                const int32 NumVisLeaves = Leaves.Num() - 1;
+                const int32 RowBytes = (NumVisLeaves + 7) / 8;
+                TArray<uint8> Row;
+                TArray<int32> Frontier;
+                TArray<int32> Next;
+                TBitArray<> Visited;
+
+                for (int32 LeafIndex = 1; LeafIndex < Leaves.Num(); LeafIndex++)
+                {
+                    Row.Init(0, RowBytes);
+                    Visited.Init(false, Leaves.Num());
+                    Frontier.Reset();
+                    Frontier.Add(LeafIndex);
+                    Visited[LeafIndex] = true;
+
+                    for (int32 Depth = 0; Depth <= VisDepth; Depth++)
+                    {
+                        Next.Reset();
+                        for (int32 Visible : Frontier)
+                        {
+                            Row[(Visible - 1) >> 3] |= uint8(1 << ((Visible - 1) & 7));
+                            for (int32 Neighbour : Leaves[Visible].Neighbours)
+                            {
+                                if (!Visited[Neighbour])
+                                {
+                                    Visited[Neighbour] = true;
+                                    Next.Add(Neighbour);
+                                }
+                            }
+                        }
+                        Swap(Frontier, Next);
+                    }
+
+                    Model->leaves[LeafIndex].visofs = Model->visdata.Num();
+                    for (int32 I = 0; I < RowBytes; I++)
+                    {
+                        if (Row[I])
+                        {
+                            Model->visdata.Add(Row[I]);
+                            continue;
+                        }
+
+                        int32 Run = 1;
+                        while (I + Run < RowBytes && Run < 255 && !Row[I + Run])
+                        {
+                            Run++;
+                        }
+                        Model->visdata.Add(0);
+                        Model->visdata.Add(uint8(Run));
+                        I += Run - 1;
+                    }
+                }
+            }
+
+            // ---- Brush entities ----
+
+            void BuildEntities()
+            {
+                if (EntitySlots.Num() == 0)
+                {
+                    // Floor grid: one slot per tile, boxes hover above the floor.
+                    const int32 CellTiles = FMath::Max(1, Desc.LeafCellTiles);
+                    const int32 CellsX = FMath::DivideAndRoundUp(GridW, CellTiles);
+                    EntitySlots.Reserve(GridW * GridH);
+                    for (int32 TileIndex = 0; TileIndex < GridW * GridH; TileIndex++)
+                    {
+                        const int32 X = TileIndex % GridW;
+                        const int32 Y = TileIndex / GridW;
+                        EntitySlots.Add({ FIntVector(X * TileSize, Y * TileSize, 64), (Y / CellTiles) * CellsX + X / CellTiles });
+                    }
+                    EntityAreaSize = BoxSize;
+                }
+
+                const int32 Spacing = BoxSize + 16;
+                const int32 PerRow = FMath::Max(1, EntityAreaSize / Spacing);
+
+                for (int32 EntityIndex = 0; EntityIndex < Desc.NumEntities; EntityIndex++)
+                {
+                    const FEntitySlot& EntitySlot = EntitySlots[EntityIndex % EntitySlots.Num()];
+                    const int32 Slot = EntityIndex / EntitySlots.Num();
+                    const FIntVector Min = EntitySlot.Origin + FIntVector((Slot % PerRow) * Spacing, ((Slot / PerRow) % PerRow) * Spacing, (Slot / (PerRow * PerRow)) * Spacing);
+                    const FIntVector Max = Min + FIntVector(BoxSize);
+
+                    CurrentLights.Reset();
+                    if (Lights.IsValidIndex(EntitySlot.Light))
+                    {
+                        CurrentLights.Add(Lights[EntitySlot.Light]);
+                    }
+
+                    SubModel Sub;
+                    FMemory::Memzero(Sub);
+                    for (int32 A = 0; A < 3; A++)
+                    {
+                        Sub.mins[A] = float(Min[A]);
+                        Sub.maxs[A] = float(Max[A]);
+                    }
+                    Sub.firstface = Model->faces.Num();
+
+                    // Outward facing sides. Leaf 0 stands for no leaf: brush model faces are not in the world PVS.
+                    const int32 Tex = SurfaceTexture(EntityIndex);
+                    for (int32 Axis = 0; Axis < 3; Axis++)
+                    {
+                        const int32 U = (Axis + 1) % 3;
+                        const int32 V = (Axis + 2) % 3;
+                        const FUVRect Rect = { Min[U], Min[V], Max[U], Max[V] };
+                        AddQuad(Axis, -1, Min[Axis], Rect, Tex, {});
+                        AddQuad(Axis, 1, Max[Axis], Rect, Tex, {});
+                    }
+                    Sub.numfaces = Model->faces.Num() - Sub.firstface;
+
+                    // Render tree and clip hull: a chain of the six box planes, inside solid.
+                    Sub.headnode[0] = Model->nodes.Num();
+                    Sub.headnode[1] = Model->clipnodes.Num();
+                    Sub.headnode[2] = Model->clipnodes.Num();
+                    for (int32 Axis = 0; Axis < 3; Axis++)
+                    {
+                        for (int32 Side = 0; Side < 2; Side++)
+                        {
+                            const bool bLast = (Axis == 2 && Side == 1);
+                            const int32 PlaneNum = FindOrAddPlane(Axis, Side ? Max[Axis] : Min[Axis]);
+                            const int32 NextNode = bLast ? LeafChild(0) : Model->nodes.Num() + 1;
+                            const int32 NextClip = bLast ? int32(ELeafContentType::Solid) : Model->clipnodes.Num() + 1;
+
+                            // Max planes: front is outside. Min planes: back is outside.
+                            const int32 NodeIndex = AllocNode();
+                            SetNode(NodeIndex, PlaneNum, Side ? LeafChild(0) : NextNode, Side ? NextNode : LeafChild(0), Min, Max);
+
+                            Clipnode& C = Model->clipnodes.AddDefaulted_GetRef();
+                            C.planenum = PlaneNum;
+                            C.children[0] = Side ? int32(ELeafContentType::Empty) : NextClip;
+                            C.children[1] = Side ? NextClip : int32(ELeafContentType::Empty);
+                        }
+                    }
+
+                    const int32 SubModelIndex = Model->submodels.Add(Sub);
+                    EntitiesText += FString::Printf(TEXT("{\n\"classname\" \"func_door\"\n\"angle\" \"-1\"\n\"model\" \"*%d\"\n}\n"), SubModelIndex);
+                }
+            }
+
+            const FSyntheticBspDesc& Desc;
+            const int32 TileSize;
+            Bsp_29* Model = nullptr;
+
+            TArray<FLeafBuild> Leaves;
+            TArray<FSyntheticLight> Lights;
+            TArray<FSyntheticLight> CurrentLights;
+            TMap<FIntPoint, int32> PlaneMap;
+            TMap<FIntVector, int32> VertexMap;
+            FString EntitiesText;
+            int32 VisDepth = 1;
+
+            int32 NumSurfaceTextures = 1;
+            int32 SkyTexture = INDEX_NONE;
+            int32 WaterTexture = INDEX_NONE;
+
+            int32 GridW = 0;
+            int32 GridH = 0;
+            FIntVector WorldMaxs = FIntVector::ZeroValue;
+            FIntVector PlayerStart = FIntVector(32, 32, 24);
+
+            TArray<FEntitySlot> EntitySlots;
+            int32 EntityAreaSize = BoxSize;
+        };
+
+        int16 ClampToInt16(int32 Value)
+        {
+            return int16(FMath::Clamp(Value, int32(MIN_int16), int32(MAX_int16)));
+        }
+
+        bool CheckBsp29Limits(const Bsp_29& Model, FString& OutError)
+        {
+            auto Check = [&OutError](int64 Count, int64 Limit, const TCHAR* What)
+            {
+                if (Count > Limit)
+                {
+                    OutError = FString::Printf(TEXT("%s count %lld exceeds the BSP29 limit of %lld; use BSP2."), What, Count, Limit);
+                    return false;
+                }
+                return true;
+            };
+
+            return Check(Model.vertices.Num(), MAX_int16, TEXT("Vertex"))
+                && Check(Model.faces.Num(), MAX_int16, TEXT("Face"))
+                && Check(Model.planes.Num(), MAX_int16, TEXT("Plane"))
+                && Check(Model.texinfos.Num(), MAX_int16, TEXT("Texinfo"))
+                && Check(Model.nodes.Num(), MAX_int16, TEXT("Node"))
+                && Check(Model.clipnodes.Num(), MAX_int16, TEXT("Clipnode"))
+                && Check(Model.leaves.Num(), int64(MAX_int16) + 1, TEXT("Leaf"))
+                && Check(Model.marksurfaces.Num(), MAX_uint16, TEXT("Marksurface"));
+        }
+
+        // Builds the texture lump: count, offset table, then one miptex with four mip levels per texture.
+        void BuildTextureLump(const Bsp_29& Model, TArray<uint8>& Out)
+        {
+            const int32 NumTex = Model.textures.Num();
+            Out.Reset();
+            Out.AddZeroed(sizeof(int32) * (1 + NumTex));
+            FMemory::Memcpy(Out.GetData(), &NumTex, sizeof(int32));
+
+            for (int32 TexIndex = 0; TexIndex < NumTex; TexIndex++)
+            {
+                const Texture& Tex = Model.textures[TexIndex];
+                const int32 MiptexOffset = Out.Num();
+                FMemory::Memcpy(Out.GetData() + sizeof(int32) * (1 + TexIndex), &MiptexOffset, sizeof(int32));
+
+                Miptex Header;
+                FMemory::Memzero(Header);
+                FCStringAnsi::Strncpy(Header.name, TCHAR_TO_ANSI(*Tex.name), sizeof(Header.name));
+                Header.width = Tex.width;
+                Header.height = Tex.height;
+
+                const int32 HeaderPos = Out.AddZeroed(sizeof(Miptex));
+                for (int32 Mip = 0; Mip < 4; Mip++)
+                {
+                    const int32 W = FMath::Max(1, int32(Tex.width) >> Mip);
+                    const int32 H = FMath::Max(1, int32(Tex.height) >> Mip);
+                    Header.offsets[Mip] = unsigned(Out.Num() - MiptexOffset);
+
+                    const int32 MipPos = Out.AddUninitialized(W * H);
+                    for (int32 Y = 0; Y < H; Y++)
+                    {
+                        for (int32 X = 0; X < W; X++)
+                        {
+                            Out[MipPos + Y * W + X] = Tex.mip0[(Y << Mip) * Tex.width + (X << Mip)];
+                        }
+                    }
+                }
+
+                FMemory::Memcpy(Out.GetData() + HeaderPos, &Header, sizeof(Miptex));
+            }
+        }
+    }
+
+    void BuildSyntheticBsp(const FSyntheticBspDesc& Desc, bspformat29::Bsp_29& OutModel)
+    {
+        FSyntheticBuilder(Desc).Build(OutModel);
+    }
+
+    bool WriteBspFile(const bspformat29::Bsp_29& Model, bool bBsp2, TArray<uint8>& OutData, FString& OutError)
+    {
+        if (!bBsp2 && !CheckBsp29Limits(Model, OutError))
+        {
+            return false;
+        }
+
+        Lump Lumps[HEADER_LUMP_SIZE];
+        FMemory::Memzero(Lumps);
+
+        OutData.Reset();
+        if (bBsp2)
+        {
+            OutData.Append(reinterpret_cast<const uint8*>(bspformat2::HEADER_IDENT_BSP2), 4);
+        }
+        else
+        {
+            const int32 Version = HEADER_VERSION_29;
+            OutData.Append(reinterpret_cast<const uint8*>(&Version), sizeof(int32));
+        }
+        const int32 DirectoryPos = OutData.AddZeroed(sizeof(Lumps));
+
+        // BspLoader first probes an ident + version + lumps BSP2 header, which reads one int past this directory
+        // as the model lump length. Keeping it zero makes that probe fail and the standard layout win.
+        if (bBsp2)
+        {
+            OutData.AddZeroed(sizeof(int32));
+        }
+
+        auto WriteLump = [&OutData, &Lumps](int32 LumpIndex, const void* Data, int64 Bytes)
+        {
+            OutData.AddZeroed(Align(OutData.Num(), 4) - OutData.Num());
+            Lumps[LumpIndex].position = OutData.Num();
+            Lumps[LumpIndex].length = int32(Bytes);
+            OutData.Append(static_cast<const uint8*>(Data), int32(Bytes));
+        };
+
+        auto WriteArray = [&WriteLump](int32 LumpIndex, const auto& Array)
+        {
+            WriteLump(LumpIndex, Array.GetData(), int64(Array.Num()) * int64(Array.GetTypeSize()));
+        };
+
+        const FTCHARToUTF8 EntitiesUtf8(*Model.entities);
+        TArray<uint8> EntitiesBytes;
+        EntitiesBytes.Append(reinterpret_cast<const uint8*>(EntitiesUtf8.Get()), EntitiesUtf8.Length());
+        EntitiesBytes.Add(0);
+        WriteArray(LUMP_ENTITIES, EntitiesBytes);
+
+        TArray<FFilePlane> Planes;
+        Planes.Reserve(Model.planes.Num());
+        for (const Plane& P : Model.planes)
+        {
+            Planes.Add({ { P.normal[0], P.normal[1], P.normal[2] }, P.dist, int32(P.type) });
+        }
+        WriteArray(LUMP_PLANES, Planes);
+
+        TArray<uint8> TextureLump;
+        BuildTextureLump(Model, TextureLump);
+        WriteArray(LUMP_TEXTURES, TextureLump);
+
+        WriteArray(LUMP_VERTEXES, Model.vertices);
+        WriteArray(LUMP_VISIBILITY, Model.visdata);
+
+        if (bBsp2)
+        {
+            TArray<bspformat2::FileNode> Nodes;
+            for (const Node& N : Model.nodes)
+            {
+                bspformat2::FileNode& F = Nodes.AddZeroed_GetRef();
+                F.planenum = N.planenum;
+                F.children[0] = N.children[0];
+                F.children[1] = N.children[1];
+                for (int32 A = 0; A < 3; A++)
+                {
+                    F.mins[A] = ClampToInt16(N.mins[A]);
+                    F.maxs[A] = ClampToInt16(N.maxs[A]);
+                }
+                F.firstface = N.firstface;
+                F.numfaces = N.numfaces;
+            }
+            WriteArray(LUMP_NODES, Nodes);
+        }
+        else
+        {
+            TArray<FileNode> Nodes;
+            for (const Node& N : Model.nodes)
+            {
+                FileNode& F = Nodes.AddZeroed_GetRef();
+                F.planenum = N.planenum;
+                F.children[0] = int16(N.children[0]);
+                F.children[1] = int16(N.children[1]);
+                for (int32 A = 0; A < 3; A++)
+                {
+                    F.mins[A] = ClampToInt16(N.mins[A]);
+                    F.maxs[A] = ClampToInt16(N.maxs[A]);
+                }
+                F.firstface = uint16(N.firstface);
+                F.numfaces = uint16(N.numfaces);
+            }
+            WriteArray(LUMP_NODES, Nodes);
+        }
+
+        WriteArray(LUMP_TEXINFO, Model.texinfos);
+
+        if (bBsp2)
+        {
+            TArray<bspformat2::FileFace> Faces;
+            for (const Face& Src : Model.faces)
+            {
+                bspformat2::FileFace& F = Faces.AddZeroed_GetRef();
+                F.planenum = Src.planenum;
+                F.side = Src.side;
+                F.firstedge = Src.firstedge;
+                F.numedges = Src.numedges;
+                F.texinfo = Src.texinfo;
+                FMemory::Memcpy(F.styles, Src.styles, MAXLIGHTMAPS);
+                F.lightofs = Src.lightofs;
+            }
+            WriteArray(LUMP_FACES, Faces);
+        }
+        else
+        {
+            TArray<FileFace> Faces;
+            for (const Face& Src : Model.faces)
+            {
+                FileFace& F = Faces.AddZeroed_GetRef();
+                F.planenum = int16(Src.planenum);
+                F.side = int16(Src.side);
+                F.firstedge = Src.firstedge;
+                F.numedges = int16(Src.numedges);
+                F.texinfo = int16(Src.texinfo);
+                FMemory::Memcpy(F.styles, Src.styles, MAXLIGHTMAPS);
+                F.lightofs = Src.lightofs;
+            }
+            WriteArray(LUMP_FACES, Faces);
+        }
+
+        WriteArray(LUMP_LIGHTING, Model.lightdata);
+
+        if (bBsp2)
+        {
+            TArray<bspformat2::FileClipnode> Clipnodes;
+            for (const Clipnode& C : Model.clipnodes)
+            {
+                Clipnodes.Add({ C.planenum, { C.children[0], C.children[1] } });
+            }
+            WriteArray(LUMP_CLIPNODES, Clipnodes);
+
+            TArray<bspformat2::FileLeaf> Leaves;
+            for (const Leaf& Src : Model.leaves)
+            {
+                bspformat2::FileLeaf& L = Leaves.AddZeroed_GetRef();
+                L.contents = Src.contents;
+                L.visofs = Src.visofs;
+                for (int32 A = 0; A < 3; A++)
+                {
+                    L.mins[A] = ClampToInt16(Src.mins[A]);
+                    L.maxs[A] = ClampToInt16(Src.maxs[A]);
+                }
+                L.firstmarksurface = Src.firstmarksurface;
+                L.nummarksurfaces = Src.nummarksurfaces;
+                FMemory::Memcpy(L.ambient_level, Src.ambient_level, 4);
+            }
+            WriteArray(LUMP_LEAFS, Leaves);
+
+            TArray<bspformat2::FileMarksurface> Marks;
+            for (const Marksurface& M : Model.marksurfaces)
+            {
+                Marks.Add({ M.index });
+            }
+            WriteArray(LUMP_MARKSURFACES, Marks);
+
+            TArray<bspformat2::FileEdge> Edges;
+            for (const Edge& E : Model.edges)
+            {
+                Edges.Add({ E.first, E.second });
+            }
+            WriteArray(LUMP_EDGES, Edges);
+        }
+        else
+        {
+            TArray<FileClipnode> Clipnodes;
+            for (const Clipnode& C : Model.clipnodes)
+            {
+                Clipnodes.Add({ C.planenum, { int16(C.children[0]), int16(C.children[1]) } });
+            }
+            WriteArray(LUMP_CLIPNODES, Clipnodes);
+
+            TArray<FileLeaf> Leaves;
+            for (const Leaf& Src : Model.leaves)
+            {
+                FileLeaf& L = Leaves.AddZeroed_GetRef();
+                L.contents = Src.contents;
+                L.visofs = Src.visofs;
+                for (int32 A = 0; A < 3; A++)
+                {
+                    L.mins[A] = ClampToInt16(Src.mins[A]);
+                    L.maxs[A] = ClampToInt16(Src.maxs[A]);
+                }
+                L.firstmarksurface = uint16(Src.firstmarksurface);
+                L.nummarksurfaces = uint16(Src.nummarksurfaces);
+                FMemory::Memcpy(L.ambient_level, Src.ambient_level, 4);
+            }
+            WriteArray(LUMP_LEAFS, Leaves);
+
+            TArray<FileMarksurface> Marks;
+            for (const Marksurface& M : Model.marksurfaces)
+            {
+                Marks.Add({ int16(M.index) });
+            }
+            WriteArray(LUMP_MARKSURFACES, Marks);
+
+            TArray<FileEdge> Edges;
+            for (const Edge& E : Model.edges)
+            {
+                Edges.Add({ int16(E.first), int16(E.second) });
+            }
+            WriteArray(LUMP_EDGES, Edges);
+        }
+
+        WriteArray(LUMP_SURFEDGES, Model.surfedges);
+        WriteArray(LUMP_MODELS, Model.submodels);
+
+        FMemory::Memcpy(OutData.GetData() + DirectoryPos, Lumps, sizeof(Lumps));
+        return true;
+    }
+
+    bool WriteSyntheticBsp(const FSyntheticBspDesc& Desc, TArray<uint8>& OutData, FString& OutError)
+    {
+        bspformat29::Bsp_29 Model;
+        BuildSyntheticBsp(Desc, Model);
+        return WriteBspFile(Model, Desc.bBsp2, OutData, OutError);
+    }
+
+} // namespace bsputils
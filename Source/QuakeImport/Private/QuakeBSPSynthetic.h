@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace bsputils
+{
+    namespace bspformat29
+    {
+        struct Bsp_29;
+    }
+
+    enum class ESyntheticLayout : uint8
+    {
+        // Flat grid of square floor tiles, one leaf per cell of LeafCellTiles x LeafCellTiles tiles.
+        FloorGrid,
+        // RoomsX x RoomsY box rooms joined by corridors, one leaf per room, corridor and water volume.
+        Rooms
+    };
+
+    // Parameters of a procedurally generated BSP, used to stress the importer at controlled sizes.
+    // Brush entities are small boxes (func_door) with their own submodel, hull and lightmaps.
+    struct FSyntheticBspDesc
+    {
+        FString Name;
+        bool bBsp2 = false;
+        ESyntheticLayout Layout = ESyntheticLayout::FloorGrid;
+
+        // Surfaces are split into TileSize squares; each gets a (TileSize / 16 + 1)^2 luxel lightmap.
+        int32 TileSize = 64;
+
+        // FloorGrid
+        int32 NumWorldFaces = 1024;
+        int32 LeafCellTiles = 8;
+
+        // Rooms
+        int32 RoomsX = 4;
+        int32 RoomsY = 4;
+        int32 RoomSize = 512;
+        int32 RoomHeight = 256;
+        int32 CorridorLength = 256;
+        int32 CorridorWidth = 128;
+        bool bSkyCeilings = false;
+        // Every Nth room holds a water volume (0 for none).
+        int32 WaterRoomInterval = 0;
+
+        int32 NumTextures = 16;
+        int32 TextureSize = 64;
+
+        int32 NumEntities = 0;
+        bool bLighting = true;
+    };
+
+    // Builds the in-memory model for Desc: geometry, BSP tree, clip hulls, lighting and a compressed PVS.
+    void BuildSyntheticBsp(const FSyntheticBspDesc& Desc, bspformat29::Bsp_29& OutModel);
+
+    // Serializes a model to a BSP29 or BSP2 file, every lump included. Fails (with OutError) when the model
+    // exceeds the format limits, e.g. BSP29 16-bit vertex, face, node or marksurface indices.
+    bool WriteBspFile(const bspformat29::Bsp_29& Model, bool bBsp2, TArray<uint8>& OutData, FString& OutError);
+
+    // BuildSyntheticBsp followed by WriteBspFile.
+    bool WriteSyntheticBsp(const FSyntheticBspDesc& Desc, TArray<uint8>& OutData, FString& OutError);
+
+} // namespace bsputils
@@ -5,6 +5,8 @@
 #include "QuakeImportCommon.h"
 
 // EPIC
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "Containers/UnrealString.h"
 #include "Editor/EditorEngine.h"
@@ -16,11 +18,19 @@
 #include "PhysicsEngine/BodySetup.h"
 #include "Engine/CollisionProfile.h"
 #include "RawMesh.h"
+#include "Hash/xxhash.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
+#include "UObject/MetaData.h"
 #include "UObject/Package.h"
 #include "UObject/UObjectGlobals.h"
 
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+#include <smmintrin.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#endif
+
 namespace bsputils
 {
     BspLoader::BspLoader() :
@@ -36,6 +46,8 @@ namespace bsputils
 
     void BspLoader::Load(const uint8* data, int64 dataSize)
     {
+        TRACE_CPUPROFILER_EVENT_SCOPE(BspLoader::Load);
+
         m_dataStart = data;
         m_dataSize = dataSize;
 
@@ -455,40 +467,47 @@ namespace bsputils
             }
         }
 
-        DeserializeLump<bspformat29::Point3f>(m_dataStart, Lumps[bspformat29::LUMP_VERTEXES], m_bsp29->vertices);
-        DeserializeLump<bspformat29::Surfedge>(data, Lumps[bspformat29::LUMP_SURFEDGES], m_bsp29->surfedges);
-        DeserializeLump<uint8>(data, Lumps[bspformat29::LUMP_LIGHTING], m_bsp29->lightdata);
-        DeserializeLump<bspformat29::Plane>(data, Lumps[bspformat29::LUMP_PLANES], m_bsp29->planes);
+        // One trace scope per lump, so Insights shows which part of the file dominates loading.
+        auto Decode = [](const TCHAR* LumpName, auto&& DecodeFunc)
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(LumpName);
+            DecodeFunc();
+        };
+
+        Decode(TEXT("BspLoader::Vertices"), [&]() { DeserializeLump<bspformat29::Point3f>(m_dataStart, Lumps[bspformat29::LUMP_VERTEXES], m_bsp29->vertices); });
+        Decode(TEXT("BspLoader::Surfedges"), [&]() { DeserializeLump<bspformat29::Surfedge>(data, Lumps[bspformat29::LUMP_SURFEDGES], m_bsp29->surfedges); });
+        Decode(TEXT("BspLoader::Lighting"), [&]() { DeserializeLump<uint8>(data, Lumps[bspformat29::LUMP_LIGHTING], m_bsp29->lightdata); });
+        Decode(TEXT("BspLoader::Planes"), [&]() { DeserializeLump<bspformat29::Plane>(data, Lumps[bspformat29::LUMP_PLANES], m_bsp29->planes); });
         if (bIsBsp2)
         {
-            DeserializeModels2(Lumps[bspformat29::LUMP_MODELS]);
+            Decode(TEXT("BspLoader::Models"), [&]() { DeserializeModels2(Lumps[bspformat29::LUMP_MODELS]); });
         }
         else
         {
-            DeserializeLump<bspformat29::SubModel>(data, Lumps[bspformat29::LUMP_MODELS], m_bsp29->submodels);
+            Decode(TEXT("BspLoader::Models"), [&]() { DeserializeLump<bspformat29::SubModel>(data, Lumps[bspformat29::LUMP_MODELS], m_bsp29->submodels); });
         }
-        DeserializeLump<bspformat29::TexInfo>(data, Lumps[bspformat29::LUMP_TEXINFO], m_bsp29->texinfos);
-        DeserializeLump<uint8>(data, Lumps[bspformat29::LUMP_VISIBILITY], m_bsp29->visdata);
+        Decode(TEXT("BspLoader::Texinfo"), [&]() { DeserializeLump<bspformat29::TexInfo>(data, Lumps[bspformat29::LUMP_TEXINFO], m_bsp29->texinfos); });
+        Decode(TEXT("BspLoader::Visibility"), [&]() { DeserializeLump<uint8>(data, Lumps[bspformat29::LUMP_VISIBILITY], m_bsp29->visdata); });
 
         if (bIsBsp2)
         {
-            DeserializeEdges2(Lumps[bspformat29::LUMP_EDGES]);
-            DeserializeFaces2(Lumps[bspformat29::LUMP_FACES]);
-            DeserializeMarks2(Lumps[bspformat29::LUMP_MARKSURFACES]);
-            DeserializeLeaves2(Lumps[bspformat29::LUMP_LEAFS]);
-            DeserializeNodes2(Lumps[bspformat29::LUMP_NODES]);
+            Decode(TEXT("BspLoader::Edges"), [&]() { DeserializeEdges2(Lumps[bspformat29::LUMP_EDGES]); });
+            Decode(TEXT("BspLoader::Faces"), [&]() { DeserializeFaces2(Lumps[bspformat29::LUMP_FACES]); });
+            Decode(TEXT("BspLoader::Marksurfaces"), [&]() { DeserializeMarks2(Lumps[bspformat29::LUMP_MARKSURFACES]); });
+            Decode(TEXT("BspLoader::Leaves"), [&]() { DeserializeLeaves2(Lumps[bspformat29::LUMP_LEAFS]); });
+            Decode(TEXT("BspLoader::Nodes"), [&]() { DeserializeNodes2(Lumps[bspformat29::LUMP_NODES]); });
         }
         else
         {
-            DeserializeEdges29(Lumps[bspformat29::LUMP_EDGES]);
-            DeserializeFaces29(Lumps[bspformat29::LUMP_FACES]);
-            DeserializeMarks29(Lumps[bspformat29::LUMP_MARKSURFACES]);
-            DeserializeLeaves29(Lumps[bspformat29::LUMP_LEAFS]);
-            DeserializeNodes29(Lumps[bspformat29::LUMP_NODES]);
+            Decode(TEXT("BspLoader::Edges"), [&]() { DeserializeEdges29(Lumps[bspformat29::LUMP_EDGES]); });
+            Decode(TEXT("BspLoader::Faces"), [&]() { DeserializeFaces29(Lumps[bspformat29::LUMP_FACES]); });
+            Decode(TEXT("BspLoader::Marksurfaces"), [&]() { DeserializeMarks29(Lumps[bspformat29::LUMP_MARKSURFACES]); });
+            Decode(TEXT("BspLoader::Leaves"), [&]() { DeserializeLeaves29(Lumps[bspformat29::LUMP_LEAFS]); });
+            Decode(TEXT("BspLoader::Nodes"), [&]() { DeserializeNodes29(Lumps[bspformat29::LUMP_NODES]); });
         }
 
-        LoadTextures(data, Lumps[bspformat29::LUMP_TEXTURES]);
-        LoadEntities(data, Lumps[bspformat29::LUMP_ENTITIES]);
+        Decode(TEXT("BspLoader::Textures"), [&]() { LoadTextures(data, Lumps[bspformat29::LUMP_TEXTURES]); });
+        Decode(TEXT("BspLoader::Entities"), [&]() { LoadEntities(data, Lumps[bspformat29::LUMP_ENTITIES]); });
     }
 
     void BspLoader::LoadTextures(const uint8*& data, const bspformat29::Lump& lump)
@@ -587,8 +606,37 @@ namespace bsputils
             Tex.height = H;
             Tex.mip0.SetNumUninitialized(int32(Bytes64));
             FMemory::Memcpy(Tex.mip0.GetData(), data + Mip0Abs, size_t(Bytes64));
+            INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, Bytes64);
+
+            // Lower mips are optional: a bad one drops it and the ones after it, the importer generates them instead.
+            for (int32 Mip = 1; Mip < 4; Mip++)
+            {
+                const int64 MipBytes = int64(W >> Mip) * int64(H >> Mip);
+                const int64 MipRel = int64(Mt->offsets[Mip]);
+                const int64 MipAbs = MiptexStart + MipRel;
+                if (MipBytes <= 0 || MipRel <= 0 || MipAbs < LumpPos || MipAbs + MipBytes > LumpPos + LumpLen)
+                {
+                    break;
+                }
+
+                TArray<uint8>& MipData = Tex.lowerMips[Mip - 1];
+                MipData.SetNumUninitialized(int32(MipBytes));
+                FMemory::Memcpy(MipData.GetData(), data + MipAbs, size_t(MipBytes));
+                INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, MipBytes);
+            }
             m_bsp29->textures.Add(MoveTemp(Tex));
         }
+
+        m_bsp29->textureIndexByName.Reset();
+        m_bsp29->textureIndexByName.Reserve(m_bsp29->textures.Num());
+        for (int32 i = 0; i < m_bsp29->textures.Num(); i++)
+        {
+            const FString Key = m_bsp29->textures[i].name.ToLower();
+            if (!m_bsp29->textureIndexByName.Contains(Key))
+            {
+                m_bsp29->textureIndexByName.Add(Key, i);
+            }
+        }
     }
 
     void BspLoader::LoadEntities(const uint8*& data, const bspformat29::Lump& lump)
@@ -607,23 +655,15 @@ namespace bsputils
         m_bsp29->entities = ANSI_TO_TCHAR(Temp.GetData());
     }
 
-    void AddWedgeEntry(FRawMesh& mesh, const uint32 index, const FVector3f normal, const FVector2f texcoord0, const FVector2f texcoord1)
+    void AddWedgeEntry(FRawMesh& mesh, const uint32 index, const FVector3f normal, const FVector2f texcoord0, const FVector2f texcoord1, const FColor color = FColor(0))
     {
         mesh.WedgeIndices.Add(index);
-        mesh.WedgeColors.Add(FColor(0));
+        mesh.WedgeColors.Add(color);
         mesh.WedgeTangentZ.Add(normal);
         mesh.WedgeTexCoords[0].Add(texcoord0);
         mesh.WedgeTexCoords[1].Add(texcoord1);
     }
 
-    struct FWorldChunkBuild
-    {
-        FRawMesh RawMesh;
-        TMap<int32, int32> BspVertexToLocal;
-        TArray<int32> SlotToTextureId;
-        TMap<int32, int32> TextureIdToSlot;
-    };
-
     static FIntVector GetChunkKey3D(const FVector3f& Center, int32 ChunkSize)
     {
         if (ChunkSize <= 0)
@@ -637,19 +677,26 @@ namespace bsputils
         return FIntVector(X, Y, Z);
     }
 
-    static int32 GetOrAddMaterialSlot(FWorldChunkBuild& Chunk, int32 TextureId)
+    static int32 GetOrAddMaterialSlot(FWorldChunkBuild& Chunk, int32 TextureId, int32 LightmapPage)
     {
-        if (const int32* Found = Chunk.TextureIdToSlot.Find(TextureId))
+        const FIntPoint Key(TextureId, LightmapPage);
+        if (const int32* Found = Chunk.TextureAndPageToSlot.Find(Key))
         {
             return *Found;
         }
 
         const int32 NewSlot = Chunk.SlotToTextureId.Num();
         Chunk.SlotToTextureId.Add(TextureId);
-        Chunk.TextureIdToSlot.Add(TextureId, NewSlot);
+        Chunk.SlotToLightmapPage.Add(LightmapPage);
+        Chunk.TextureAndPageToSlot.Add(Key, NewSlot);
         return NewSlot;
     }
 
+    FString GetLightmapPageMaterialName(const FString& TextureName, int32 Page)
+    {
+        return FString::Printf(TEXT("%s@LM%d"), *TextureName, Page);
+    }
+
     static uint32 GetOrAddLocalVertex(FWorldChunkBuild& Chunk, const bspformat29::Bsp_29& Model, int32 BspVertexIndex, float ImportScale)
     {
         if (const int32* Found = Chunk.BspVertexToLocal.Find(BspVertexIndex))
@@ -740,6 +787,23 @@ struct FFaceLightmapCalc
     int32 W = 0;
     int32 H = 0;
     int32 LightOfs = -1;
+    // Lightmaps stored one after another at LightOfs, one per used entry of Face.styles.
+    int32 NumStyles = 1;
+    // Luxels from one style lightmap to the next; W * H unless the face was collapsed to one luxel.
+    int32 StyleStride = 0;
+    bool bUniform = false;
+    FColor Styles = FColor(0, 0, 0, 0);
+    int32 Group = -1;
+};
+
+// Face whose luxels match a packed face, and which reuses its atlas rect.
+struct FSharedFaceLightmap
+{
+    int32 FaceIndex = -1;
+    int32 OwnerFaceIndex = -1;
+    int32 TexMinS = 0;
+    int32 TexMinT = 0;
+    FColor Styles = FColor(0, 0, 0, 0);
 };
 
 static void ComputeFaceLightmapDimensions(const bspformat29::Bsp_29& Model, int32 FaceIndex, int32& OutTexMinS, int32& OutTexMinT, int32& OutW, int32& OutH)
@@ -824,42 +888,419 @@ static void ComputeFaceLightmapDimensions(const bspformat29::Bsp_29& Model, int3
     OutH = (ExtT / 16) + 1;
 }
 
-bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& LightmapsPath, const FString& MapName, const FString& LitFilePath, bool bOverwrite, FLightmapAtlas& OutAtlas)
+// Luxels of padding around every face lightmap, filled with its edge luxels.
+static constexpr int32 LightmapPad = 2;
+static constexpr int32 MinLightmapPageSize = 256;
+// Pages of face groups only hold one chunk or cluster, so they may be much smaller.
+static constexpr int32 MinLightmapGroupPageSize = 32;
+static constexpr int32 MaxLightmapPageSize = 4096;
+// Spread of luxel values, per channel and style, under which a face lightmap is collapsed to a single luxel.
+static constexpr int32 UniformLightmapTolerance = 2;
+
+// Mips kept when FLightmapAtlasSettings::bMips is set: mip 1 still has one texel of padding, further mips would
+// bleed neighbouring lightmaps in. Face rects are aligned to the size of a texel of the last mip.
+static constexpr int32 LightmapMipCount = 2;
+static constexpr int32 LightmapMipAlign = 1 << (LightmapMipCount - 1);
+
+// Lightmap row kernels. Count luxels from Src (RGB8 or 8-bit mono) become opaque BGRA8 at Dst.
+static void ConvertLitRowToBGRA(const uint8* Src, uint8* Dst, int32 Count)
 {
-    OutAtlas = FLightmapAtlas();
+    int32 I = 0;
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+    // 4 luxels per shuffle. Loads read 16 of the 12 bytes used, so stop while the whole load stays in the row.
+    const __m128i Shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i Alpha = _mm_set1_epi32(int32(0xFF000000));
+    for (; I + 6 <= Count; I += 4)
+    {
+        const __m128i Rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + I * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + I * 4), _mm_or_si128(_mm_shuffle_epi8(Rgb, Shuffle), Alpha));
+    }
+#elif PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+    for (; I + 16 <= Count; I += 16)
+    {
+        const uint8x16x3_t Rgb = vld3q_u8(Src + I * 3);
+        uint8x16x4_t Bgra;
+        Bgra.val[0] = Rgb.val[2];
+        Bgra.val[1] = Rgb.val[1];
+        Bgra.val[2] = Rgb.val[0];
+        Bgra.val[3] = vdupq_n_u8(255);
+        vst4q_u8(Dst + I * 4, Bgra);
+    }
+#endif
+    for (; I < Count; I++)
+    {
+        Dst[I * 4 + 0] = Src[I * 3 + 2];
+        Dst[I * 4 + 1] = Src[I * 3 + 1];
+        Dst[I * 4 + 2] = Src[I * 3 + 0];
+        Dst[I * 4 + 3] = 255;
+    }
+}
 
-    if (Model.lightdata.Num() == 0)
+static void ConvertMonoRowToBGRA(const uint8* Src, uint8* Dst, int32 Count)
+{
+    int32 I = 0;
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+    const __m128i Alpha = _mm_set1_epi32(int32(0xFF000000));
+    const __m128i Shuffles[4] = {
+        _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1),
+        _mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1),
+        _mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1),
+        _mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1) };
+    for (; I + 16 <= Count; I += 16)
+    {
+        const __m128i Mono = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + I));
+        for (int32 Part = 0; Part < 4; Part++)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + (I + Part * 4) * 4), _mm_or_si128(_mm_shuffle_epi8(Mono, Shuffles[Part]), Alpha));
+        }
+    }
+#elif PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+    for (; I + 16 <= Count; I += 16)
+    {
+        const uint8x16_t Mono = vld1q_u8(Src + I);
+        uint8x16x4_t Bgra;
+        Bgra.val[0] = Mono;
+        Bgra.val[1] = Mono;
+        Bgra.val[2] = Mono;
+        Bgra.val[3] = vdupq_n_u8(255);
+        vst4q_u8(Dst + I * 4, Bgra);
+    }
+#endif
+    for (; I < Count; I++)
+    {
+        Dst[I * 4 + 0] = Src[I];
+        Dst[I * 4 + 1] = Src[I];
+        Dst[I * 4 + 2] = Src[I];
+        Dst[I * 4 + 3] = 255;
+    }
+}
+
+// Fills the border around a W x H rect at (X, Y) of a BGRA8 image with copies of its edge texels: LightmapPad
+// texels left and top, PadRight and PadBottom (LightmapPad plus mip alignment) right and bottom. Edge columns are
+// replicated across each row, then the first and last rows (border included) are copied out.
+static void FillLightmapPadding(uint8* Pixels, int32 Stride, int32 X, int32 Y, int32 W, int32 H, int32 PadRight, int32 PadBottom)
+{
+    for (int32 Row = 0; Row < H; Row++)
+    {
+        uint32* Line = reinterpret_cast<uint32*>(Pixels + (int64(Y + Row) * Stride + X) * 4);
+        const uint32 Left = Line[0];
+        const uint32 Right = Line[W - 1];
+        for (int32 Pad = 1; Pad <= LightmapPad; Pad++)
+        {
+            Line[-Pad] = Left;
+        }
+        for (int32 Pad = 1; Pad <= PadRight; Pad++)
+        {
+            Line[W - 1 + Pad] = Right;
+        }
+    }
+
+    const int32 RowBytes = (LightmapPad + W + PadRight) * 4;
+    const uint8* First = Pixels + (int64(Y) * Stride + X - LightmapPad) * 4;
+    const uint8* Last = Pixels + (int64(Y + H - 1) * Stride + X - LightmapPad) * 4;
+    for (int32 Pad = 1; Pad <= LightmapPad; Pad++)
+    {
+        FMemory::Memcpy(Pixels + (int64(Y - Pad) * Stride + X - LightmapPad) * 4, First, RowBytes);
+    }
+    for (int32 Pad = 1; Pad <= PadBottom; Pad++)
+    {
+        FMemory::Memcpy(Pixels + (int64(Y + H - 1 + Pad) * Stride + X - LightmapPad) * 4, Last, RowBytes);
+    }
+}
+
+// Bottom-left skyline packer for one atlas page of fixed width. Single pass: each rect goes where its top
+// edge ends lowest, ties broken by the narrowest segment, so the skyline stays flat and little space is wasted.
+class FSkylinePacker
+{
+public:
+    FSkylinePacker(int32 InWidth, int32 InMaxHeight)
+        : Width(InWidth)
+        , MaxHeight(InMaxHeight)
+    {
+        Skyline.Add({ 0, 0, Width });
+    }
+
+    bool Insert(int32 W, int32 H, int32& OutX, int32& OutY)
+    {
+        int32 BestIndex = INDEX_NONE;
+        int32 BestTop = MAX_int32;
+        int32 BestSegmentWidth = MAX_int32;
+        int32 BestY = 0;
+
+        for (int32 I = 0; I < Skyline.Num(); I++)
+        {
+            int32 Y = 0;
+            if (!Fits(I, W, H, Y))
+            {
+                continue;
+            }
+            if (Y + H < BestTop || (Y + H == BestTop && Skyline[I].W < BestSegmentWidth))
+            {
+                BestIndex = I;
+                BestTop = Y + H;
+                BestSegmentWidth = Skyline[I].W;
+                BestY = Y;
+            }
+        }
+
+        if (BestIndex == INDEX_NONE)
+        {
+            return false;
+        }
+
+        OutX = Skyline[BestIndex].X;
+        OutY = BestY;
+        AddLevel(BestIndex, OutX, BestY + H, W);
+        UsedHeight = FMath::Max(UsedHeight, BestY + H);
+        return true;
+    }
+
+    int32 GetUsedHeight() const { return UsedHeight; }
+
+private:
+    struct FSegment
+    {
+        int32 X;
+        int32 Y;
+        int32 W;
+    };
+
+    // Height at which a W x H rect starting at segment Index rests on the skyline.
+    bool Fits(int32 Index, int32 W, int32 H, int32& OutY) const
+    {
+        if (Skyline[Index].X + W > Width)
+        {
+            return false;
+        }
+
+        int32 Remaining = W;
+        OutY = 0;
+        for (int32 I = Index; Remaining > 0; I++)
+        {
+            OutY = FMath::Max(OutY, Skyline[I].Y);
+            if (OutY + H > MaxHeight)
+            {
+                return false;
+            }
+            Remaining -= Skyline[I].W;
+        }
+        return true;
+    }
+
+    void AddLevel(int32 Index, int32 X, int32 Y, int32 W)
+    {
+        Skyline.Insert({ X, Y, W }, Index);
+
+        // Trim or remove the segments now covered by the new one.
+        for (int32 I = Index + 1; I < Skyline.Num(); )
+        {
+            const int32 Covered = Skyline[Index].X + Skyline[Index].W - Skyline[I].X;
+            if (Covered <= 0)
+            {
+                break;
+            }
+            if (Covered < Skyline[I].W)
+            {
+                Skyline[I].X += Covered;
+                Skyline[I].W -= Covered;
+                break;
+            }
+            Skyline.RemoveAt(I, EAllowShrinking::No);
+        }
+
+        // Merge neighbours of equal height.
+        for (int32 I = 0; I + 1 < Skyline.Num(); )
+        {
+            if (Skyline[I].Y == Skyline[I + 1].Y)
+            {
+                Skyline[I].W += Skyline[I + 1].W;
+                Skyline.RemoveAt(I + 1, EAllowShrinking::No);
+            }
+            else
+            {
+                I++;
+            }
+        }
+    }
+
+    TArray<FSegment> Skyline;
+    int32 Width = 0;
+    int32 MaxHeight = 0;
+    int32 UsedHeight = 0;
+};
+
+// RGB luxels of a QLIT v1 file matching the BSP light lump. False when there is no valid .lit.
+static bool LoadLitFile(const bspformat29::Bsp_29& Model, const FString& LitFilePath, TArray<uint8>& OutRgb)
+{
+    OutRgb.Reset();
+    if (LitFilePath.IsEmpty())
     {
         return false;
     }
 
-    TArray<uint8> LitRgbData;
-    bool bUseLit = false;
-    if (!LitFilePath.IsEmpty())
+    FString LitAbs = LitFilePath;
+    if (FPaths::IsRelative(LitAbs))
+    {
+        LitAbs = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), LitAbs);
+    }
+
+    TArray<uint8> LitFile;
+    if (!FFileHelper::LoadFileToArray(LitFile, *LitAbs))
+    {
+        return false;
+    }
+
+    const int32 HeaderSize = 8;
+    if (LitFile.Num() < HeaderSize)
+    {
+        return false;
+    }
+
+    const char* Magic = reinterpret_cast<const char*>(LitFile.GetData());
+    int32 Version = 0;
+    FMemory::Memcpy(&Version, LitFile.GetData() + 4, sizeof(int32));
+    const int64 Expected = int64(Model.lightdata.Num()) * 3;
+    const int64 Payload = int64(LitFile.Num()) - HeaderSize;
+    if (FMemory::Memcmp(Magic, "QLIT", 4) != 0 || Version != 1 || Payload != Expected)
+    {
+        return false;
+    }
+
+    OutRgb.Append(LitFile.GetData() + HeaderSize, int32(Expected));
+    return true;
+}
+
+// Collapses near uniform face lightmaps to their centre luxel, then keeps one face per set of identical
+// luxel blocks (same group, size and styles) and moves the others to OutShared.
+static void DeduplicateFaceLightmaps(const TArray<uint8>& Luxels, int32 BytesPerLuxel, TArray<FFaceLightmapCalc>& InOutFaces, TArray<FSharedFaceLightmap>& OutShared)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::DeduplicateFaceLightmaps);
+
+    auto GetStyleBlock = [&Luxels, BytesPerLuxel](const FFaceLightmapCalc& F, int32 Style)
     {
-        FString LitAbs = LitFilePath;
-        if (FPaths::IsRelative(LitAbs))
+        return Luxels.GetData() + (int64(F.LightOfs) + int64(Style) * F.StyleStride) * BytesPerLuxel;
+    };
+
+    TArray<uint64> Hashes;
+    Hashes.SetNumUninitialized(InOutFaces.Num());
+    ParallelFor(InOutFaces.Num(), [&](int32 Index)
+    {
+        FFaceLightmapCalc& F = InOutFaces[Index];
+        const int32 NumLuxels = F.W * F.H;
+
+        bool bUniform = true;
+        for (int32 Style = 0; Style < F.NumStyles && bUniform; Style++)
+        {
+            const uint8* Block = GetStyleBlock(F, Style);
+            for (int32 Channel = 0; Channel < BytesPerLuxel && bUniform; Channel++)
+            {
+                int32 Min = 255;
+                int32 Max = 0;
+                for (int32 Luxel = 0; Luxel < NumLuxels; Luxel++)
+                {
+                    const int32 Value = Block[Luxel * BytesPerLuxel + Channel];
+                    Min = FMath::Min(Min, Value);
+                    Max = FMath::Max(Max, Value);
+                }
+                bUniform = Max - Min <= UniformLightmapTolerance;
+            }
+        }
+
+        if (bUniform && NumLuxels > 1)
+        {
+            F.LightOfs += (F.H / 2) * F.W + F.W / 2;
+            F.W = 1;
+            F.H = 1;
+            F.bUniform = true;
+        }
+
+        FXxHash64Builder Builder;
+        const int32 Header[4] = { F.Group, F.W, F.H, F.NumStyles };
+        Builder.Update(Header, sizeof(Header));
+        for (int32 Style = 0; Style < F.NumStyles; Style++)
         {
-            LitAbs = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), LitAbs);
+            Builder.Update(GetStyleBlock(F, Style), uint64(F.W) * F.H * BytesPerLuxel);
         }
+        Hashes[Index] = Builder.Finalize().Hash;
+    });
 
-        TArray<uint8> LitFile;
-        if (FFileHelper::LoadFileToArray(LitFile, *LitAbs))
+    auto SameLuxels = [&](const FFaceLightmapCalc& A, const FFaceLightmapCalc& B)
+    {
+        if (A.Group != B.Group || A.W != B.W || A.H != B.H || A.NumStyles != B.NumStyles)
         {
-            const int32 HeaderSize = 8;
-            if (LitFile.Num() >= HeaderSize)
+            return false;
+        }
+        for (int32 Style = 0; Style < A.NumStyles; Style++)
+        {
+            if (FMemory::Memcmp(GetStyleBlock(A, Style), GetStyleBlock(B, Style), SIZE_T(A.W) * A.H * BytesPerLuxel) != 0)
             {
-                const char* Magic = reinterpret_cast<const char*>(LitFile.GetData());
-                int32 Version = 0;
-                FMemory::Memcpy(&Version, LitFile.GetData() + 4, sizeof(int32));
-                const int64 Expected = int64(Model.lightdata.Num()) * 3;
-                const int64 Payload = int64(LitFile.Num()) - HeaderSize;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    TArray<FFaceLightmapCalc> Unique;
+    Unique.Reserve(InOutFaces.Num());
+    TMap<uint64, TArray<int32, TInlineAllocator<1>>> UniqueByHash;
+    UniqueByHash.Reserve(InOutFaces.Num());
+    int32 NumUniform = 0;
+    for (int32 Index = 0; Index < InOutFaces.Num(); Index++)
+    {
+        const FFaceLightmapCalc& F = InOutFaces[Index];
+        NumUniform += F.bUniform ? 1 : 0;
+
+        TArray<int32, TInlineAllocator<1>>& Candidates = UniqueByHash.FindOrAdd(Hashes[Index]);
+        const int32* Owner = Candidates.FindByPredicate([&](int32 UniqueIndex) { return SameLuxels(Unique[UniqueIndex], F); });
+        if (Owner)
+        {
+            OutShared.Add({ F.FaceIndex, Unique[*Owner].FaceIndex, F.TexMinS, F.TexMinT, F.Styles });
+            continue;
+        }
+        Candidates.Add(Unique.Num());
+        Unique.Add(F);
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("BSP Import: %d face lightmaps collapsed to one luxel, %d of %d share the rect of an identical one"),
+        NumUniform, OutShared.Num(), InOutFaces.Num());
+    InOutFaces = MoveTemp(Unique);
+}
+
+void LoadVertexLighting(const bspformat29::Bsp_29& Model, const FString& LitFilePath, bool bTessellate, FVertexLighting& OutLighting)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::LoadVertexLighting);
+
+    OutLighting = FVertexLighting();
+    OutLighting.bTessellate = bTessellate;
+    LoadLitFile(Model, LitFilePath, OutLighting.LitRgb);
+}
+
+bool PackLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& LitFilePath, const FLightmapAtlasSettings& Settings, FLightmapAtlas& OutAtlas, const TArray<FLightmapFaceGroup>* Groups)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::PackLightmapAtlas);
+
+    OutAtlas = FLightmapAtlas();
+
+    if (Model.lightdata.Num() == 0)
+    {
+        return false;
+    }
+
+    TArray<uint8> LitRgbData;
+    const bool bUseLit = LoadLitFile(Model, LitFilePath, LitRgbData);
 
-                if (FMemory::Memcmp(Magic, "QLIT", 4) == 0 && Version == 1 && Payload == Expected)
+    // With groups, only grouped faces are packed, a face belonging to the first group that lists it.
+    TArray<int32> FaceGroup;
+    if (Groups)
+    {
+        FaceGroup.Init(-1, Model.faces.Num());
+        for (int32 GroupIndex = Groups->Num() - 1; GroupIndex >= 0; GroupIndex--)
+        {
+            for (const int32 FaceIndex : (*Groups)[GroupIndex].FaceIndices)
+            {
+                if (FaceGroup.IsValidIndex(FaceIndex))
                 {
-                    LitRgbData.Reset(int32(Expected));
-                    LitRgbData.Append(LitFile.GetData() + HeaderSize, int32(Expected));
-                    bUseLit = true;
+                    FaceGroup[FaceIndex] = GroupIndex;
                 }
             }
         }
@@ -871,7 +1312,7 @@ bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& Lightma
     for (int32 FaceIndex = 0; FaceIndex < Model.faces.Num(); FaceIndex++)
     {
         const bspformat29::Face& Face = Model.faces[FaceIndex];
-        if (Face.lightofs < 0)
+        if (Face.lightofs < 0 || (Groups && FaceGroup[FaceIndex] < 0))
         {
             continue;
         }
@@ -891,8 +1332,19 @@ bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& Lightma
             continue;
         }
 
-        const int64 BytesNeeded = int64(Face.lightofs) + int64(W) * int64(H);
-        if (BytesNeeded > int64(Model.lightdata.Num()))
+        // Used styles are the leading entries before the first 255.
+        int32 NumStyles = 1;
+        while (Settings.bLightStyles && NumStyles < 4 && uint8(Face.styles[NumStyles]) != 255)
+        {
+            NumStyles++;
+        }
+
+        // Drop trailing styles the lump is too short for rather than the whole face.
+        while (NumStyles > 0 && int64(Face.lightofs) + int64(W) * int64(H) * NumStyles > int64(Model.lightdata.Num()))
+        {
+            NumStyles--;
+        }
+        if (NumStyles == 0)
         {
             continue;
         }
@@ -904,6 +1356,11 @@ bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& Lightma
         Info.W = W;
         Info.H = H;
         Info.LightOfs = Face.lightofs;
+        Info.NumStyles = NumStyles;
+        Info.StyleStride = W * H;
+        Info.Group = Groups ? FaceGroup[FaceIndex] : -1;
+        Info.Styles = FColor(uint8(Face.styles[0]), NumStyles > 1 ? uint8(Face.styles[1]) : 0, NumStyles > 2 ? uint8(Face.styles[2]) : 0, NumStyles > 3 ? uint8(Face.styles[3]) : 0);
+        OutAtlas.NumStyleLayers = FMath::Max(OutAtlas.NumStyleLayers, NumStyles);
         Faces.Add(Info);
     }
 
@@ -912,243 +1369,456 @@ bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& Lightma
         return false;
     }
 
-    Faces.Sort([](const FFaceLightmapCalc& A, const FFaceLightmapCalc& B)
+    // Uniform and repeated lightmaps are common (flat lit rooms, coplanar neighbours), so each is packed once.
+    TArray<FSharedFaceLightmap> SharedFaces;
+    DeduplicateFaceLightmaps(bUseLit ? LitRgbData : Model.lightdata, bUseLit ? 3 : 1, Faces, SharedFaces);
+
+    OutAtlas.Settings = Settings;
+
+    // Rect of a face in the atlas, padding included.
+    const int32 RectAlign = Settings.bMips ? LightmapMipAlign : 1;
+    auto GetRectSize = [RectAlign](int32 Size)
+    {
+        return Align(Size + LightmapPad * 2, RectAlign);
+    };
+
+    // Faces of one page are sorted tallest first; on multi-page maps each page gets a contiguous run of
+    // faces (BSP face order is spatially coherent) so a chunk rarely spans pages and grows extra sections.
+    int64 TotalArea = 0;
+    for (const FFaceLightmapCalc& F : Faces)
+    {
+        TotalArea += int64(GetRectSize(F.W)) * int64(GetRectSize(F.H));
+    }
+
+    const int64 PageCapacity = int64(double(MaxLightmapPageSize) * MaxLightmapPageSize * 0.85);
+    const int32 NumGroups = int32(FMath::Max<int64>(1, (TotalArea + PageCapacity - 1) / PageCapacity));
+    const int32 PageWidth = NumGroups > 1 ? MaxLightmapPageSize
+        : FMath::Clamp(int32(FMath::RoundUpToPowerOfTwo(uint32(FMath::CeilToInt(FMath::Sqrt(double(TotalArea)))))), MinLightmapPageSize, MaxLightmapPageSize);
+
+    auto TallestFirst = [](const FFaceLightmapCalc& A, const FFaceLightmapCalc& B)
     {
         if (A.H != B.H)
         {
             return A.H > B.H;
         }
         return A.W > B.W;
-    });
+    };
 
-    const int32 MaxAtlasSize = 4096;
-    int32 AtlasSize = 1024;
-    bool bPacked = false;
+    if (Groups)
+    {
+        // Each face group starts a page of its own, sized for the group alone.
+        Faces.Sort([&TallestFirst](const FFaceLightmapCalc& A, const FFaceLightmapCalc& B)
+        {
+            return A.Group != B.Group ? A.Group < B.Group : TallestFirst(A, B);
+        });
+    }
+    else if (NumGroups == 1)
+    {
+        Faces.Sort(TallestFirst);
+    }
+    else
+    {
+        const int64 GroupArea = (TotalArea + NumGroups - 1) / NumGroups;
+        int32 GroupStart = 0;
+        int64 Area = 0;
+        for (int32 I = 0; I < Faces.Num(); I++)
+        {
+            Area += int64(GetRectSize(Faces[I].W)) * int64(GetRectSize(Faces[I].H));
+            if (Area >= GroupArea || I == Faces.Num() - 1)
+            {
+                Algo::Sort(TArrayView<FFaceLightmapCalc>(Faces.GetData() + GroupStart, I + 1 - GroupStart), TallestFirst);
+                GroupStart = I + 1;
+                Area = 0;
+            }
+        }
+    }
 
     struct FPlaced
     {
         int32 FaceIndex = -1;
+        int32 Page = 0;
         int32 X = 0;
         int32 Y = 0;
         int32 W = 0;
         int32 H = 0;
+        int32 PadRight = LightmapPad;
+        int32 PadBottom = LightmapPad;
         int32 TexMinS = 0;
         int32 TexMinT = 0;
         int32 LightOfs = -1;
+        int32 NumStyles = 1;
+        int32 StyleStride = 0;
+        FColor Styles = FColor(0, 0, 0, 0);
     };
 
-    TArray<FPlaced> Placed;
-
-    while (AtlasSize <= MaxAtlasSize && !bPacked)
+    struct FPageLayout
     {
-        Placed.Reset();
-
-        int32 CursorX = 0;
-        int32 CursorY = 0;
-        int32 RowH = 0;
-
-        bool bFail = false;
+        int32 Width = 0;
+        int32 UsedHeight = 0;
+        int32 Group = -1;
+    };
 
-        for (const FFaceLightmapCalc& F : Faces)
+    // Narrowest power of two page that fits the faces of the group starting at First, roughly square.
+    auto GetGroupPageWidth = [&](int32 First)
+    {
+        int64 Area = 0;
+        int32 MaxRectW = 0;
+        for (int32 I = First; I < Faces.Num() && Faces[I].Group == Faces[First].Group; I++)
         {
-            const int32 Pad = 2;
-            const int32 RW = F.W + Pad * 2;
-            const int32 RH = F.H + Pad * 2;
-
-            if (RW > AtlasSize || RH > AtlasSize)
-            {
-                bFail = true;
-                break;
-            }
-
-            if (CursorX + RW > AtlasSize)
-            {
-                CursorX = 0;
-                CursorY += RowH;
-                RowH = 0;
-            }
+            Area += int64(GetRectSize(Faces[I].W)) * int64(GetRectSize(Faces[I].H));
+            MaxRectW = FMath::Max(MaxRectW, GetRectSize(Faces[I].W));
+        }
+        const int32 Side = FMath::Max(FMath::CeilToInt(FMath::Sqrt(double(Area))), MaxRectW);
+        return FMath::Clamp(int32(FMath::RoundUpToPowerOfTwo(uint32(Side))), MinLightmapGroupPageSize, MaxLightmapPageSize);
+    };
 
-            if (CursorY + RH > AtlasSize)
+    TArray<FPlaced> Placed;
+    Placed.Reserve(Faces.Num());
+    TArray<FPageLayout> PageLayouts;
+    int32 CurrentWidth = PageWidth;
+    int32 CurrentGroup = -1;
+    FSkylinePacker Packer(PageWidth, MaxLightmapPageSize);
+    int32 NumSkipped = 0;
+
+    for (int32 FaceIt = 0; FaceIt < Faces.Num(); FaceIt++)
+    {
+        const FFaceLightmapCalc& F = Faces[FaceIt];
+        if (F.Group != CurrentGroup)
+        {
+            if (CurrentGroup >= 0)
             {
-                bFail = true;
-                break;
+                PageLayouts.Add({ CurrentWidth, Packer.GetUsedHeight(), CurrentGroup });
             }
-
-            FPlaced P;
-            P.FaceIndex = F.FaceIndex;
-            P.X = CursorX + Pad;
-            P.Y = CursorY + Pad;
-            P.W = F.W;
-            P.H = F.H;
-            P.TexMinS = F.TexMinS;
-            P.TexMinT = F.TexMinT;
-            P.LightOfs = F.LightOfs;
-            Placed.Add(P);
-
-            CursorX += RW;
-            RowH = FMath::Max(RowH, RH);
+            CurrentGroup = F.Group;
+            CurrentWidth = GetGroupPageWidth(FaceIt);
+            Packer = FSkylinePacker(CurrentWidth, MaxLightmapPageSize);
         }
 
-        if (!bFail)
+        const int32 RW = GetRectSize(F.W);
+        const int32 RH = GetRectSize(F.H);
+        if (RW > CurrentWidth || RH > MaxLightmapPageSize)
         {
-            bPacked = true;
-            break;
+            NumSkipped++;
+            continue;
         }
 
-        AtlasSize *= 2;
-    }
+        int32 X = 0;
+        int32 Y = 0;
+        if (!Packer.Insert(RW, RH, X, Y))
+        {
+            // Page full: close it and spill into a new one. Earlier pages are not revisited, to keep pages coherent.
+            PageLayouts.Add({ CurrentWidth, Packer.GetUsedHeight(), CurrentGroup });
+            Packer = FSkylinePacker(CurrentWidth, MaxLightmapPageSize);
+            verify(Packer.Insert(RW, RH, X, Y));
+        }
 
-    if (!bPacked)
-    {
-        UE_LOG(LogTemp, Warning, TEXT("BSP Import: Could not pack lightmaps into an atlas (too large)"));
-        return false;
+        FPlaced P;
+        P.FaceIndex = F.FaceIndex;
+        P.Page = PageLayouts.Num();
+        P.X = X + LightmapPad;
+        P.Y = Y + LightmapPad;
+        P.W = F.W;
+        P.H = F.H;
+        P.PadRight = RW - F.W - LightmapPad;
+        P.PadBottom = RH - F.H - LightmapPad;
+        P.TexMinS = F.TexMinS;
+        P.TexMinT = F.TexMinT;
+        P.LightOfs = F.LightOfs;
+        P.NumStyles = F.NumStyles;
+        P.StyleStride = F.StyleStride;
+        P.Styles = F.Styles;
+        Placed.Add(P);
     }
+    PageLayouts.Add({ CurrentWidth, Packer.GetUsedHeight(), CurrentGroup });
 
-    OutAtlas.AtlasW = AtlasSize;
-    OutAtlas.AtlasH = AtlasSize;
-
-    TArray<uint8> AtlasData;
-    TArray<uint8> AtlasDataBGRA;
-    if (bUseLit)
+    if (NumSkipped > 0)
     {
-        AtlasDataBGRA.SetNumZeroed(AtlasSize * AtlasSize * 4);
+        UE_LOG(LogTemp, Warning, TEXT("BSP Import: %d face lightmaps are larger than an atlas page and were left unlit"), NumSkipped);
     }
-    else
+    if (Placed.Num() == 0)
     {
-        AtlasData.SetNumZeroed(AtlasSize * AtlasSize);
+        return false;
     }
 
-    for (const FPlaced& P : Placed)
+    // Pages are only as tall as their content, rounded up to a power of two.
+    for (int32 PageIndex = 0; PageIndex < PageLayouts.Num(); PageIndex++)
     {
-        const int32 FaceIndex = P.FaceIndex;
-        FLightmapAtlasFace FaceInfo;
+        const FPageLayout& Layout = PageLayouts[PageIndex];
+        FLightmapAtlasPage& Page = OutAtlas.Pages.AddDefaulted_GetRef();
+        Page.Width = Layout.Width;
+        Page.Height = FMath::Clamp(int32(FMath::RoundUpToPowerOfTwo(uint32(FMath::Max(Layout.UsedHeight, 1)))), 4, MaxLightmapPageSize);
+        if (Groups && Layout.Group >= 0)
+        {
+            int32 GroupPage = 0;
+            while (GroupPage < PageIndex && PageLayouts[PageIndex - GroupPage - 1].Group == Layout.Group)
+            {
+                GroupPage++;
+            }
+            const FString& GroupName = (*Groups)[Layout.Group].Name;
+            Page.GroupName = GroupPage == 0 ? GroupName : FString::Printf(TEXT("%s_%d"), *GroupName, GroupPage);
+        }
+
+        // Mono lightmaps are expanded to gray BGRA so both sources share one texture path.
+        Page.Pixels.SetNumZeroed(Page.Width * Page.Height * 4);
+        INC_DWORD_STAT(STAT_QuakeImport_LightmapAtlases);
+        INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, Page.Pixels.Num());
+
+        for (int32 Layer = 1; Layer < OutAtlas.NumStyleLayers; Layer++)
+        {
+            FLightmapAtlasLayer& StyleLayer = Page.StyleLayers.AddDefaulted_GetRef();
+            StyleLayer.Pixels.SetNumZeroed(Page.Width * Page.Height * 4);
+            INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, StyleLayer.Pixels.Num());
+        }
+    }
+
+    OutAtlas.FaceToAtlas.SetNum(Model.faces.Num());
+    for (const FPlaced& P : Placed)
+    {
+        FLightmapAtlasFace& FaceInfo = OutAtlas.FaceToAtlas[P.FaceIndex];
+        FaceInfo.Page = P.Page;
         FaceInfo.X = P.X;
         FaceInfo.Y = P.Y;
         FaceInfo.W = P.W;
         FaceInfo.H = P.H;
         FaceInfo.TexMinS = P.TexMinS;
         FaceInfo.TexMinT = P.TexMinT;
-        OutAtlas.FaceToAtlas.Add(FaceIndex, FaceInfo);
+        FaceInfo.Styles = P.Styles;
+    }
 
-        const int32 SrcOfs = P.LightOfs;
-        for (int32 Y = 0; Y < P.H; Y++)
+    for (const FSharedFaceLightmap& Shared : SharedFaces)
+    {
+        const FLightmapAtlasFace& Owner = OutAtlas.FaceToAtlas[Shared.OwnerFaceIndex];
+        if (Owner.Page != INDEX_NONE)
+        {
+            FLightmapAtlasFace& FaceInfo = OutAtlas.FaceToAtlas[Shared.FaceIndex];
+            FaceInfo = Owner;
+            FaceInfo.TexMinS = Shared.TexMinS;
+            FaceInfo.TexMinT = Shared.TexMinT;
+            FaceInfo.Styles = Shared.Styles;
+        }
+    }
+
+    // Luxel (S - TexMinS) / 16 of a face sits at texel X + luxel + 0.5 of its page.
+    for (FLightmapAtlasFace& FaceInfo : OutAtlas.FaceToAtlas)
+    {
+        if (FaceInfo.Page == INDEX_NONE)
+        {
+            continue;
+        }
+        const FLightmapAtlasPage& Page = OutAtlas.Pages[FaceInfo.Page];
+        const FVector2f PageSize(float(Page.Width), float(Page.Height));
+        const FVector2f Origin(float(FaceInfo.X) + 0.5f, float(FaceInfo.Y) + 0.5f);
+        FaceInfo.UVScale = FVector2f(1.0f / 16.0f) / PageSize;
+        FaceInfo.UVBias = (Origin - FVector2f(float(FaceInfo.TexMinS), float(FaceInfo.TexMinT)) / 16.0f) / PageSize;
+        FaceInfo.UVMin = Origin / PageSize;
+        FaceInfo.UVMax = (Origin + FVector2f(float(FaceInfo.W - 1), float(FaceInfo.H - 1))) / PageSize;
+    }
+
+    // Face rects, padding included, never overlap, so faces are blitted in parallel. Each style slot goes to
+    // its own layer; the padding is filled once the luxels are in.
+    ParallelFor(Placed.Num(), [&](int32 PlacedIndex)
+    {
+        const FPlaced& P = Placed[PlacedIndex];
+        FLightmapAtlasPage& Page = OutAtlas.Pages[P.Page];
+        const int32 NumStyles = FMath::Min(P.NumStyles, OutAtlas.NumStyleLayers);
+
+        for (int32 Style = 0; Style < NumStyles; Style++)
         {
-            const int32 SrcRow = SrcOfs + Y * P.W;
-            const int32 DstRow = (P.Y + Y) * AtlasSize + P.X;
-            for (int32 X = 0; X < P.W; X++)
+            const int64 SrcOfs = int64(P.LightOfs) + int64(Style) * P.StyleStride;
+            uint8* Layer = Style == 0 ? Page.Pixels.GetData() : Page.StyleLayers[Style - 1].Pixels.GetData();
+            for (int32 Y = 0; Y < P.H; Y++)
             {
+                uint8* Dst = Layer + (int64(P.Y + Y) * Page.Width + P.X) * 4;
                 if (bUseLit)
                 {
-                    const int32 SrcIdx = (SrcRow + X) * 3;
-                    const int32 DstIdx = (DstRow + X) * 4;
-                    AtlasDataBGRA[DstIdx + 0] = LitRgbData[SrcIdx + 2];
-                    AtlasDataBGRA[DstIdx + 1] = LitRgbData[SrcIdx + 1];
-                    AtlasDataBGRA[DstIdx + 2] = LitRgbData[SrcIdx + 0];
-                    AtlasDataBGRA[DstIdx + 3] = 255;
+                    ConvertLitRowToBGRA(LitRgbData.GetData() + (SrcOfs + int64(Y) * P.W) * 3, Dst, P.W);
                 }
                 else
                 {
-                    AtlasData[DstRow + X] = Model.lightdata[SrcRow + X];
+                    ConvertMonoRowToBGRA(Model.lightdata.GetData() + SrcOfs + int64(Y) * P.W, Dst, P.W);
                 }
             }
+
+            FillLightmapPadding(Layer, Page.Width, P.X, P.Y, P.W, P.H, P.PadRight, P.PadBottom);
         }
+    });
+
+    return true;
+}
+
+// Appends the box filtered mips to a BGRA8 mip 0. Returns the mip count.
+static int32 AppendLightmapMips(TArray<uint8>& InOutChain, int32 Width, int32 Height, int32 NumMips)
+{
+    int64 SrcOfs = 0;
+    int32 MipCount = 1;
+    for (; MipCount < NumMips && Width > 1 && Height > 1; MipCount++)
+    {
+        const int32 MipW = Width / 2;
+        const int32 MipH = Height / 2;
+        const int64 DstOfs = InOutChain.Num();
+        InOutChain.AddUninitialized(MipW * MipH * 4);
 
-        // simple padding: duplicate edge luxels into the padding area
-        const int32 Pad = 2;
-        for (int32 Y = -Pad; Y < P.H + Pad; Y++)
+        const uint8* Src = InOutChain.GetData() + SrcOfs;
+        uint8* Dst = InOutChain.GetData() + DstOfs;
+        for (int32 Y = 0; Y < MipH; Y++)
         {
-            const int32 SrcY = FMath::Clamp(Y, 0, P.H - 1);
-            for (int32 X = -Pad; X < P.W + Pad; X++)
+            const uint8* Row0 = Src + int64(Y * 2) * Width * 4;
+            const uint8* Row1 = Row0 + int64(Width) * 4;
+            for (int32 X = 0; X < MipW; X++)
             {
-                const int32 SrcX = FMath::Clamp(X, 0, P.W - 1);
-                const int32 DstX = P.X + X;
-                const int32 DstY = P.Y + Y;
-                if (DstX < 0 || DstY < 0 || DstX >= AtlasSize || DstY >= AtlasSize)
-                {
-                    continue;
-                }
-                if (bUseLit)
+                for (int32 C = 0; C < 4; C++)
                 {
-                    const int32 SrcIdx = (SrcOfs + SrcY * P.W + SrcX) * 3;
-                    const int32 DstIdx = (DstY * AtlasSize + DstX) * 4;
-                    AtlasDataBGRA[DstIdx + 0] = LitRgbData[SrcIdx + 2];
-                    AtlasDataBGRA[DstIdx + 1] = LitRgbData[SrcIdx + 1];
-                    AtlasDataBGRA[DstIdx + 2] = LitRgbData[SrcIdx + 0];
-                    AtlasDataBGRA[DstIdx + 3] = 255;
-                }
-                else
-                {
-                    const uint8 V = Model.lightdata[SrcOfs + SrcY * P.W + SrcX];
-                    AtlasData[DstY * AtlasSize + DstX] = V;
+                    const int32 Sum = Row0[X * 8 + C] + Row0[X * 8 + 4 + C] + Row1[X * 8 + C] + Row1[X * 8 + 4 + C];
+                    Dst[(int64(Y) * MipW + X) * 4 + C] = uint8((Sum + 2) / 4);
                 }
             }
         }
+
+        SrcOfs = DstOfs;
+        Width = MipW;
+        Height = MipH;
     }
+    return MipCount;
+}
 
-    const FString TexName = FString::Printf(TEXT("LM_%s"), *MapName);
-    const FString TexAssetName = TEXT("T_") + TexName;
-    UPackage* TexPkg = CreateAssetPackage(LightmapsPath / TexAssetName);
-    if (!TexPkg)
+static TextureCompressionSettings GetLightmapCompressionSettings(const FLightmapAtlas& Atlas)
+{
+    switch (Atlas.Settings.Encoding)
     {
-        return false;
+    case ELightmapEncoding::BC1:
+        return TC_Default;
+    case ELightmapEncoding::BC7:
+        return TC_BC7;
+    default:
+        return TC_VectorDisplacementmap;
     }
+}
 
-    UTexture2D* Tex = nullptr;
-    if (bUseLit)
+int64 GetLightmapAtlasBytes(const FLightmapAtlas& Atlas)
+{
+    int32 BitsPerTexel = 32;
+    switch (GetLightmapCompressionSettings(Atlas))
     {
-        Tex = QuakeCommon::CreateOrUpdateUTexture2DFromBGRA(TexName, AtlasSize, AtlasSize, AtlasDataBGRA, *TexPkg, bOverwrite);
+    case TC_Default:
+        BitsPerTexel = 4;
+        break;
+    case TC_BC7:
+        BitsPerTexel = 8;
+        break;
+    default:
+        break;
     }
-    else
+
+    int64 Bits = 0;
+    for (const FLightmapAtlasPage& Page : Atlas.Pages)
     {
-        TArray<QuakeCommon::QColor> GrayPalette;
-        GrayPalette.SetNumUninitialized(256);
-        for (int32 I = 0; I < 256; I++)
+        for (int32 Mip = 0; Mip < (Atlas.Settings.bMips ? LightmapMipCount : 1); Mip++)
         {
-            GrayPalette[I].r = uint8(I);
-            GrayPalette[I].g = uint8(I);
-            GrayPalette[I].b = uint8(I);
+            Bits += int64(FMath::Max(Page.Width >> Mip, 1)) * FMath::Max(Page.Height >> Mip, 1) * BitsPerTexel;
         }
-        Tex = QuakeCommon::CreateOrUpdateUTexture2D(TexName, AtlasSize, AtlasSize, AtlasData, *TexPkg, GrayPalette, bOverwrite, false);
     }
-    if (!Tex)
+    return Bits / 8 * Atlas.NumStyleLayers;
+}
+
+static UTexture2D* CreateLightmapPageTexture(const FString& LightmapsPath, const FString& TexName, int32 Width, int32 Height, const TArray<uint8>& Pixels, const FLightmapAtlas& Atlas, bool bOverwrite)
+{
+    if (Width <= 0 || Height <= 0 || Pixels.Num() != Width * Height * 4)
     {
-        return false;
+        return nullptr;
+    }
+
+    const FString TexAssetName = TEXT("T_") + TexName;
+    UPackage* TexPkg = CreateAssetPackage(LightmapsPath / TexAssetName);
+    if (!TexPkg)
+    {
+        return nullptr;
     }
 
-	// Lightmaps should be filterable (unlike most Quake palette textures).
-	Tex->PreEditChange(nullptr);
-	Tex->SRGB = false;
-	Tex->Filter = TF_Default;
-	Tex->LODGroup = TEXTUREGROUP_World;
-	Tex->MipGenSettings = TMGS_NoMipmaps;
-	Tex->CompressionSettings = TextureCompressionSettings::TC_VectorDisplacementmap;
-	Tex->NeverStream = true;
-	Tex->UpdateResource();
-	Tex->PostEditChange();
+    const bool bExisted = QuakeCommon::CheckIfAssetExist<UTexture2D>(TexAssetName, *TexPkg) != nullptr;
+    UTexture2D* Tex = QuakeCommon::CreateOrUpdateUTexture2DFromBGRA(TexName, Width, Height, Pixels, *TexPkg, bOverwrite);
+    if (!Tex || (bExisted && !bOverwrite))
+    {
+        return Tex;
+    }
 
-    OutAtlas.LightmapTextureObjectPath = Tex->GetPathName();
-    return true;
+    TArray<uint8> Chain = Pixels;
+    const int32 NumMips = AppendLightmapMips(Chain, Width, Height, Atlas.Settings.bMips ? LightmapMipCount : 1);
+
+    // Lightmaps should be filterable (unlike most Quake palette textures).
+    Tex->PreEditChange(nullptr);
+    Tex->Source.Init(Width, Height, 1, NumMips, TSF_BGRA8, Chain.GetData());
+    Tex->SRGB = false;
+    Tex->Filter = TF_Default;
+    Tex->LODGroup = TEXTUREGROUP_World;
+    Tex->MipGenSettings = NumMips > 1 ? TMGS_LeaveExistingMips : TMGS_NoMipmaps;
+    Tex->CompressionSettings = GetLightmapCompressionSettings(Atlas);
+    Tex->CompressionNoAlpha = Atlas.Settings.Encoding == ELightmapEncoding::BC1;
+    Tex->NeverStream = true;
+    Tex->UpdateResource();
+    Tex->PostEditChange();
+    return Tex;
 }
 
-static FVector2f ComputeLightmapUVForFace(const bspformat29::Bsp_29& Model, int32 FaceIndex, float S, float T, const FLightmapAtlas* Atlas)
+bool CreateLightmapAtlasTexture(const FString& LightmapsPath, const FString& MapName, bool bOverwrite, FLightmapAtlas& InOutAtlas)
 {
-    if (!Atlas)
+    TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::CreateLightmapAtlasTexture);
+
+    if (InOutAtlas.Pages.Num() == 0)
     {
-        return FVector2f(0.0f, 0.0f);
+        return false;
     }
 
-    const FLightmapAtlasFace* Info = Atlas->FaceToAtlas.Find(FaceIndex);
-    if (!Info || Atlas->AtlasW <= 0 || Atlas->AtlasH <= 0)
+    for (int32 PageIndex = 0; PageIndex < InOutAtlas.Pages.Num(); PageIndex++)
     {
-        return FVector2f(0.0f, 0.0f);
+        FLightmapAtlasPage& Page = InOutAtlas.Pages[PageIndex];
+
+        // The first page keeps the single-atlas name so existing materials and levels stay valid. Pages of face groups
+        // are named after their group, so world and entity imports of the same map never overwrite each other's pages.
+        FString TexName = PageIndex == 0 ? FString::Printf(TEXT("LM_%s"), *MapName) : FString::Printf(TEXT("LM_%s_%d"), *MapName, PageIndex);
+        if (!Page.GroupName.IsEmpty())
+        {
+            TexName = TEXT("LM_") + Page.GroupName;
+        }
+        UTexture2D* Tex = CreateLightmapPageTexture(LightmapsPath, TexName, Page.Width, Page.Height, Page.Pixels, InOutAtlas, bOverwrite);
+        if (!Tex)
+        {
+            return false;
+        }
+        Page.TextureObjectPath = Tex->GetPathName();
+        Page.Pixels.Empty();
+
+        for (int32 LayerIndex = 0; LayerIndex < Page.StyleLayers.Num(); LayerIndex++)
+        {
+            FLightmapAtlasLayer& Layer = Page.StyleLayers[LayerIndex];
+            UTexture2D* LayerTex = CreateLightmapPageTexture(LightmapsPath, FString::Printf(TEXT("%s_S%d"), *TexName, LayerIndex + 1), Page.Width, Page.Height, Layer.Pixels, InOutAtlas, bOverwrite);
+            if (!LayerTex)
+            {
+                return false;
+            }
+            Layer.TextureObjectPath = LayerTex->GetPathName();
+            Layer.Pixels.Empty();
+        }
     }
+    return true;
+}
 
-    const float LMs = (S - float(Info->TexMinS)) / 16.0f;
-    const float LMt = (T - float(Info->TexMinT)) / 16.0f;
+bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& LightmapsPath, const FString& MapName, const FString& LitFilePath, const FLightmapAtlasSettings& Settings, bool bOverwrite, FLightmapAtlas& OutAtlas)
+{
+    return PackLightmapAtlas(Model, LitFilePath, Settings, OutAtlas) && CreateLightmapAtlasTexture(LightmapsPath, MapName, bOverwrite, OutAtlas);
+}
 
-    const float U = (float(Info->X) + LMs + 0.5f) / float(Atlas->AtlasW);
-    const float V = (float(Info->Y) + LMt + 0.5f) / float(Atlas->AtlasH);
-    return FVector2f(U, V);
+// Texture and lightmap UVs of a run of face corners from their texture-space S/T, in one branch free pass.
+// The lightmap clamp keeps faces collapsed to a single luxel on it.
+static void ComputeFaceUVs(const FVector2f* ST, int32 Num, const FVector2f& TexSize, const FVector2f& LmScale, const FVector2f& LmBias, const FVector2f& LmMin, const FVector2f& LmMax,
+    FVector2f* OutTexCoords, FVector2f* OutLightmapUVs)
+{
+    for (int32 I = 0; I < Num; I++)
+    {
+        OutTexCoords[I] = ST[I] / TexSize;
+        OutLightmapUVs[I] = FVector2f(
+            FMath::Clamp(ST[I].X * LmScale.X + LmBias.X, LmMin.X, LmMax.X),
+            FMath::Clamp(ST[I].Y * LmScale.Y + LmBias.Y, LmMin.Y, LmMax.Y));
+    }
 }
 
 static UMaterialInterface* GetWorldGridMaterial()
@@ -1158,8 +1828,392 @@ static UMaterialInterface* GetWorldGridMaterial()
     return Cached ? Cached : UMaterial::GetDefaultMaterial(MD_Surface);
 }
 
-    static void BuildStaticMesh(UStaticMesh* StaticMesh, const bspformat29::Bsp_29& Model, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>* MaskedTextureNames, const FWorldChunkBuild& Chunk, int32 LightmapSize, const FName& CollisionProfileName, const FName& MaskedCollisionProfileName, bool bGenerateLightmapUVs)
+    static FVector3f ComputeFaceCenter(const bspformat29::Bsp_29& Model, const bspformat29::Face& Face)
+    {
+        FVector3f Sum(0, 0, 0);
+        int32 Count = 0;
+        for (int32 E = Face.numedges; E-- > 0;)
+        {
+            const bspformat29::Surfedge& Surfedge = Model.surfedges[Face.firstedge + E];
+            const bspformat29::Edge& Edge = Model.edges[abs(Surfedge.index)];
+            const int32 VertexId = Surfedge.index < 0 ? Edge.second : Edge.first;
+
+            const bspformat29::Point3f& P = Model.vertices[VertexId];
+            Sum += FVector3f(-P.x, P.y, P.z);
+            Count++;
+        }
+        return Count > 0 ? Sum / float(Count) : Sum;
+    }
+
+    // Face polygon corner in Quake space, with its texture-space S/T. BspVertex is -1 for corners
+    // created by luxel grid tessellation.
+    struct FFacePolyVertex
+    {
+        FVector3f Position;
+        FVector2f ST;
+        int32 BspVertex = -1;
+    };
+
+    using FFacePolygon = TArray<FFacePolyVertex, TInlineAllocator<16>>;
+
+    // Clips a convex polygon by the line ST[Axis] == Value. Corners on the line go to both halves.
+    static void SplitFacePolygon(const FFacePolygon& Poly, int32 Axis, float Value, FFacePolygon& OutBelow, FFacePolygon& OutAbove)
+    {
+        constexpr float Epsilon = 0.01f;
+
+        OutBelow.Reset();
+        OutAbove.Reset();
+        for (int32 I = 0; I < Poly.Num(); I++)
+        {
+            const FFacePolyVertex& A = Poly[I];
+            const FFacePolyVertex& B = Poly[(I + 1) % Poly.Num()];
+            const float DA = A.ST[Axis] - Value;
+            const float DB = B.ST[Axis] - Value;
+
+            if (DA <= Epsilon)
+            {
+                OutBelow.Add(A);
+            }
+            if (DA >= -Epsilon)
+            {
+                OutAbove.Add(A);
+            }
+
+            if ((DA < -Epsilon && DB > Epsilon) || (DA > Epsilon && DB < -Epsilon))
+            {
+                const float Alpha = DA / (DA - DB);
+                FFacePolyVertex Cut;
+                Cut.Position = FMath::Lerp(A.Position, B.Position, Alpha);
+                Cut.ST = FMath::Lerp(A.ST, B.ST, Alpha);
+                Cut.ST[Axis] = Value;
+                OutBelow.Add(Cut);
+                OutAbove.Add(Cut);
+            }
+        }
+    }
+
+    // Cuts the face along every interior luxel row and column so each luxel centre becomes a vertex.
+    static void TessellateFaceOnLuxelGrid(FFacePolygon&& Poly, int32 TexMinS, int32 TexMinT, int32 LightmapW, int32 LightmapH, TArray<FFacePolygon>& OutPieces)
+    {
+        OutPieces.Reset();
+        OutPieces.Add(MoveTemp(Poly));
+
+        TArray<FFacePolygon> Next;
+        FFacePolygon Below;
+        FFacePolygon Above;
+        for (int32 Axis = 0; Axis < 2; Axis++)
+        {
+            const int32 Min = Axis == 0 ? TexMinS : TexMinT;
+            const int32 Count = Axis == 0 ? LightmapW : LightmapH;
+            for (int32 Line = 1; Line < Count - 1; Line++)
+            {
+                const float Value = float(Min + Line * 16);
+                Next.Reset();
+                for (const FFacePolygon& Piece : OutPieces)
+                {
+                    SplitFacePolygon(Piece, Axis, Value, Below, Above);
+                    if (Below.Num() >= 3)
+                    {
+                        Next.Add(Below);
+                    }
+                    if (Above.Num() >= 3)
+                    {
+                        Next.Add(Above);
+                    }
+                }
+                Swap(OutPieces, Next);
+            }
+        }
+    }
+
+    static uint32 GetOrAddSplitVertex(FWorldChunkBuild& Chunk, const FVector3f& QuakePosition, float ImportScale)
+    {
+        const FIntVector Key(FMath::RoundToInt(QuakePosition.X * 256.0f), FMath::RoundToInt(QuakePosition.Y * 256.0f), FMath::RoundToInt(QuakePosition.Z * 256.0f));
+        if (const int32* Found = Chunk.SplitVertexToLocal.Find(Key))
+        {
+            return uint32(*Found);
+        }
+
+        const int32 NewIndex = Chunk.RawMesh.VertexPositions.Num();
+        Chunk.SplitVertexToLocal.Add(Key, NewIndex);
+        Chunk.RawMesh.VertexPositions.Add(FVector3f(-QuakePosition.X, QuakePosition.Y, QuakePosition.Z) * ImportScale);
+        return uint32(NewIndex);
+    }
+
+    // Bilinear sample of the face lightmaps at texture-space S/T, styles 0 to 3 summed at normal
+    // intensity, on the same luxel / 255 scale as the atlas.
+    static FColor SampleFaceVertexLight(const bspformat29::Bsp_29& Model, const bspformat29::Face& Face, const FVertexLighting& Lighting,
+        int32 TexMinS, int32 TexMinT, int32 LightmapW, int32 LightmapH, const FVector2f& ST)
+    {
+        if (Model.lightdata.Num() == 0)
+        {
+            return FColor::White;
+        }
+        if (Face.lightofs < 0 || LightmapW <= 0 || LightmapH <= 0)
+        {
+            // Liquids and sky are drawn fullbright, other unlit faces are black.
+            const FString& TexName = Model.textures[Model.texinfos[Face.texinfo].miptex].name;
+            return TexName.StartsWith(TEXT("*")) || TexName.StartsWith(TEXT("sky")) ? FColor::White : FColor::Black;
+        }
+
+        const float Ls = FMath::Clamp((ST.X - float(TexMinS)) / 16.0f, 0.0f, float(LightmapW - 1));
+        const float Lt = FMath::Clamp((ST.Y - float(TexMinT)) / 16.0f, 0.0f, float(LightmapH - 1));
+        const int32 X0 = FMath::FloorToInt(Ls);
+        const int32 Y0 = FMath::FloorToInt(Lt);
+        const int32 X1 = FMath::Min(X0 + 1, LightmapW - 1);
+        const int32 Y1 = FMath::Min(Y0 + 1, LightmapH - 1);
+        const float Fx = Ls - float(X0);
+        const float Fy = Lt - float(Y0);
+
+        const bool bRgb = Lighting.LitRgb.Num() > 0;
+        const int32 Channels = bRgb ? 3 : 1;
+        const uint8* Luxels = bRgb ? Lighting.LitRgb.GetData() : Model.lightdata.GetData();
+        const int64 LumpSize = int64(Model.lightdata.Num());
+        const int64 StyleSize = int64(LightmapW) * int64(LightmapH);
+
+        FVector3f Sum(0.0f, 0.0f, 0.0f);
+        for (int32 Style = 0; Style < bspformat29::MAXLIGHTMAPS && uint8(Face.styles[Style]) != 255; Style++)
+        {
+            const int64 Base = int64(Face.lightofs) + StyleSize * Style;
+            if (Base + StyleSize > LumpSize)
+            {
+                break;
+            }
+
+            auto Luxel = [&](int32 X, int32 Y)
+            {
+                const uint8* L = Luxels + (Base + int64(Y) * LightmapW + X) * Channels;
+                return bRgb ? FVector3f(L[0], L[1], L[2]) : FVector3f(L[0], L[0], L[0]);
+            };
+            const FVector3f Top = FMath::Lerp(Luxel(X0, Y0), Luxel(X1, Y0), Fx);
+            const FVector3f Bottom = FMath::Lerp(Luxel(X0, Y1), Luxel(X1, Y1), Fx);
+            Sum += FMath::Lerp(Top, Bottom, Fy);
+        }
+
+        return FColor(
+            uint8(FMath::Clamp(FMath::RoundToInt(Sum.X), 0, 255)),
+            uint8(FMath::Clamp(FMath::RoundToInt(Sum.Y), 0, 255)),
+            uint8(FMath::Clamp(FMath::RoundToInt(Sum.Z), 0, 255)),
+            255);
+    }
+
+    // Triangulates a BSP face into the chunk. UV1 receives atlas UVs when a lightmap atlas is given,
+    // otherwise face-local luxel coordinates that PackChunkLightmapUVs turns into a per-chunk layout.
+    // With VertexLighting the vertex colours carry the baked lightmap instead of light style numbers.
+    static void AppendFaceToChunk(FWorldChunkBuild& Chunk, const bspformat29::Bsp_29& Model, int32 FaceIndex, float ImportScale, const FLightmapAtlas* LightmapAtlas, const FVertexLighting* VertexLighting)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::AppendFaceToChunk);
+        INC_DWORD_STAT(STAT_QuakeImport_Faces);
+
+        const bspformat29::Face& Face = Model.faces[FaceIndex];
+        const bspformat29::TexInfo& Ti = Model.texinfos[Face.texinfo];
+        const bspformat29::Texture& Tex = Model.textures[Ti.miptex];
+
+        int32 TexMinS = 0;
+        int32 TexMinT = 0;
+        int32 LightmapW = 0;
+        int32 LightmapH = 0;
+        ComputeFaceLightmapDimensions(Model, FaceIndex, TexMinS, TexMinT, LightmapW, LightmapH);
+
+        const FVector3f N(Model.planes[Face.planenum].normal[0], Model.planes[Face.planenum].normal[1], Model.planes[Face.planenum].normal[2]);
+        const FVector3f AxisS(Ti.vecs[0][0], Ti.vecs[0][1], Ti.vecs[0][2]);
+        const FVector3f AxisT(Ti.vecs[1][0], Ti.vecs[1][1], Ti.vecs[1][2]);
+
+        FFacePolygon Poly;
+        for (int32 E = Face.numedges; E-- > 0;)
+        {
+            const bspformat29::Surfedge& Surfedge = Model.surfedges[Face.firstedge + E];
+            const bspformat29::Edge& Edge = Model.edges[abs(Surfedge.index)];
+            const int32 VertexId = Surfedge.index < 0 ? Edge.second : Edge.first;
+
+            const bspformat29::Point3f& P = Model.vertices[VertexId];
+            FFacePolyVertex& Corner = Poly.AddDefaulted_GetRef();
+            Corner.Position = FVector3f(P.x, P.y, P.z);
+            Corner.ST = FVector2f(FVector3f::DotProduct(Corner.Position, AxisS) + Ti.vecs[0][3], FVector3f::DotProduct(Corner.Position, AxisT) + Ti.vecs[1][3]);
+            Corner.BspVertex = VertexId;
+        }
+
+        TArray<FFacePolygon, TInlineAllocator<1>> Pieces;
+        if (VertexLighting && VertexLighting->bTessellate && Face.lightofs >= 0)
+        {
+            TArray<FFacePolygon> Tessellated;
+            TessellateFaceOnLuxelGrid(MoveTemp(Poly), TexMinS, TexMinT, LightmapW, LightmapH, Tessellated);
+            Pieces.Append(MoveTemp(Tessellated));
+        }
+        else
+        {
+            Pieces.Add(MoveTemp(Poly));
+        }
+
+        FChunkFace& ChunkFace = Chunk.Faces.AddDefaulted_GetRef();
+        ChunkFace.FaceIndex = FaceIndex;
+        ChunkFace.FirstWedge = Chunk.RawMesh.WedgeIndices.Num();
+        ChunkFace.LightmapW = LightmapW;
+        ChunkFace.LightmapH = LightmapH;
+
+        const FLightmapAtlasFace* AtlasFace = LightmapAtlas ? LightmapAtlas->FindFace(FaceIndex) : nullptr;
+        const int32 Slot = GetOrAddMaterialSlot(Chunk, Ti.miptex, AtlasFace ? AtlasFace->Page : 0);
+        // Materials look the per-style intensities up by the style numbers in the vertex colour.
+        const FColor StyleColor = AtlasFace && LightmapAtlas->Settings.bLightStyles ? AtlasFace->Styles : FColor(0);
+
+        // Atlas faces map S/T straight to page UVs; without an atlas UV1 holds face-local luxel coordinates.
+        // Faces missing from the atlas collapse to UV 0.
+        FVector2f LmScale(1.0f / 16.0f);
+        FVector2f LmBias(0.5f - float(TexMinS) / 16.0f, 0.5f - float(TexMinT) / 16.0f);
+        FVector2f LmMin(-MAX_flt);
+        FVector2f LmMax(MAX_flt);
+        if (AtlasFace)
+        {
+            LmScale = AtlasFace->UVScale;
+            LmBias = AtlasFace->UVBias;
+            LmMin = AtlasFace->UVMin;
+            LmMax = AtlasFace->UVMax;
+        }
+        else if (LightmapAtlas)
+        {
+            LmScale = LmBias = LmMin = LmMax = FVector2f::ZeroVector;
+        }
+        const FVector2f TexSize(float(Tex.width), float(Tex.height));
+
+        TArray<uint32, TInlineAllocator<32>> LocalVertices;
+        TArray<FVector2f, TInlineAllocator<32>> STs;
+        TArray<FVector2f, TInlineAllocator<32>> TexCoords;
+        TArray<FVector2f, TInlineAllocator<32>> LightmapUVs;
+        TArray<FColor, TInlineAllocator<32>> Colors;
+        for (const FFacePolygon& Piece : Pieces)
+        {
+            LocalVertices.Reset();
+            STs.Reset();
+            Colors.Reset();
+
+            for (const FFacePolyVertex& Corner : Piece)
+            {
+                LocalVertices.Add(Corner.BspVertex >= 0
+                    ? GetOrAddLocalVertex(Chunk, Model, Corner.BspVertex, ImportScale)
+                    : GetOrAddSplitVertex(Chunk, Corner.Position, ImportScale));
+                STs.Add(Corner.ST);
+                Colors.Add(VertexLighting ? SampleFaceVertexLight(Model, Face, *VertexLighting, TexMinS, TexMinT, LightmapW, LightmapH, Corner.ST) : StyleColor);
+            }
+
+            TexCoords.SetNumUninitialized(STs.Num(), EAllowShrinking::No);
+            LightmapUVs.SetNumUninitialized(STs.Num(), EAllowShrinking::No);
+            ComputeFaceUVs(STs.GetData(), STs.Num(), TexSize, LmScale, LmBias, LmMin, LmMax, TexCoords.GetData(), LightmapUVs.GetData());
+
+            const int32 NumTris = Piece.Num() - 2;
+            for (int32 J = 0; J < NumTris; J++)
+            {
+                const int32 Corners[3] = { 0, J + 1, J + 2 };
+                for (const int32 C : Corners)
+                {
+                    AddWedgeEntry(Chunk.RawMesh, LocalVertices[C], N, TexCoords[C], LightmapUVs[C], Colors[C]);
+                }
+
+                Chunk.RawMesh.FaceMaterialIndices.Add(Slot);
+                Chunk.RawMesh.FaceSmoothingMasks.Add(0);
+            }
+        }
+
+        ChunkFace.NumWedges = Chunk.RawMesh.WedgeIndices.Num() - ChunkFace.FirstWedge;
+    }
+
+    // Lays out the BSP lightmap charts of every face in the chunk into the chunk's own UV1 space.
+    // Each chart keeps its luxel size, so the layout is aligned to the Quake 16 unit luxel grid and
+    // UE never needs to unwrap the mesh. Returns the layout size in luxels.
+    static int32 PackChunkLightmapUVs(FWorldChunkBuild& Chunk)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::PackChunkLightmapUVs);
+
+        const int32 Pad = 1;
+
+        TArray<int32> Order;
+        Order.Reserve(Chunk.Faces.Num());
+        for (int32 I = 0; I < Chunk.Faces.Num(); I++)
+        {
+            Order.Add(I);
+        }
+        Order.Sort([&Chunk](int32 A, int32 B)
+        {
+            const FChunkFace& FA = Chunk.Faces[A];
+            const FChunkFace& FB = Chunk.Faces[B];
+            if (FA.LightmapH != FB.LightmapH)
+            {
+                return FA.LightmapH > FB.LightmapH;
+            }
+            return FA.LightmapW > FB.LightmapW;
+        });
+
+        TArray<FIntPoint> Origins;
+        Origins.SetNumZeroed(Chunk.Faces.Num());
+
+        int32 Size = 16;
+        for (;; Size *= 2)
+        {
+            int32 CursorX = 0;
+            int32 CursorY = 0;
+            int32 RowH = 0;
+            bool bFail = false;
+
+            for (const int32 I : Order)
+            {
+                const FChunkFace& F = Chunk.Faces[I];
+                const int32 RW = FMath::Max(F.LightmapW, 1) + Pad * 2;
+                const int32 RH = FMath::Max(F.LightmapH, 1) + Pad * 2;
+                if (RW > Size || RH > Size)
+                {
+                    bFail = true;
+                    break;
+                }
+
+                if (CursorX + RW > Size)
+                {
+                    CursorX = 0;
+                    CursorY += RowH;
+                    RowH = 0;
+                }
+
+                if (CursorY + RH > Size)
+                {
+                    bFail = true;
+                    break;
+                }
+
+                Origins[I] = FIntPoint(CursorX + Pad, CursorY + Pad);
+                CursorX += RW;
+                RowH = FMath::Max(RowH, RH);
+            }
+
+            if (!bFail)
+            {
+                break;
+            }
+        }
+
+        const float InvSize = 1.0f / float(Size);
+        TArray<FVector2f>& UV1 = Chunk.RawMesh.WedgeTexCoords[1];
+        for (int32 I = 0; I < Chunk.Faces.Num(); I++)
+        {
+            const FChunkFace& F = Chunk.Faces[I];
+            const FVector2f Origin(float(Origins[I].X), float(Origins[I].Y));
+            for (int32 W = F.FirstWedge; W < F.FirstWedge + F.NumWedges; W++)
+            {
+                UV1[W] = (Origin + UV1[W]) * InvSize;
+            }
+        }
+
+        return Size;
+    }
+
+    // Lightmap resolution for a chunk whose UV1 was laid out by PackChunkLightmapUVs.
+    static int32 GetChunkLightmapResolution(int32 LayoutSize)
+    {
+        const int32 MaxChunkLightmapResolution = 1024;
+        return FMath::Clamp(LayoutSize, 16, MaxChunkLightmapResolution);
+    }
+
+    static void BuildStaticMesh(UStaticMesh* StaticMesh, const bspformat29::Bsp_29& Model, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>* MaskedTextureNames, const FWorldChunkBuild& Chunk, int32 LightmapSize, const FName& CollisionProfileName, const FName& MaskedCollisionProfileName)
     {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::BuildStaticMesh);
+
         if (!StaticMesh)
         {
             return;
@@ -1169,8 +2223,10 @@ static UMaterialInterface* GetWorldGridMaterial()
         for (int32 Slot = 0; Slot < Chunk.SlotToTextureId.Num(); Slot++)
         {
             const int32 TextureId = Chunk.SlotToTextureId[Slot];
+            const int32 LightmapPage = Chunk.SlotToLightmapPage[Slot];
             const FString& MatName = Model.textures[TextureId].name;
-            const FString SafeSlotName = SanitizeSurfaceNameForAsset(MatName);
+            const FString SafeSlotName = LightmapPage == 0 ? SanitizeSurfaceNameForAsset(MatName)
+                : FString::Printf(TEXT("%s_LM%d"), *SanitizeSurfaceNameForAsset(MatName), LightmapPage);
             if (!bHasMaskedTexture && MaskedTextureNames && MaskedTextureNames->Contains(MatName))
             {
                 bHasMaskedTexture = true;
@@ -1178,10 +2234,14 @@ static UMaterialInterface* GetWorldGridMaterial()
 
             UMaterialInterface* Material = nullptr;
 
-            if (const UMaterialInterface* const* Found = MaterialsByName.Find(MatName))
+            if (const UMaterialInterface* const* Found = MaterialsByName.Find(GetLightmapPageMaterialName(MatName, LightmapPage)))
             {
                 Material = const_cast<UMaterialInterface*>(*Found);
             }
+            else if (const UMaterialInterface* const* FoundBase = MaterialsByName.Find(MatName))
+            {
+                Material = const_cast<UMaterialInterface*>(*FoundBase);
+            }
 
             if (!Material)
             {
@@ -1195,7 +2255,8 @@ static UMaterialInterface* GetWorldGridMaterial()
         SrcModel->BuildSettings.MinLightmapResolution = LightmapSize;
         SrcModel->BuildSettings.SrcLightmapIndex = 0;
         SrcModel->BuildSettings.DstLightmapIndex = 1;
-        SrcModel->BuildSettings.bGenerateLightmapUVs = bGenerateLightmapUVs;
+        // UV1 always comes from the BSP lightmap charts (shared atlas or per-chunk layout).
+        SrcModel->BuildSettings.bGenerateLightmapUVs = false;
         SrcModel->BuildSettings.bUseFullPrecisionUVs = true;
 
         FRawMesh LocalCopy = Chunk.RawMesh;
@@ -1204,7 +2265,11 @@ static UMaterialInterface* GetWorldGridMaterial()
         StaticMesh->SetLightingGuid();
         StaticMesh->ImportVersion = EImportStaticMeshVersion::LastVersion;
         StaticMesh->EnforceLightmapRestrictions();
-        StaticMesh->Build();
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE(UStaticMesh::Build);
+            StaticMesh->Build();
+        }
+        INC_DWORD_STAT_BY(STAT_QuakeImport_Triangles, Chunk.RawMesh.WedgeIndices.Num() / 3);
         StaticMesh->SetLightingGuid();
         StaticMesh->SetLightMapResolution(LightmapSize);
         StaticMesh->SetLightMapCoordinateIndex(1);
@@ -1230,6 +2295,8 @@ static UMaterialInterface* GetWorldGridMaterial()
                 BodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
                 BodySetup->DefaultInstance.SetCollisionProfileName(EffectiveCollisionProfile);
                 BodySetup->InvalidatePhysicsData();
+
+                TRACE_CPUPROFILER_EVENT_SCOPE(UBodySetup::CreatePhysicsMeshes);
                 BodySetup->CreatePhysicsMeshes();
             }
             else
@@ -1243,30 +2310,154 @@ static UMaterialInterface* GetWorldGridMaterial()
         StaticMesh->PostEditChange();
     }
 
-    static void CreateWorldChunks(const FString& MeshesPath, const FString& MapName, const bspformat29::Bsp_29& Model, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, int32 ChunkSize, float ImportScale, bool bIncludeSky, bool bIncludeWater, const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile, const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths, TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths , const bsputils::FLightmapAtlas* LightmapAtlas)
+    static const TCHAR* ChunkContentHashKey = TEXT("QuakeImport.ContentHash");
+
+    // Bump whenever chunk assembly or BuildStaticMesh changes in a way the hashed inputs do not capture.
+    static constexpr uint32 ChunkContentHashVersion = 1;
+
+    // Hash of everything that ends up in a chunk mesh: assembled geometry, resolved materials and build settings.
+    static FString ComputeChunkContentHash(const FWorldChunkBuild& Chunk, const bspformat29::Bsp_29& Model, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, int32 LightmapSize, const FName& CollisionProfile, const FName& MaskedCollisionProfile)
     {
-        using namespace bsputils;
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::ComputeChunkContentHash);
+
+        FXxHash64Builder Builder;
 
-        struct FFaceTemp
+        auto HashValue = [&Builder](const auto& Value)
+        {
+            Builder.Update(&Value, sizeof(Value));
+        };
+        auto HashArray = [&Builder, &HashValue](const auto& Array)
+        {
+            HashValue(Array.Num());
+            Builder.Update(Array.GetData(), uint64(Array.Num()) * Array.GetTypeSize());
+        };
+        auto HashString = [&Builder, &HashValue](const FString& Str)
         {
-            int32 NumTris = 0;
-            FVector Normal;
-            TArray<int32> BspVertexIds;
-            int32 TexInfo = 0;
-            TArray<FVector2f> TexCoords;
-            TArray<FVector2f> LightmapST;
-            FVector3f Center;
+            HashValue(Str.Len());
+            Builder.Update(*Str, uint64(Str.Len()) * sizeof(TCHAR));
         };
 
+        HashValue(ChunkContentHashVersion);
+
+        const FRawMesh& Mesh = Chunk.RawMesh;
+        HashArray(Mesh.VertexPositions);
+        HashArray(Mesh.WedgeIndices);
+        HashArray(Mesh.WedgeTangentZ);
+        HashArray(Mesh.WedgeColors);
+        HashArray(Mesh.WedgeTexCoords[0]);
+        HashArray(Mesh.WedgeTexCoords[1]);
+        HashArray(Mesh.FaceMaterialIndices);
+        HashArray(Mesh.FaceSmoothingMasks);
+
+        for (int32 Slot = 0; Slot < Chunk.SlotToTextureId.Num(); Slot++)
+        {
+            const FString& MatName = Model.textures[Chunk.SlotToTextureId[Slot]].name;
+            const int32 LightmapPage = Chunk.SlotToLightmapPage[Slot];
+            HashString(MatName);
+            HashValue(LightmapPage);
+            HashValue(MaskedTextureNames.Contains(MatName));
+
+            const UMaterialInterface* const* Found = MaterialsByName.Find(GetLightmapPageMaterialName(MatName, LightmapPage));
+            if (!Found)
+            {
+                Found = MaterialsByName.Find(MatName);
+            }
+            HashString((Found && *Found) ? (*Found)->GetPathName() : FString());
+        }
+
+        HashValue(LightmapSize);
+        HashString(CollisionProfile.ToString());
+        HashString(MaskedCollisionProfile.ToString());
+
+        return FString::Printf(TEXT("%016llx"), Builder.Finalize().Hash);
+    }
+
+    static UStaticMesh* FindExistingStaticMesh(const FString& LongPackageName, const FString& Name)
+    {
+        const FString ObjectPath = LongPackageName + TEXT(".") + Name;
+        return LoadObject<UStaticMesh>(nullptr, *ObjectPath, nullptr, LOAD_Quiet | LOAD_NoWarn);
+    }
+
+    static bool IsStaticMeshUpToDate(UStaticMesh& StaticMesh, const FString& ContentHash)
+    {
+        if (StaticMesh.GetNumSourceModels() == 0)
+        {
+            return false;
+        }
+
+        UMetaData* MetaData = StaticMesh.GetOutermost()->GetMetaData();
+        return MetaData && MetaData->GetValue(&StaticMesh, ChunkContentHashKey) == ContentHash;
+    }
+
+    // Without a shared atlas, UV1 is packed per chunk from the face-local luxel coordinates.
+    static void FinalizeAssembledChunk(FAssembledChunk& Chunk, const FLightmapAtlas* LightmapAtlas, int32 AtlasLightmapSize)
+    {
+        Chunk.LightmapSize = LightmapAtlas ? AtlasLightmapSize : GetChunkLightmapResolution(PackChunkLightmapUVs(Chunk.Build));
+        INC_DWORD_STAT(STAT_QuakeImport_Chunks);
+    }
+
+    // Assembled raw mesh size of the planned faces, times the copies BuildStaticMesh keeps alive at once
+    // (source model raw mesh and mesh description). Only needs to be right to within a small factor.
+    // With bTessellated, faces are counted as cut along their luxel grid.
+    int64 EstimateChunkBuildBytes(const bspformat29::Bsp_29& Model, const TArray<int32>& FaceIndices, bool bTessellated)
+    {
+        constexpr int64 BytesPerVertex = sizeof(FVector3f) + 16;
+        constexpr int64 BytesPerWedge = sizeof(uint32) + sizeof(FColor) + sizeof(FVector3f) + 2 * sizeof(FVector2f);
+        constexpr int64 BytesPerTriangle = 2 * sizeof(int32);
+        constexpr int64 BuildCopies = 3;
+
+        int64 Bytes = 0;
+        for (const int32 FaceIndex : FaceIndices)
+        {
+            int64 NumVerts = Model.faces[FaceIndex].numedges;
+            int64 NumTris = FMath::Max<int64>(0, NumVerts - 2);
+            if (bTessellated && Model.faces[FaceIndex].lightofs >= 0)
+            {
+                int32 TexMinS = 0;
+                int32 TexMinT = 0;
+                int32 W = 0;
+                int32 H = 0;
+                ComputeFaceLightmapDimensions(Model, FaceIndex, TexMinS, TexMinT, W, H);
+                NumVerts += int64(W + 1) * int64(H + 1);
+                NumTris = FMath::Max<int64>(NumTris, 2 * int64(W) * int64(H));
+            }
+            Bytes += NumVerts * BytesPerVertex + NumTris * (3 * BytesPerWedge + BytesPerTriangle);
+        }
+        return Bytes * BuildCopies;
+    }
+
+    static void EmitChunkPlan(TArray<FChunkPlan>& OutPlans, const bspformat29::Bsp_29& Model, FString&& MeshName, EChunkSurfaceKind Kind, TArray<int32>& FaceIndices)
+    {
+        if (FaceIndices.Num() <= 0)
+        {
+            return;
+        }
+
+        FChunkPlan& Plan = OutPlans.AddDefaulted_GetRef();
+        Plan.MeshName = MoveTemp(MeshName);
+        Plan.Kind = Kind;
+        Plan.EstimatedBuildBytes = EstimateChunkBuildBytes(Model, FaceIndices);
+        Plan.FaceIndices = MoveTemp(FaceIndices);
+    }
+
+    static bool IsCancelRequested(const std::atomic<bool>* bCancel)
+    {
+        return bCancel && bCancel->load(std::memory_order_relaxed);
+    }
+
+    static bool PlanGridChunks(const bspformat29::Bsp_29& Model, const FString& MapName, int32 ChunkSize, bool bIncludeSky, bool bIncludeWater, TArray<FChunkPlan>& OutPlans, const std::atomic<bool>* bCancel)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::PlanGridChunks);
+
         struct FChunkPair
         {
-            FWorldChunkBuild Opaque;
-            FWorldChunkBuild Transparent;
+            TArray<int32> Opaque;
+            TArray<int32> Transparent;
         };
 
         TMap<FIntVector, FChunkPair> BspChunkMap;
-        TMap<FIntVector, FWorldChunkBuild> WaterChunkMap;
-        TMap<FIntVector, FWorldChunkBuild> SkyChunkMap;
+        TMap<FIntVector, TArray<int32>> WaterChunkMap;
+        TMap<FIntVector, TArray<int32>> SkyChunkMap;
 
         int32 FirstFace = 0;
         int32 FaceCount = 0;
@@ -1286,6 +2477,11 @@ static UMaterialInterface* GetWorldGridMaterial()
 
         for (int32 F = FirstFace; F < FirstFace + FaceCount; F++)
         {
+            if (((F - FirstFace) & 1023) == 0 && IsCancelRequested(bCancel))
+            {
+                return false;
+            }
+
             const bspformat29::Face& Face = Model.faces[F];
             const bspformat29::TexInfo& Ti = Model.texinfos[Face.texinfo];
             const bspformat29::Texture& Tex = Model.textures[Ti.miptex];
@@ -1304,186 +2500,87 @@ static UMaterialInterface* GetWorldGridMaterial()
 
             const bool bTransparent = (!bIsSky && !bIsWater) ? IsTransparentSurfaceName(Tex.name) : false;
 
-            FFaceTemp Temp;
-            Temp.TexInfo = Face.texinfo;
-            Temp.NumTris = int32(Face.numedges) - 2;
-
-            for (int32 I = 0; I < 3; I++)
-            {
-                Temp.Normal[I] = Model.planes[Face.planenum].normal[I];
-            }
-
-            FVector3f Sum(0, 0, 0);
-
-            for (int32 E = Face.numedges; E-- > 0;)
-            {
-                const bspformat29::Surfedge& Surfedge = Model.surfedges[Face.firstedge + E];
-                const bspformat29::Edge& Edge = Model.edges[abs(Surfedge.index)];
-
-                int32 VertexId = Edge.first;
-                if (Surfedge.index < 0)
-                {
-                    VertexId = Edge.second;
-                }
-
-                Temp.BspVertexIds.Add(VertexId);
-
-                const bspformat29::Point3f& P = Model.vertices[VertexId];
-                const FVector3f Point(-P.x, P.y, P.z);
-                Sum += Point;
-
-                FVector2f TexCoord;
-                const FVector3f Unflipped(P.x, P.y, P.z);
-
-                float Sraw = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[0][0], Ti.vecs[0][1], Ti.vecs[0][2])) + Ti.vecs[0][3];
-                float Traw = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[1][0], Ti.vecs[1][1], Ti.vecs[1][2])) + Ti.vecs[1][3];
-
-                TexCoord.X = Sraw / Tex.width;
-                TexCoord.Y = Traw / Tex.height;
-
-                Temp.TexCoords.Add(TexCoord);
-                Temp.LightmapST.Add(FVector2f(Sraw, Traw));
-            }
-
-            Temp.Center = Sum / float(Temp.BspVertexIds.Num());
-
-            const FIntVector Key = GetChunkKey3D(Temp.Center, ChunkSize);
-            FWorldChunkBuild* ChunkPtr = nullptr;
+            const FIntVector Key = GetChunkKey3D(ComputeFaceCenter(Model, Face), ChunkSize);
+            TArray<int32>* ChunkFaces = nullptr;
 
             if (bIsSky)
             {
-                ChunkPtr = &SkyChunkMap.FindOrAdd(Key);
+                ChunkFaces = &SkyChunkMap.FindOrAdd(Key);
             }
             else if (bIsWater)
             {
-                ChunkPtr = &WaterChunkMap.FindOrAdd(Key);
+                ChunkFaces = &WaterChunkMap.FindOrAdd(Key);
             }
             else
             {
                 FChunkPair& Pair = BspChunkMap.FindOrAdd(Key);
-                ChunkPtr = bTransparent ? &Pair.Transparent : &Pair.Opaque;
+                ChunkFaces = bTransparent ? &Pair.Transparent : &Pair.Opaque;
             }
 
-            FWorldChunkBuild& Chunk = *ChunkPtr;
-
-            for (int32 J = 0; J < Temp.NumTris; J++)
-            {
-                const int32 A = 0;
-                const int32 B = J + 1;
-                const int32 C = J + 2;
-
-                const uint32 VA = GetOrAddLocalVertex(Chunk, Model, Temp.BspVertexIds[A], ImportScale);
-                const uint32 VB = GetOrAddLocalVertex(Chunk, Model, Temp.BspVertexIds[B], ImportScale);
-                const uint32 VC = GetOrAddLocalVertex(Chunk, Model, Temp.BspVertexIds[C], ImportScale);
-
-                const FVector3f N(Temp.Normal.X, Temp.Normal.Y, Temp.Normal.Z);
-
-                AddWedgeEntry(Chunk.RawMesh, VA, N, Temp.TexCoords[A], ComputeLightmapUVForFace(Model, F, Temp.LightmapST[A].X, Temp.LightmapST[A].Y, LightmapAtlas));
-                AddWedgeEntry(Chunk.RawMesh, VB, N, Temp.TexCoords[B], ComputeLightmapUVForFace(Model, F, Temp.LightmapST[B].X, Temp.LightmapST[B].Y, LightmapAtlas));
-                AddWedgeEntry(Chunk.RawMesh, VC, N, Temp.TexCoords[C], ComputeLightmapUVForFace(Model, F, Temp.LightmapST[C].X, Temp.LightmapST[C].Y, LightmapAtlas));
-
-                const int32 TextureId = Model.texinfos[Temp.TexInfo].miptex;
-                const int32 Slot = GetOrAddMaterialSlot(Chunk, TextureId);
-                Chunk.RawMesh.FaceMaterialIndices.Add(Slot);
-                Chunk.RawMesh.FaceSmoothingMasks.Add(0);
-            }
+            ChunkFaces->Add(F);
         }
 
-        const int32 LightmapSize = 128;
-
-        for (const auto& PairIt : BspChunkMap)
+        // Deterministic chunk order keeps generated paths and content hashes stable across reimports.
+        auto ChunkKeyLess = [](const FIntVector& A, const FIntVector& B)
         {
-            const FIntVector Key = PairIt.Key;
-            const FChunkPair& Pair = PairIt.Value;
-
-            if (Pair.Opaque.RawMesh.WedgeIndices.Num() > 0)
+            if (A.X != B.X)
             {
-                const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_%d_%d_%d"), *MapName, Key.X, Key.Y, Key.Z);
-                const FString LongPkg = MeshesPath / ChunkName;
-                UPackage* Pkg = CreateAssetPackage(LongPkg);
-                UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-                BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Pair.Opaque, LightmapSize, BspCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
-
-                if (OutBspMeshObjectPaths)
-                {
-                    OutBspMeshObjectPaths->Add(StaticMesh->GetPathName());
-                }
+                return A.X < B.X;
             }
-
-            if (Pair.Transparent.RawMesh.WedgeIndices.Num() > 0)
+            if (A.Y != B.Y)
             {
-                const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_%d_%d_%d_Trans"), *MapName, Key.X, Key.Y, Key.Z);
-                const FString LongPkg = MeshesPath / ChunkName;
-                UPackage* Pkg = CreateAssetPackage(LongPkg);
-                UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-                BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Pair.Transparent, LightmapSize, BspCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
-
-                if (OutBspMeshObjectPaths)
-                {
-                    OutBspMeshObjectPaths->Add(StaticMesh->GetPathName());
-                }
+                return A.Y < B.Y;
             }
+            return A.Z < B.Z;
+        };
+        BspChunkMap.KeySort(ChunkKeyLess);
+        WaterChunkMap.KeySort(ChunkKeyLess);
+        SkyChunkMap.KeySort(ChunkKeyLess);
+
+        for (auto& PairIt : BspChunkMap)
+        {
+            const FIntVector Key = PairIt.Key;
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_%d_%d_%d"), *MapName, Key.X, Key.Y, Key.Z), EChunkSurfaceKind::Solid, PairIt.Value.Opaque);
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_%d_%d_%d_Trans"), *MapName, Key.X, Key.Y, Key.Z), EChunkSurfaceKind::Solid, PairIt.Value.Transparent);
         }
 
-        for (const auto& It : WaterChunkMap)
+        for (auto& It : WaterChunkMap)
         {
             const FIntVector Key = It.Key;
-            const FWorldChunkBuild& Chunk = It.Value;
-            if (Chunk.RawMesh.WedgeIndices.Num() <= 0)
-            {
-                continue;
-            }
-
-            const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_Water_%d_%d_%d"), *MapName, Key.X, Key.Y, Key.Z);
-            const FString LongPkg = MeshesPath / ChunkName;
-            UPackage* Pkg = CreateAssetPackage(LongPkg);
-            UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-            BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Chunk, LightmapSize, WaterCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
-
-            if (OutWaterMeshObjectPaths)
-            {
-                OutWaterMeshObjectPaths->Add(StaticMesh->GetPathName());
-            }
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_Water_%d_%d_%d"), *MapName, Key.X, Key.Y, Key.Z), EChunkSurfaceKind::Liquid, It.Value);
         }
 
-        for (const auto& It : SkyChunkMap)
+        for (auto& It : SkyChunkMap)
         {
             const FIntVector Key = It.Key;
-            const FWorldChunkBuild& Chunk = It.Value;
-            if (Chunk.RawMesh.WedgeIndices.Num() <= 0)
-            {
-                continue;
-            }
-
-            const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_Sky_%d_%d_%d"), *MapName, Key.X, Key.Y, Key.Z);
-            const FString LongPkg = MeshesPath / ChunkName;
-            UPackage* Pkg = CreateAssetPackage(LongPkg);
-            UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-            BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Chunk, LightmapSize, SkyCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
-
-            if (OutSkyMeshObjectPaths)
-            {
-                OutSkyMeshObjectPaths->Add(StaticMesh->GetPathName());
-            }
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_Sky_%d_%d_%d"), *MapName, Key.X, Key.Y, Key.Z), EChunkSurfaceKind::Sky, It.Value);
         }
+
+        return true;
     }
 
-    static void CreateLeafChunks(const FString& MeshesPath, const FString& MapName, const bspformat29::Bsp_29& Model, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, float ImportScale, bool bIncludeSky, bool bIncludeWater, const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile, const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths, TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths , const bsputils::FLightmapAtlas* LightmapAtlas)
+    static bool PlanLeafChunks(const bspformat29::Bsp_29& Model, const FString& MapName, bool bIncludeSky, bool bIncludeWater, TArray<FChunkPlan>& OutPlans, const std::atomic<bool>* bCancel)
     {
-        using namespace bsputils;
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::PlanLeafChunks);
 
         struct FLeafPair
         {
-            FWorldChunkBuild Opaque;
-            FWorldChunkBuild Transparent;
+            TArray<int32> Opaque;
+            TArray<int32> Transparent;
         };
 
         TMap<int32, FLeafPair> LeafToChunk;
-        TMap<int32, FWorldChunkBuild> WaterLeafToChunk;
-        TMap<int32, FWorldChunkBuild> SkyLeafToChunk;
+        TMap<int32, TArray<int32>> WaterLeafToChunk;
+        TMap<int32, TArray<int32>> SkyLeafToChunk;
 
+        TSet<int32> FaceSet;
         for (int32 LeafIndex = 0; LeafIndex < Model.leaves.Num(); LeafIndex++)
         {
+            if ((LeafIndex & 255) == 0 && IsCancelRequested(bCancel))
+            {
+                return false;
+            }
+
             const bspformat29::Leaf& Leaf = Model.leaves[LeafIndex];
             if (Leaf.nummarksurfaces == 0)
             {
@@ -1496,7 +2593,7 @@ static UMaterialInterface* GetWorldGridMaterial()
 
             FLeafPair& Pair = LeafToChunk.FindOrAdd(LeafIndex);
 
-            TSet<int32> FaceSet;
+            FaceSet.Reset();
             const uint32 NumMarkSurfaces = (uint32)Leaf.nummarksurfaces;
             for (uint32 I = 0; I < NumMarkSurfaces; I++)
             {
@@ -1533,171 +2630,74 @@ static UMaterialInterface* GetWorldGridMaterial()
                     continue;
                 }
 
-                FWorldChunkBuild* ChunkPtr = nullptr;
+                TArray<int32>* ChunkFaces = nullptr;
                 if (bIsSky)
                 {
-                    ChunkPtr = &SkyLeafToChunk.FindOrAdd(LeafIndex);
+                    ChunkFaces = &SkyLeafToChunk.FindOrAdd(LeafIndex);
                 }
                 else if (bIsWater)
                 {
-                    ChunkPtr = &WaterLeafToChunk.FindOrAdd(LeafIndex);
+                    ChunkFaces = &WaterLeafToChunk.FindOrAdd(LeafIndex);
                 }
                 else
                 {
                     const bool bTransparent = IsTransparentSurfaceName(Tex.name);
-                    ChunkPtr = bTransparent ? &Pair.Transparent : &Pair.Opaque;
-                }
-
-                FWorldChunkBuild& Chunk = *ChunkPtr;
-
-                FVector Normal;
-                for (int32 N = 0; N < 3; N++)
-                {
-                    Normal[N] = Model.planes[Face.planenum].normal[N];
+                    ChunkFaces = bTransparent ? &Pair.Transparent : &Pair.Opaque;
                 }
 
-                TArray<int32> BspVertexIds;
-                TArray<FVector2f> TexCoords;
-                TArray<FVector2f> LightmapST;
-
-                for (int32 E = Face.numedges; E-- > 0;)
-                {
-                    const bspformat29::Surfedge& Surfedge = Model.surfedges[Face.firstedge + E];
-                    const bspformat29::Edge& Edge = Model.edges[abs(Surfedge.index)];
-
-                    int32 VertexId = Edge.first;
-                    if (Surfedge.index < 0)
-                    {
-                        VertexId = Edge.second;
-                    }
-
-                    BspVertexIds.Add(VertexId);
-
-                    const bspformat29::Point3f& P = Model.vertices[VertexId];
-                    const FVector3f Unflipped(P.x, P.y, P.z);
-
-                    FVector2f TexCoord;
-float Sraw = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[0][0], Ti.vecs[0][1], Ti.vecs[0][2])) + Ti.vecs[0][3];
-                    float Traw = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[1][0], Ti.vecs[1][1], Ti.vecs[1][2])) + Ti.vecs[1][3];
-                    TexCoord.X = Sraw / Tex.width;
-                    TexCoord.Y = Traw / Tex.height;
-                    TexCoords.Add(TexCoord);
-                    LightmapST.Add(FVector2f(Sraw, Traw));
-                }
-
-                const int32 NumTris = int32(Face.numedges) - 2;
-                for (int32 J = 0; J < NumTris; J++)
-                {
-                    const int32 A = 0;
-                    const int32 B = J + 1;
-                    const int32 C = J + 2;
-
-                    const uint32 VA = GetOrAddLocalVertex(Chunk, Model, BspVertexIds[A], ImportScale);
-                    const uint32 VB = GetOrAddLocalVertex(Chunk, Model, BspVertexIds[B], ImportScale);
-                    const uint32 VC = GetOrAddLocalVertex(Chunk, Model, BspVertexIds[C], ImportScale);
-
-                    const FVector3f N(Normal.X, Normal.Y, Normal.Z);
-                    AddWedgeEntry(Chunk.RawMesh, VA, N, TexCoords[A], ComputeLightmapUVForFace(Model, FaceIndex, LightmapST[A].X, LightmapST[A].Y, LightmapAtlas));
-                    AddWedgeEntry(Chunk.RawMesh, VB, N, TexCoords[B], ComputeLightmapUVForFace(Model, FaceIndex, LightmapST[B].X, LightmapST[B].Y, LightmapAtlas));
-                    AddWedgeEntry(Chunk.RawMesh, VC, N, TexCoords[C], ComputeLightmapUVForFace(Model, FaceIndex, LightmapST[C].X, LightmapST[C].Y, LightmapAtlas));
-
-                    const int32 TextureId = Model.texinfos[Face.texinfo].miptex;
-                    const int32 Slot = GetOrAddMaterialSlot(Chunk, TextureId);
-                    Chunk.RawMesh.FaceMaterialIndices.Add(Slot);
-                    Chunk.RawMesh.FaceSmoothingMasks.Add(0);
-                }
+                ChunkFaces->Add(FaceIndex);
             }
         }
 
-        const int32 LightmapSize = 128;
+        // Deterministic chunk order keeps generated paths and content hashes stable across reimports.
+        LeafToChunk.KeySort(TLess<int32>());
+        WaterLeafToChunk.KeySort(TLess<int32>());
+        SkyLeafToChunk.KeySort(TLess<int32>());
 
-        for (const auto& PairIt : LeafToChunk)
+        for (auto& PairIt : LeafToChunk)
         {
             const int32 LeafIndex = PairIt.Key;
-            const FLeafPair& Pair = PairIt.Value;
-
-            if (Pair.Opaque.RawMesh.WedgeIndices.Num() > 0)
-            {
-                const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_leaf_%d"), *MapName, LeafIndex);
-                const FString LongPkg = MeshesPath / ChunkName;
-                UPackage* Pkg = CreateAssetPackage(LongPkg);
-                UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-                BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Pair.Opaque, LightmapSize, BspCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
-
-                if (OutBspMeshObjectPaths)
-                {
-                    OutBspMeshObjectPaths->Add(StaticMesh->GetPathName());
-                }
-            }
-
-            if (Pair.Transparent.RawMesh.WedgeIndices.Num() > 0)
-            {
-                const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_leaf_%d_Trans"), *MapName, LeafIndex);
-                const FString LongPkg = MeshesPath / ChunkName;
-                UPackage* Pkg = CreateAssetPackage(LongPkg);
-                UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-                BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Pair.Transparent, LightmapSize, BspCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
-
-                if (OutBspMeshObjectPaths)
-                {
-                    OutBspMeshObjectPaths->Add(StaticMesh->GetPathName());
-                }
-            }
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_leaf_%d"), *MapName, LeafIndex), EChunkSurfaceKind::Solid, PairIt.Value.Opaque);
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_leaf_%d_Trans"), *MapName, LeafIndex), EChunkSurfaceKind::Solid, PairIt.Value.Transparent);
         }
 
-        for (const auto& It : WaterLeafToChunk)
+        for (auto& It : WaterLeafToChunk)
         {
-            const int32 LeafIndex = It.Key;
-            const FWorldChunkBuild& Chunk = It.Value;
-            if (Chunk.RawMesh.WedgeIndices.Num() <= 0)
-            {
-                continue;
-            }
-
-            const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_Water_leaf_%d"), *MapName, LeafIndex);
-            const FString LongPkg = MeshesPath / ChunkName;
-            UPackage* Pkg = CreateAssetPackage(LongPkg);
-            UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-            BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Chunk, LightmapSize, WaterCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
-
-            if (OutWaterMeshObjectPaths)
-            {
-                OutWaterMeshObjectPaths->Add(StaticMesh->GetPathName());
-            }
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_Water_leaf_%d"), *MapName, It.Key), EChunkSurfaceKind::Liquid, It.Value);
         }
 
-        for (const auto& It : SkyLeafToChunk)
+        for (auto& It : SkyLeafToChunk)
         {
-            const int32 LeafIndex = It.Key;
-            const FWorldChunkBuild& Chunk = It.Value;
-            if (Chunk.RawMesh.WedgeIndices.Num() <= 0)
-            {
-                continue;
-            }
+            EmitChunkPlan(OutPlans, Model, FString::Printf(TEXT("SM_%s_BSP_World_Sky_leaf_%d"), *MapName, It.Key), EChunkSurfaceKind::Sky, It.Value);
+        }
 
-            const FString ChunkName = FString::Printf(TEXT("SM_%s_BSP_World_Sky_leaf_%d"), *MapName, LeafIndex);
-            const FString LongPkg = MeshesPath / ChunkName;
-            UPackage* Pkg = CreateAssetPackage(LongPkg);
-            UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, ChunkName);
-            BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Chunk, LightmapSize, SkyCollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
+        return true;
+    }
 
-            if (OutSkyMeshObjectPaths)
-            {
-                OutSkyMeshObjectPaths->Add(StaticMesh->GetPathName());
-            }
+    bool PlanWorldChunks(const bspformat29::Bsp_29& Model, const FString& MapName, bool bChunkWorld, int32 WorldChunkSize, bool bIncludeSky, bool bIncludeWater, TArray<FChunkPlan>& OutPlans, const std::atomic<bool>* bCancel)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::PlanWorldChunks);
+
+        OutPlans.Reset();
+
+        if (bChunkWorld)
+        {
+            return PlanGridChunks(Model, MapName, WorldChunkSize, bIncludeSky, bIncludeWater, OutPlans, bCancel);
         }
+
+        return PlanLeafChunks(Model, MapName, bIncludeSky, bIncludeWater, OutPlans, bCancel);
     }
 
-    bool CreateSubmodelStaticMesh(const bspformat29::Bsp_29& Model, const FString& MeshesPath, const FString& MeshAssetName, uint8 SubModelId, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, float ImportScale, const FName& DefaultCollisionProfile, const FName& MaskedCollisionProfile, FString& OutObjectPath, const bsputils::FLightmapAtlas* LightmapAtlas)
+    bool PlanSubmodelChunk(const bspformat29::Bsp_29& Model, int32 SubModelId, const FString& MeshName, FChunkPlan& OutPlan)
     {
         if (!Model.submodels.IsValidIndex(SubModelId))
         {
             return false;
         }
 
-        FWorldChunkBuild Chunk;
-        bool bAnyFace = false;
-        bool bAnyTriggerTex = false;
+        OutPlan = FChunkPlan();
+        OutPlan.MeshName = MeshName;
+        OutPlan.AtlasLightmapSize = 64;
 
         const bspformat29::SubModel& Sub = Model.submodels[SubModelId];
         for (int32 F = Sub.firstface; F < Sub.firstface + Sub.numfaces; F++)
@@ -1711,86 +2711,99 @@ float Sraw = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[0][0], Ti.vecs[0
             const bspformat29::TexInfo& Ti = Model.texinfos[Face.texinfo];
             const bspformat29::Texture& Tex = Model.textures[Ti.miptex];
 
-            bAnyFace = true;
             if (Tex.name.Equals(TEXT("trigger"), ESearchCase::IgnoreCase))
             {
-                bAnyTriggerTex = true;
+                OutPlan.bHasTriggerTexture = true;
             }
 
-            FVector Normal;
-            for (int32 N = 0; N < 3; N++)
-            {
-                Normal[N] = Model.planes[Face.planenum].normal[N];
-            }
+            OutPlan.FaceIndices.Add(F);
+        }
 
-            TArray<int32> BspVertexIds;
-            TArray<FVector2f> TexCoords;
-            TArray<FVector2f> LightmapST;
-            BspVertexIds.Reserve(Face.numedges);
-            TexCoords.Reserve(Face.numedges);
+        OutPlan.EstimatedBuildBytes = EstimateChunkBuildBytes(Model, OutPlan.FaceIndices);
+        return OutPlan.FaceIndices.Num() > 0;
+    }
 
-            for (int32 E = Face.numedges; E-- > 0;)
-            {
-                const bspformat29::Surfedge& Surfedge = Model.surfedges[Face.firstedge + E];
-                const bspformat29::Edge& Edge = Model.edges[abs(Surfedge.index)];
+    bool AssembleChunk(const bspformat29::Bsp_29& Model, const FChunkPlan& Plan, float ImportScale, const FLightmapAtlas* LightmapAtlas, FAssembledChunk& OutChunk, const FVertexLighting* VertexLighting)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::AssembleChunk);
 
-                int32 VertexId = Edge.first;
-                if (Surfedge.index < 0)
-                {
-                    VertexId = Edge.second;
-                }
+        OutChunk = FAssembledChunk();
+        OutChunk.MeshName = Plan.MeshName;
+        OutChunk.Kind = Plan.Kind;
+        OutChunk.bHasTriggerTexture = Plan.bHasTriggerTexture;
+
+        for (const int32 FaceIndex : Plan.FaceIndices)
+        {
+            AppendFaceToChunk(OutChunk.Build, Model, FaceIndex, ImportScale, LightmapAtlas, VertexLighting);
+        }
 
-                BspVertexIds.Add(VertexId);
+        if (OutChunk.Build.RawMesh.WedgeIndices.Num() == 0)
+        {
+            return false;
+        }
 
-                const bspformat29::Point3f& P = Model.vertices[VertexId];
-                const FVector3f Unflipped(P.x, P.y, P.z);
+        FinalizeAssembledChunk(OutChunk, LightmapAtlas, Plan.AtlasLightmapSize);
+        return true;
+    }
 
-                FVector2f TexCoord;
-                const float S = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[0][0], Ti.vecs[0][1], Ti.vecs[0][2])) + Ti.vecs[0][3];
-                const float T = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[1][0], Ti.vecs[1][1], Ti.vecs[1][2])) + Ti.vecs[1][3];
-                TexCoord.X = S;
-                TexCoord.Y = T;
-                LightmapST.Add(FVector2f(S, T));
-                TexCoord.X /= Tex.width;
-                TexCoord.Y /= Tex.height;
-                TexCoords.Add(TexCoord);
-            }
+    bool AssembleSubmodelChunk(const bspformat29::Bsp_29& Model, int32 SubModelId, const FString& MeshName, float ImportScale, const FLightmapAtlas* LightmapAtlas, FAssembledChunk& OutChunk)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::AssembleSubmodelChunk);
 
-            const int32 NumTris = int32(Face.numedges) - 2;
-            for (int32 J = 0; J < NumTris; J++)
-            {
-                const int32 A = 0;
-                const int32 B = J + 1;
-                const int32 C = J + 2;
+        FChunkPlan Plan;
+        return PlanSubmodelChunk(Model, SubModelId, MeshName, Plan) && AssembleChunk(Model, Plan, ImportScale, LightmapAtlas, OutChunk);
+    }
 
-                const uint32 VA = GetOrAddLocalVertex(Chunk, Model, BspVertexIds[A], ImportScale);
-                const uint32 VB = GetOrAddLocalVertex(Chunk, Model, BspVertexIds[B], ImportScale);
-                const uint32 VC = GetOrAddLocalVertex(Chunk, Model, BspVertexIds[C], ImportScale);
+    UStaticMesh* BuildAssembledChunk(const bspformat29::Bsp_29& Model, const FString& MeshesPath, const FAssembledChunk& Chunk, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, const FName& CollisionProfile, const FName& MaskedCollisionProfile, FChunkBuildStats* Stats)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(bsputils::BuildAssembledChunk);
 
-                const FVector3f N(Normal.X, Normal.Y, Normal.Z);
-                AddWedgeEntry(Chunk.RawMesh, VA, N, TexCoords[A], ComputeLightmapUVForFace(Model, F, LightmapST[A].X, LightmapST[A].Y, LightmapAtlas));
-                AddWedgeEntry(Chunk.RawMesh, VB, N, TexCoords[B], ComputeLightmapUVForFace(Model, F, LightmapST[B].X, LightmapST[B].Y, LightmapAtlas));
-                AddWedgeEntry(Chunk.RawMesh, VC, N, TexCoords[C], ComputeLightmapUVForFace(Model, F, LightmapST[C].X, LightmapST[C].Y, LightmapAtlas));
+        check(IsInGameThread());
 
-                const int32 TextureId = Model.texinfos[Face.texinfo].miptex;
-                const int32 Slot = GetOrAddMaterialSlot(Chunk, TextureId);
-                Chunk.RawMesh.FaceMaterialIndices.Add(Slot);
-                Chunk.RawMesh.FaceSmoothingMasks.Add(0);
+        const FString ContentHash = ComputeChunkContentHash(Chunk.Build, Model, MaterialsByName, MaskedTextureNames, Chunk.LightmapSize, CollisionProfile, MaskedCollisionProfile);
+
+        const FString LongPkg = MeshesPath / Chunk.MeshName;
+        if (UStaticMesh* Existing = FindExistingStaticMesh(LongPkg, Chunk.MeshName))
+        {
+            if (IsStaticMeshUpToDate(*Existing, ContentHash))
+            {
+                if (Stats)
+                {
+                    Stats->NumSkipped++;
+                }
+                return Existing;
             }
         }
 
-        if (!bAnyFace || Chunk.RawMesh.WedgeIndices.Num() == 0)
+        UPackage* Pkg = CreateAssetPackage(LongPkg);
+        UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, Chunk.MeshName);
+        BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Chunk.Build, Chunk.LightmapSize, CollisionProfile, MaskedCollisionProfile);
+        INC_DWORD_STAT(STAT_QuakeImport_MeshesBuilt);
+
+        // Written last: a mesh interrupted mid-build never carries a matching hash and is rebuilt next time.
+        if (UMetaData* MetaData = Pkg->GetMetaData())
         {
-            return false;
+            MetaData->SetValue(StaticMesh, ChunkContentHashKey, *ContentHash);
         }
 
-        const FString LongPkg = MeshesPath / MeshAssetName;
-        UPackage* Pkg = CreateAssetPackage(LongPkg);
-        UStaticMesh* StaticMesh = GetOrCreateStaticMesh(*Pkg, MeshAssetName);
+        if (Stats)
+        {
+            Stats->NumBuilt++;
+            Stats->ChangedMeshObjectPaths.Add(StaticMesh->GetPathName());
+        }
+        return StaticMesh;
+    }
+
+    bool CreateSubmodelStaticMesh(const bspformat29::Bsp_29& Model, const FString& MeshesPath, const FString& MeshAssetName, uint8 SubModelId, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, float ImportScale, const FName& DefaultCollisionProfile, const FName& MaskedCollisionProfile, FString& OutObjectPath, const bsputils::FLightmapAtlas* LightmapAtlas, FChunkBuildStats* Stats)
+    {
+        FAssembledChunk Chunk;
+        if (!AssembleSubmodelChunk(Model, SubModelId, MeshAssetName, ImportScale, LightmapAtlas, Chunk))
+        {
+            return false;
+        }
 
-        const int32 LightmapSize = 64;
-        const FName CollisionProfile = bAnyTriggerTex ? UCollisionProfile::NoCollision_ProfileName : DefaultCollisionProfile;
-        BuildStaticMesh(StaticMesh, Model, MaterialsByName, &MaskedTextureNames, Chunk, LightmapSize, CollisionProfile, MaskedCollisionProfile, LightmapAtlas == nullptr);
+        const FName CollisionProfile = Chunk.bHasTriggerTexture ? UCollisionProfile::NoCollision_ProfileName : DefaultCollisionProfile;
+        UStaticMesh* StaticMesh = BuildAssembledChunk(Model, MeshesPath, Chunk, MaterialsByName, MaskedTextureNames, CollisionProfile, MaskedCollisionProfile, Stats);
 
         OutObjectPath = StaticMesh->GetPathName();
         return true;
@@ -2000,31 +3013,64 @@ float Sraw = FVector3f::DotProduct(Unflipped, FVector3f(Ti.vecs[0][0], Ti.vecs[0
         delete rmesh;
     }
 
-    void ModelToStaticmeshes(const bspformat29::Bsp_29& model, const FString& MeshesPath, const FString& MapName, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, bool bChunkWorld, int32 WorldChunkSize, float ImportScale, bool bIncludeSky, bool bIncludeWater, const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile, const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths, TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths, const bsputils::FLightmapAtlas* LightmapAtlas)
+    void ModelToStaticmeshes(const bspformat29::Bsp_29& model, const FString& MeshesPath, const FString& MapName, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, bool bChunkWorld, int32 WorldChunkSize, float ImportScale, bool bIncludeSky, bool bIncludeWater, const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile, const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths, TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths, const bsputils::FLightmapAtlas* LightmapAtlas, FChunkBuildStats* Stats)
     {
-        if (bChunkWorld)
+        TArray<FChunkPlan> Plans;
+        PlanWorldChunks(model, MapName, bChunkWorld, WorldChunkSize, bIncludeSky, bIncludeWater, Plans);
+
+        // One chunk assembled at a time, released before the next.
+        for (const FChunkPlan& Plan : Plans)
         {
-            CreateWorldChunks(MeshesPath, MapName, model, MaterialsByName, MaskedTextureNames, WorldChunkSize, ImportScale, bIncludeSky, bIncludeWater, BspCollisionProfile, MaskedCollisionProfile, WaterCollisionProfile, SkyCollisionProfile, OutBspMeshObjectPaths, OutWaterMeshObjectPaths, OutSkyMeshObjectPaths, LightmapAtlas);
-            return;
-        }
+            FAssembledChunk Chunk;
+            if (!AssembleChunk(model, Plan, ImportScale, LightmapAtlas, Chunk))
+            {
+                continue;
+            }
 
-        CreateLeafChunks(MeshesPath, MapName, model, MaterialsByName, MaskedTextureNames, ImportScale, bIncludeSky, bIncludeWater, BspCollisionProfile, MaskedCollisionProfile, WaterCollisionProfile, SkyCollisionProfile, OutBspMeshObjectPaths, OutWaterMeshObjectPaths, OutSkyMeshObjectPaths, LightmapAtlas);
+            const FName& CollisionProfile = Chunk.Kind == EChunkSurfaceKind::Liquid ? WaterCollisionProfile : (Chunk.Kind == EChunkSurfaceKind::Sky ? SkyCollisionProfile : BspCollisionProfile);
+            TArray<FString>* OutPaths = Chunk.Kind == EChunkSurfaceKind::Liquid ? OutWaterMeshObjectPaths : (Chunk.Kind == EChunkSurfaceKind::Sky ? OutSkyMeshObjectPaths : OutBspMeshObjectPaths);
+
+            UStaticMesh* StaticMesh = BuildAssembledChunk(model, MeshesPath, Chunk, MaterialsByName, MaskedTextureNames, CollisionProfile, MaskedCollisionProfile, Stats);
+            if (OutPaths)
+            {
+                OutPaths->Add(StaticMesh->GetPathName());
+            }
+        }
     }
 
-    bool AppendNextTextureData(const FString& name, const int frame, const bspformat29::Bsp_29& model, TArray<uint8>& data)
+    bool GetTextureSequence(const bspformat29::Bsp_29& model, int32 textureIndex, TArray<int32>& outFrames)
     {
-        FString nextName = name;
-        nextName[1] += frame;
+        outFrames.Reset();
+        if (!model.textures.IsValidIndex(textureIndex))
+        {
+            return false;
+        }
+
+        const FString& Name = model.textures[textureIndex].name;
+        if (Name.Len() < 2 || Name[0] != TCHAR('+'))
+        {
+            return false;
+        }
+        const TCHAR First = FChar::ToLower(Name[1]);
+        if (First != TCHAR('0') && First != TCHAR('a'))
+        {
+            return false;
+        }
 
-         for (const auto& it : model.textures)
+        // Quake allows ten frames per sequence, +0 to +9 and +a to +j. Frames are looked up by lowercase name, as the
+        // map is keyed, so "+Alava" finds "+blava" and "+BLAVA" alike.
+        FString FrameName = Name.ToLower();
+        outFrames.Add(textureIndex);
+        for (int32 Frame = 1; Frame < 10; Frame++)
         {
-            if (it.name == nextName)
+            FrameName[1] = TCHAR(First + Frame);
+            const int32* FrameIndex = model.textureIndexByName.Find(FrameName);
+            if (!FrameIndex)
             {
-                data.Append(it.mip0);
-                return true;
+                break;
             }
+            outFrames.Add(*FrameIndex);
         }
-
-        return false;
+        return true;
     }
 } // namespace bsputils
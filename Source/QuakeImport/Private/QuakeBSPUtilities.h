@@ -4,10 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "QuakeImportCommon.h"
+#include "QuakeImportStats.h"
+#include "RawMesh.h"
+
+#include <atomic>
 
 class UTexture2D;
 class UPackage;
 class UMaterialInterface;
+class UStaticMesh;
 
 namespace bsputils
 {
@@ -142,7 +147,14 @@ namespace bsputils
             int32           numfaces;
         };
 
-        // ---- On-disk structs for BSP29 (used only for deserialization) ----
+        // Collision hull node (hulls 1 and 2). Negative children are leaf contents (ELeafContentType).
+        struct Clipnode
+        {
+            int32           planenum;
+            int32           children[2];
+        };
+
+        // ---- On-disk structs for BSP29 (used for (de)serialization) ----
 
         struct FileEdge
         {
@@ -192,6 +204,12 @@ namespace bsputils
             uint16 numfaces;
         };
 
+        struct FileClipnode
+        {
+            int32  planenum;
+            int16  children[2];
+        };
+
         struct SubModel
         {
             float   mins[3];
@@ -224,6 +242,8 @@ namespace bsputils
             unsigned        width;
             unsigned        height;
             TArray<uint8>   mip0;
+            // Authored mips 1 to 3 (width and height >> 1 to >> 3); empty from the first one out of bounds.
+            TArray<uint8>   lowerMips[3];
         };
 
         // Data storage for BSP version 29
@@ -240,9 +260,13 @@ namespace bsputils
             TArray<SubModel>    submodels;
             TArray<TexInfo>     texinfos;
             TArray<Texture>     textures;
+            // First texture of each name, keyed by the lowercase name (Quake matches names case-insensitively). Filled by BspLoader.
+            TMap<FString, int32> textureIndexByName;
             FString             entities;
             TArray<uint8>       lightdata;
             TArray<uint8>       visdata;
+            // Not read by BspLoader (the importer has no use for clip hulls); filled for WriteBspFile.
+            TArray<Clipnode>    clipnodes;
         };
     }
 
@@ -318,6 +342,12 @@ namespace bsputils
             int32 numfaces;
         };
 
+        struct FileClipnode
+        {
+            int32 planenum;
+            int32 children[2];
+        };
+
         // BSP2 model lump uses 32-bit indices.
         struct FileModel
         {
@@ -382,42 +412,232 @@ namespace bsputils
         const int32 Count = int32(Count64);
         out.Reset(Count);
         out.SetNumUninitialized(Count);
+        INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, Len);
         FMemory::Memcpy(out.GetData(), data + Pos, size_t(Len));
         return true;
     }
 
     // UNREALED Import functions
 
+    // Where a face lightmap landed. Faces with identical luxels share one rect, and near uniform lightmaps are
+    // collapsed to a single luxel (W = H = 1), so several faces may point at the same place.
     struct FLightmapAtlasFace
     {
+        // INDEX_NONE for faces without a lightmap in the atlas.
+        int32 Page = INDEX_NONE;
         int32 X = 0;
         int32 Y = 0;
         int32 W = 0;
         int32 H = 0;
         int32 TexMinS = 0;
         int32 TexMinT = 0;
+
+        // Lightstyle of each style slot (R to A = slot 0 to 3), written to the vertex colour when the atlas
+        // carries light styles. Unused slots hold style 0 over black luxels.
+        FColor Styles = FColor(0, 0, 0, 0);
+
+        // Texture-space S/T to page UV: UV = Clamp(ST * UVScale + UVBias, UVMin, UVMax), the clamp keeping
+        // samples on the centres of the face luxels.
+        FVector2f UVScale = FVector2f::ZeroVector;
+        FVector2f UVBias = FVector2f::ZeroVector;
+        FVector2f UVMin = FVector2f::ZeroVector;
+        FVector2f UVMax = FVector2f::ZeroVector;
+    };
+
+    // Storage of the atlas textures. Every encoding is sampled as is and yields the luxel value / 255.
+    enum class ELightmapEncoding : uint8
+    {
+        BGRA8,
+        BC1,
+        BC7
+    };
+
+    struct FLightmapAtlasSettings
+    {
+        bool bLightStyles = false;
+        ELightmapEncoding Encoding = ELightmapEncoding::BGRA8;
+        // Mips down to the level where the padding is one texel; face rects are aligned so they never share a mip texel.
+        bool bMips = false;
+    };
+
+    // Extra texture of a page holding one more style slot of coloured lightmaps.
+    struct FLightmapAtlasLayer
+    {
+        FString TextureObjectPath;
+        TArray<uint8> Pixels;
+    };
+
+    struct FLightmapAtlasPage
+    {
+        int32 Width = 0;
+        int32 Height = 0;
+        FString TextureObjectPath;
+
+        // BGRA8 page pixels filled by PackLightmapAtlas, released once the texture asset is created.
+        TArray<uint8> Pixels;
+
+        // Style slots 1 to NumStyleLayers - 1; empty without light styles.
+        TArray<FLightmapAtlasLayer> StyleLayers;
+
+        // Face group the page belongs to (with a page number when the group spills), empty for a shared atlas.
+        FString GroupName;
+    };
+
+    // Face lightmaps baked into vertex colours (style 0 to 3 summed at normal intensity), for targets that cannot
+    // afford a lightmap texture sample. With bTessellate faces are cut along the luxel grid, one vertex per luxel.
+    struct FVertexLighting
+    {
+        bool bTessellate = false;
+        // RGB luxels from a .lit file, parallel to lightdata; empty for mono lighting.
+        TArray<uint8> LitRgb;
     };
 
+    // Faces that get atlas pages of their own, e.g. the faces of one mesh chunk. Pages never mix groups, so a
+    // streamed out chunk takes its lightmap pages with it.
+    struct FLightmapFaceGroup
+    {
+        FString Name;
+        TArray<int32> FaceIndices;
+    };
+
+    // Face lightmaps packed into one or more pages. Maps whose lightmaps overflow a 4096 page spill into
+    // further pages; mesh sections are split per page so each samples a single lightmap texture.
+    //
+    // With light styles, the up to four lightmaps a face stores one after another are all kept, one
+    // texture per style slot: the page itself holds slot 0, StyleLayers the others.
     struct FLightmapAtlas
     {
-        int32 AtlasW = 0;
-        int32 AtlasH = 0;
-        TMap<int32, FLightmapAtlasFace> FaceToAtlas;
-        FString LightmapTextureObjectPath;
+        TArray<FLightmapAtlasPage> Pages;
+        // Indexed by BSP face.
+        TArray<FLightmapAtlasFace> FaceToAtlas;
+
+        FLightmapAtlasSettings Settings;
+
+        // Textures per page, 1 unless faces carry several styles.
+        int32 NumStyleLayers = 1;
+
+        const FLightmapAtlasFace* FindFace(int32 FaceIndex) const
+        {
+            return FaceToAtlas.IsValidIndex(FaceIndex) && FaceToAtlas[FaceIndex].Page != INDEX_NONE ? &FaceToAtlas[FaceIndex] : nullptr;
+        }
+    };
+
+    // Counters filled while building chunk meshes. Unchanged chunks (matching content hash) are skipped.
+    struct FChunkBuildStats
+    {
+        int32 NumBuilt = 0;
+        int32 NumSkipped = 0;
+        TArray<FString> ChangedMeshObjectPaths;
+    };
+
+    // A BSP face appended to a chunk. Its wedges are contiguous in the chunk raw mesh.
+    struct FChunkFace
+    {
+        int32 FaceIndex = -1;
+        int32 FirstWedge = 0;
+        int32 NumWedges = 0;
+        int32 LightmapW = 0;
+        int32 LightmapH = 0;
+    };
+
+    struct FWorldChunkBuild
+    {
+        FRawMesh RawMesh;
+        TMap<int32, int32> BspVertexToLocal;
+        // Vertices created by luxel grid tessellation, keyed by their quantized position.
+        TMap<FIntVector, int32> SplitVertexToLocal;
+        // One material slot per (texture, lightmap atlas page) pair.
+        TArray<int32> SlotToTextureId;
+        TArray<int32> SlotToLightmapPage;
+        TMap<FIntPoint, int32> TextureAndPageToSlot;
+        TArray<FChunkFace> Faces;
+    };
+
+    enum class EChunkSurfaceKind : uint8
+    {
+        Solid,
+        Liquid,
+        Sky
+    };
+
+    // Geometry of one mesh asset, assembled from BSP faces with UV1 already laid out.
+    // Assembly touches no UObject and can run off the game thread; only BuildAssembledChunk needs the game thread.
+    struct FAssembledChunk
+    {
+        FString MeshName;
+        EChunkSurfaceKind Kind = EChunkSurfaceKind::Solid;
+        FWorldChunkBuild Build;
+        int32 LightmapSize = 0;
+        bool bHasTriggerTexture = false;
     };
 
-    bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& LightmapsPath, const FString& MapName, const FString& LitFilePath, bool bOverwrite, FLightmapAtlas& OutAtlas);
+    // Faces of one mesh asset, before any geometry is generated. Plans for a whole map are cheap to keep around;
+    // chunks are assembled from them a batch at a time so peak memory stays bounded on huge maps.
+    struct FChunkPlan
+    {
+        FString MeshName;
+        EChunkSurfaceKind Kind = EChunkSurfaceKind::Solid;
+        // Faces in append order; the order is part of the chunk content hash.
+        TArray<int32> FaceIndices;
+        // Lightmap resolution used when UV1 samples the shared atlas.
+        int32 AtlasLightmapSize = 128;
+        bool bHasTriggerTexture = false;
+        // Rough size of the assembled chunk plus the copies made while building its static mesh.
+        int64 EstimatedBuildBytes = 0;
+    };
+
+    // Packs every face lightmap into atlas pages and fills their pixels. CPU only, safe off the game thread.
+    // With Groups, only the grouped faces are packed and every group gets pages of its own.
+    bool PackLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& LitFilePath, const FLightmapAtlasSettings& Settings, FLightmapAtlas& OutAtlas, const TArray<FLightmapFaceGroup>* Groups = nullptr);
+
+    // Creates or updates one texture asset per atlas page (game thread).
+    bool CreateLightmapAtlasTexture(const FString& LightmapsPath, const FString& MapName, bool bOverwrite, FLightmapAtlas& InOutAtlas);
 
+    // PackLightmapAtlas followed by CreateLightmapAtlasTexture.
+    bool BuildLightmapAtlas(const bspformat29::Bsp_29& Model, const FString& LightmapsPath, const FString& MapName, const FString& LitFilePath, const FLightmapAtlasSettings& Settings, bool bOverwrite, FLightmapAtlas& OutAtlas);
+
+    // Loads the .lit file, if any, for vertex lighting. CPU only, safe off the game thread.
+    void LoadVertexLighting(const bspformat29::Bsp_29& Model, const FString& LitFilePath, bool bTessellate, FVertexLighting& OutLighting);
+
+    // Rough size of a chunk of these faces once assembled, plus the copies made while building its static mesh.
+    int64 EstimateChunkBuildBytes(const bspformat29::Bsp_29& Model, const TArray<int32>& FaceIndices, bool bTessellated = false);
+
+    // Resident size of the atlas textures once encoded, style layers and mips included.
+    int64 GetLightmapAtlasBytes(const FLightmapAtlas& Atlas);
+
+    // Partitions submodel_0 (world) into chunk plans, grid based (bChunkWorld, WorldChunkSize) or leaf based.
+    // CPU only, safe off the game thread. Returns false if bCancel was raised before planning finished.
+    bool PlanWorldChunks(const bspformat29::Bsp_29& Model, const FString& MapName, bool bChunkWorld, int32 WorldChunkSize, bool bIncludeSky, bool bIncludeWater, TArray<FChunkPlan>& OutPlans, const std::atomic<bool>* bCancel = nullptr);
+
+    // Plans a brush entity submodel as a single chunk. Returns false for an invalid or empty submodel.
+    bool PlanSubmodelChunk(const bspformat29::Bsp_29& Model, int32 SubModelId, const FString& MeshName, FChunkPlan& OutPlan);
+
+    // Generates the geometry of a planned chunk. CPU only, safe off the game thread and for different plans in parallel.
+    // Returns false when the planned faces produce no triangles.
+    bool AssembleChunk(const bspformat29::Bsp_29& Model, const FChunkPlan& Plan, float ImportScale, const FLightmapAtlas* LightmapAtlas, FAssembledChunk& OutChunk, const FVertexLighting* VertexLighting = nullptr);
+
+    // Assembles a brush entity submodel into a single chunk. CPU only, safe off the game thread.
+    bool AssembleSubmodelChunk(const bspformat29::Bsp_29& Model, int32 SubModelId, const FString& MeshName, float ImportScale, const FLightmapAtlas* LightmapAtlas, FAssembledChunk& OutChunk);
+
+    // Builds an assembled chunk into its static mesh asset (game thread).
+    // Existing meshes whose stored content hash matches are left untouched (not rebuilt, not dirtied).
+    UStaticMesh* BuildAssembledChunk(const bspformat29::Bsp_29& Model, const FString& MeshesPath, const FAssembledChunk& Chunk, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, const FName& CollisionProfile, const FName& MaskedCollisionProfile, FChunkBuildStats* Stats = nullptr);
     
     // From a Quake BSP model, import submodels to individual staticmeshes.
     // If bChunkWorld is true, submodel_0 (world) is split into multiple meshes.
     // Chunking can be grid based (WorldChunkSize) or leaf based (when WorldChunkSize is ignored).
     // OutWorldMeshObjectPaths will be filled with object paths for the created world chunks (or submodel_0 if not chunked).
-    void ModelToStaticmeshes(const bspformat29::Bsp_29& model, const FString& MeshesPath, const FString& MapName, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, bool bChunkWorld, int32 WorldChunkSize, float ImportScale, bool bIncludeSky, bool bIncludeWater, const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile, const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths, TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths, const FLightmapAtlas* LightmapAtlas);
+    // Chunks whose content hash matches the existing mesh asset are not rebuilt; see FChunkBuildStats.
+    void ModelToStaticmeshes(const bspformat29::Bsp_29& model, const FString& MeshesPath, const FString& MapName, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, bool bChunkWorld, int32 WorldChunkSize, float ImportScale, bool bIncludeSky, bool bIncludeWater, const FName& BspCollisionProfile, const FName& MaskedCollisionProfile, const FName& WaterCollisionProfile, const FName& SkyCollisionProfile, TArray<FString>* OutBspMeshObjectPaths, TArray<FString>* OutWaterMeshObjectPaths, TArray<FString>* OutSkyMeshObjectPaths, const FLightmapAtlas* LightmapAtlas, FChunkBuildStats* Stats = nullptr);
+
+    bool CreateSubmodelStaticMesh(const bspformat29::Bsp_29& model, const FString& MeshesPath, const FString& MeshAssetName, uint8 SubModelId, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, float ImportScale, const FName& DefaultCollisionProfile, const FName& MaskedCollisionProfile, FString& OutObjectPath, const FLightmapAtlas* LightmapAtlas, FChunkBuildStats* Stats = nullptr);
 
-    bool CreateSubmodelStaticMesh(const bspformat29::Bsp_29& model, const FString& MeshesPath, const FString& MeshAssetName, uint8 SubModelId, const TMap<FString, UMaterialInterface*>& MaterialsByName, const TSet<FString>& MaskedTextureNames, float ImportScale, const FName& DefaultCollisionProfile, const FName& MaskedCollisionProfile, FString& OutObjectPath, const FLightmapAtlas* LightmapAtlas);
+    // Key of the per-page material instance of a texture on lightmap atlas page Page, "<name>@LM<Page>". Meshes fall
+    // back to the texture's own material when the key is missing, as for page 0 of a shared atlas.
+    FString GetLightmapPageMaterialName(const FString& TextureName, int32 Page);
 
-    // Append texture pixel data to array
-    bool AppendNextTextureData(const FString& name, const int frame, const bspformat29::Bsp_29& model, TArray<uint8>& data);
+    // Frames of the animation texture textureIndex starts, "+0name" or the alternate "+aname", in order up to the first
+    // missing one. Returns false for textures that do not start an animation.
+    bool GetTextureSequence(const bspformat29::Bsp_29& model, int32 textureIndex, TArray<int32>& outFrames);
 
 } // namespace bsputils
@@ -5,9 +5,19 @@
 #include "AssetToolsModule.h"
 #include "IAssetTools.h"
 #include "QuakeBSPImportAssetTypeActions.h"
+#include "QuakeImportStats.h"
 
 #define LOCTEXT_NAMESPACE "FQuakeImportModule"
 
+DEFINE_STAT(STAT_QuakeImport_Faces);
+DEFINE_STAT(STAT_QuakeImport_Triangles);
+DEFINE_STAT(STAT_QuakeImport_Chunks);
+DEFINE_STAT(STAT_QuakeImport_MeshesBuilt);
+DEFINE_STAT(STAT_QuakeImport_Textures);
+DEFINE_STAT(STAT_QuakeImport_LightmapAtlases);
+DEFINE_STAT(STAT_QuakeImport_BytesCopied);
+DEFINE_STAT(STAT_QuakeImport_PackagesSaved);
+
 void FQuakeImportModule::StartupModule()
 {
 	IAssetTools& AssetTools = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools").Get();
@@ -0,0 +1,485 @@
+#include "QuakeImportBenchmarkCommandlet.h"
+
+#include "QuakeBSPImportAsset.h"
+#include "QuakeBSPImportRunner.h"
+#include "QuakeBSPSynthetic.h"
+#include "QuakeImportCommon.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogQuakeImportBenchmark, Log, All);
+
+namespace
+{
+	using namespace QuakeBspImportRunner;
+
+	// Timed stages, in pipeline order. The first four match EPrepareStage.
+	enum class EBenchStage : uint8
+	{
+		Load,
+		Textures,
+		Atlas,
+		Geometry,
+		Entities,
+		Assemble,
+		CommitTextures,
+		CommitLightmap,
+		CommitMeshes,
+		Num
+	};
+
+	const TCHAR* GetBenchStageName(EBenchStage Stage)
+	{
+		static const TCHAR* Names[] = { TEXT("load"), TEXT("textures"), TEXT("atlas"), TEXT("geometry"), TEXT("entities"), TEXT("assemble"),
+			TEXT("commitTextures"), TEXT("commitLightmap"), TEXT("commitMeshes") };
+		static_assert(UE_ARRAY_COUNT(Names) == int32(EBenchStage::Num), "Missing stage name");
+		return Names[int32(Stage)];
+	}
+
+	struct FBenchMap
+	{
+		FString Name;
+		FString BspFilePath;
+		bool bSynthetic = false;
+		bool bBsp2 = false;
+		int64 FileBytes = 0;
+
+		int32 NumFaces = 0;
+		int32 NumTextures = 0;
+		int32 NumChunks = 0;
+		int32 NumEntityChunks = 0;
+		int32 AtlasSize = 0;
+		int32 AtlasPages = 0;
+		int64 AtlasBytes = 0;
+		bool bSucceeded = false;
+
+		// Samples per stage, one per iteration that ran the stage.
+		TArray<double> Samples[int32(EBenchStage::Num)];
+	};
+
+	// Fixed stress corpus. Sizes are chosen to cross the limits the importer has to cope with:
+	// BSP29 16-bit indices, the 4096 lightmap atlas, thousands of textures and brush entities.
+	// Scale multiplies face, texture, entity and room counts (rooms per side by its square root), so the
+	// same maps can be run far past their default size. Scaled BSP29 maps fail once they exceed the format limits.
+	TArray<bsputils::FSyntheticBspDesc> GetSyntheticCorpus(double Scale)
+	{
+		TArray<bsputils::FSyntheticBspDesc> Corpus;
+
+		auto Scaled = [Scale](int32 Count)
+		{
+			return Count > 0 ? FMath::Max(1, int32(FMath::Min(double(Count) * Scale, double(MAX_int32)))) : 0;
+		};
+
+		auto Add = [&Corpus, &Scaled](const TCHAR* Name, bool bBsp2, int32 NumFaces, int32 TileSize, int32 NumTextures, int32 NumEntities)
+		{
+			bsputils::FSyntheticBspDesc& Desc = Corpus.AddDefaulted_GetRef();
+			Desc.Name = Name;
+			Desc.bBsp2 = bBsp2;
+			Desc.NumWorldFaces = Scaled(NumFaces);
+			Desc.TileSize = TileSize;
+			Desc.NumTextures = Scaled(NumTextures);
+			Desc.NumEntities = Scaled(NumEntities);
+		};
+
+		auto AddRooms = [&Corpus, &Scaled, Scale](const TCHAR* Name, bool bBsp2, int32 RoomsPerSide, bool bSky, int32 WaterInterval, int32 NumTextures, int32 NumEntities)
+		{
+			bsputils::FSyntheticBspDesc& Desc = Corpus.AddDefaulted_GetRef();
+			Desc.Name = Name;
+			Desc.bBsp2 = bBsp2;
+			Desc.Layout = bsputils::ESyntheticLayout::Rooms;
+			Desc.RoomsX = Desc.RoomsY = FMath::Max(1, FMath::RoundToInt(RoomsPerSide * FMath::Sqrt(Scale)));
+			Desc.bSkyCeilings = bSky;
+			Desc.WaterRoomInterval = WaterInterval;
+			Desc.NumTextures = Scaled(NumTextures);
+			Desc.NumEntities = Scaled(NumEntities);
+		};
+
+		Add(TEXT("synth_small_bsp29"), false, 2048, 64, 32, 16);
+		Add(TEXT("synth_medium_bsp29"), false, 24000, 64, 128, 64);
+		Add(TEXT("synth_faces_bsp2"), true, 120000, 64, 64, 0);
+		Add(TEXT("synth_textures_bsp2"), true, 8192, 64, 4096, 0);
+		Add(TEXT("synth_atlas_overflow_bsp2"), true, 65536, 256, 64, 0);
+		Add(TEXT("synth_entities_bsp2"), true, 4096, 64, 64, 10000);
+		AddRooms(TEXT("synth_rooms_bsp29"), false, 8, false, 5, 64, 64);
+		AddRooms(TEXT("synth_rooms_bsp2"), true, 24, true, 7, 256, 1024);
+		return Corpus;
+	}
+
+	bool IsBsp2File(const FString& Path)
+	{
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Path));
+		if (!Reader || Reader->TotalSize() < 4)
+		{
+			return false;
+		}
+
+		char Ident[4];
+		Reader->Serialize(Ident, 4);
+		return FMemory::Memcmp(Ident, "BSP2", 4) == 0 || FMemory::Memcmp(Ident, "2PSB", 4) == 0;
+	}
+
+	void AddSample(FBenchMap& Map, EBenchStage Stage, double Seconds)
+	{
+		Map.Samples[int32(Stage)].Add(Seconds);
+	}
+
+	void RunIteration(FBenchMap& Map, const FWorldImportOptions& WorldOptions, const FEntitiesImportOptions& EntitiesOptions, bool bCommit)
+	{
+		TUniquePtr<FPreparedImport> Prepared = PrepareBspWorld(WorldOptions);
+		if (!Prepared)
+		{
+			Map.bSucceeded = false;
+			return;
+		}
+
+		for (int32 Stage = 0; Stage < int32(EPrepareStage::Num); Stage++)
+		{
+			AddSample(Map, EBenchStage(Stage), Prepared->StageSeconds[Stage]);
+		}
+
+		Map.NumFaces = Prepared->Model->faces.Num();
+		Map.NumTextures = Prepared->Model->textures.Num();
+		Map.NumChunks = Prepared->ChunkPlans.Num();
+		const TArray<bsputils::FLightmapAtlasPage>& Pages = Prepared->LightmapAtlas.Pages;
+		Map.AtlasSize = Prepared->bHasLightmapAtlas && Pages.Num() > 0 ? Pages[0].Width : 0;
+		Map.AtlasPages = Prepared->bHasLightmapAtlas ? Pages.Num() : 0;
+		Map.AtlasBytes = Prepared->bHasLightmapAtlas ? bsputils::GetLightmapAtlasBytes(Prepared->LightmapAtlas) : 0;
+
+		const double EntitiesStart = FPlatformTime::Seconds();
+		TUniquePtr<FPreparedImport> PreparedEntities = PrepareBspEntities(EntitiesOptions);
+		AddSample(Map, EBenchStage::Entities, FPlatformTime::Seconds() - EntitiesStart);
+		Map.NumEntityChunks = PreparedEntities ? PreparedEntities->ChunkPlans.Num() : 0;
+		PreparedEntities.Reset();
+
+		if (bCommit)
+		{
+			FImportResult Result;
+			if (!CommitBspWorld(*Prepared, WorldOptions, Result))
+			{
+				Map.bSucceeded = false;
+				return;
+			}
+
+			AddSample(Map, EBenchStage::Assemble, Result.AssembleSeconds);
+			AddSample(Map, EBenchStage::CommitTextures, Result.TexturesSeconds);
+			AddSample(Map, EBenchStage::CommitLightmap, Result.LightmapSeconds);
+			AddSample(Map, EBenchStage::CommitMeshes, Result.MeshesSeconds);
+		}
+		else
+		{
+			// Geometry only plans chunks; assemble them the way the commit does, without building meshes.
+			const double AssembleStart = FPlatformTime::Seconds();
+			const int64 BudgetBytes = int64(WorldOptions.ChunkBuildMemoryBudgetMB) * 1024 * 1024;
+			TArray<bsputils::FAssembledChunk> Batch;
+			for (int32 FirstPlan = 0; FirstPlan < Prepared->ChunkPlans.Num();)
+			{
+				const int32 NumPlans = GetChunkBatchSize(*Prepared, FirstPlan, BudgetBytes);
+				AssembleChunkBatch(*Prepared, FirstPlan, NumPlans, Batch);
+				FirstPlan += NumPlans;
+			}
+			AddSample(Map, EBenchStage::Assemble, FPlatformTime::Seconds() - AssembleStart);
+		}
+	}
+
+	double GetMin(const TArray<double>& Samples)
+	{
+		return Samples.Num() > 0 ? FMath::Min(Samples) : 0.0;
+	}
+
+	double GetMean(const TArray<double>& Samples)
+	{
+		double Sum = 0.0;
+		for (double S : Samples)
+		{
+			Sum += S;
+		}
+		return Samples.Num() > 0 ? Sum / Samples.Num() : 0.0;
+	}
+
+	TSharedRef<FJsonObject> MakeMapJson(const FBenchMap& Map)
+	{
+		TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+		Json->SetStringField(TEXT("name"), Map.Name);
+		Json->SetStringField(TEXT("source"), Map.BspFilePath);
+		Json->SetBoolField(TEXT("synthetic"), Map.bSynthetic);
+		Json->SetStringField(TEXT("format"), Map.bBsp2 ? TEXT("BSP2") : TEXT("BSP29"));
+		Json->SetBoolField(TEXT("succeeded"), Map.bSucceeded);
+		Json->SetNumberField(TEXT("fileBytes"), double(Map.FileBytes));
+		Json->SetNumberField(TEXT("faces"), Map.NumFaces);
+		Json->SetNumberField(TEXT("textures"), Map.NumTextures);
+		Json->SetNumberField(TEXT("chunks"), Map.NumChunks);
+		Json->SetNumberField(TEXT("entityChunks"), Map.NumEntityChunks);
+		// Width of the first lightmap page; 0 when the map has no lightmaps.
+		Json->SetNumberField(TEXT("atlasSize"), Map.AtlasSize);
+		Json->SetNumberField(TEXT("atlasPages"), Map.AtlasPages);
+		Json->SetNumberField(TEXT("atlasBytes"), double(Map.AtlasBytes));
+
+		TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+		for (int32 Stage = 0; Stage < int32(EBenchStage::Num); Stage++)
+		{
+			const TArray<double>& Samples = Map.Samples[Stage];
+			if (Samples.Num() == 0)
+			{
+				continue;
+			}
+
+			TSharedRef<FJsonObject> StageJson = MakeShared<FJsonObject>();
+			StageJson->SetNumberField(TEXT("min"), GetMin(Samples));
+			StageJson->SetNumberField(TEXT("mean"), GetMean(Samples));
+			StageJson->SetNumberField(TEXT("samples"), Samples.Num());
+			Stages->SetObjectField(GetBenchStageName(EBenchStage(Stage)), StageJson);
+		}
+		Json->SetObjectField(TEXT("stages"), Stages);
+		return Json;
+	}
+
+	// Compares the best time of each stage with the same map and stage in a previous result file.
+	// Stages under the noise floor are ignored so sub-millisecond jitter never fails a build.
+	int32 CompareWithBaseline(const FString& BaselinePath, const TArray<FBenchMap>& Maps, double Tolerance, TArray<TSharedPtr<FJsonValue>>& OutRegressions)
+	{
+		constexpr double NoiseFloorSeconds = 0.005;
+
+		FString BaselineText;
+		TSharedPtr<FJsonObject> Baseline;
+		if (!FFileHelper::LoadFileToString(BaselineText, *BaselinePath)
+			|| !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline) || !Baseline.IsValid())
+		{
+			UE_LOG(LogQuakeImportBenchmark, Warning, TEXT("Could not read baseline %s; skipping comparison."), *BaselinePath);
+			return 0;
+		}
+
+		TMap<FString, TSharedPtr<FJsonObject>> BaselineStagesByMap;
+		const TArray<TSharedPtr<FJsonValue>>* BaselineMaps = nullptr;
+		if (Baseline->TryGetArrayField(TEXT("maps"), BaselineMaps))
+		{
+			for (const TSharedPtr<FJsonValue>& Value : *BaselineMaps)
+			{
+				const TSharedPtr<FJsonObject>* MapObject = nullptr;
+				const TSharedPtr<FJsonObject>* StagesObject = nullptr;
+				if (Value->TryGetObject(MapObject) && (*MapObject)->TryGetObjectField(TEXT("stages"), StagesObject))
+				{
+					BaselineStagesByMap.Add((*MapObject)->GetStringField(TEXT("name")), *StagesObject);
+				}
+			}
+		}
+
+		int32 NumRegressions = 0;
+		for (const FBenchMap& Map : Maps)
+		{
+			const TSharedPtr<FJsonObject>* BaselineStages = BaselineStagesByMap.Find(Map.Name);
+			if (!BaselineStages)
+			{
+				continue;
+			}
+
+			for (int32 Stage = 0; Stage < int32(EBenchStage::Num); Stage++)
+			{
+				const TSharedPtr<FJsonObject>* BaselineStage = nullptr;
+				if (Map.Samples[Stage].Num() == 0 || !(*BaselineStages)->TryGetObjectField(GetBenchStageName(EBenchStage(Stage)), BaselineStage))
+				{
+					continue;
+				}
+
+				const double Current = GetMin(Map.Samples[Stage]);
+				const double Previous = (*BaselineStage)->GetNumberField(TEXT("min"));
+				if (Current - Previous > NoiseFloorSeconds && Current > Previous * (1.0 + Tolerance))
+				{
+					UE_LOG(LogQuakeImportBenchmark, Error, TEXT("Regression: %s %s %.3fs -> %.3fs"), *Map.Name, GetBenchStageName(EBenchStage(Stage)), Previous, Current);
+
+					TSharedRef<FJsonObject> Regression = MakeShared<FJsonObject>();
+					Regression->SetStringField(TEXT("map"), Map.Name);
+					Regression->SetStringField(TEXT("stage"), GetBenchStageName(EBenchStage(Stage)));
+					Regression->SetNumberField(TEXT("baseline"), Previous);
+					Regression->SetNumberField(TEXT("current"), Current);
+					OutRegressions.Add(MakeShared<FJsonValueObject>(Regression));
+					NumRegressions++;
+				}
+			}
+		}
+
+		return NumRegressions;
+	}
+}
+
+UQuakeImportBenchmarkCommandlet::UQuakeImportBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Time each Quake BSP import stage over a synthetic stress corpus and optional real maps.");
+	HelpUsage = TEXT("-run=QuakeImportBenchmark -nullrhi [-Corpus=<dir|manifest>] [-NoSynthetic] [-Scale=1] [-Iterations=3] [-Commit] [-Dest=/Game/Path] [-Output=<file.json>] [-Baseline=<file.json>] [-Tolerance=0.25]");
+	HelpParamNames = { TEXT("Corpus"), TEXT("NoSynthetic"), TEXT("Scale"), TEXT("Iterations"), TEXT("Commit"), TEXT("Dest"), TEXT("Output"), TEXT("Baseline"), TEXT("Tolerance") };
+	HelpParamDescriptions = {
+		TEXT("Additional BSP files: directory searched recursively, or text manifest with one path per line."),
+		TEXT("Skip the generated stress maps."),
+		TEXT("Size multiplier for the generated maps (faces, textures, entities, rooms)."),
+		TEXT("Prepare passes per map. Results report the best and mean time of each stage."),
+		TEXT("Also time asset creation (first iteration only, into -Dest)."),
+		TEXT("Long package path for -Commit assets. Defaults to /Game/QuakeImportBenchmark."),
+		TEXT("Result file. Defaults to Saved/QuakeImportBenchmark/Results.json."),
+		TEXT("Previous result file to compare against."),
+		TEXT("Allowed slowdown of a stage before it counts as a regression (0.25 = 25%).") };
+}
+
+int32 UQuakeImportBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString CorpusSource;
+	FString DestFolder = TEXT("/Game/QuakeImportBenchmark");
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("QuakeImportBenchmark") / TEXT("Results.json");
+	FString BaselinePath;
+	int32 Iterations = 3;
+	double Tolerance = 0.25;
+	double Scale = 1.0;
+
+	FParse::Value(*Params, TEXT("Corpus="), CorpusSource);
+	FParse::Value(*Params, TEXT("Dest="), DestFolder);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	FParse::Value(*Params, TEXT("Scale="), Scale);
+	const bool bSynthetic = !FParse::Param(*Params, TEXT("NoSynthetic"));
+	const bool bCommit = FParse::Param(*Params, TEXT("Commit"));
+	Iterations = FMath::Max(1, Iterations);
+	Scale = FMath::Max(0.01, Scale);
+	DestFolder.RemoveFromEnd(TEXT("/"));
+
+	TArray<FBenchMap> Maps;
+
+	if (bSynthetic)
+	{
+		const FString CorpusDir = FPaths::ProjectIntermediateDir() / TEXT("QuakeImportBenchmark") / TEXT("Corpus");
+		for (const bsputils::FSyntheticBspDesc& Desc : GetSyntheticCorpus(Scale))
+		{
+			FBenchMap& Map = Maps.AddDefaulted_GetRef();
+			Map.Name = Desc.Name;
+			Map.BspFilePath = CorpusDir / (Desc.Name + TEXT(".bsp"));
+			Map.bSynthetic = true;
+			Map.bBsp2 = Desc.bBsp2;
+
+			TArray<uint8> Data;
+			FString Error;
+			if (!bsputils::WriteSyntheticBsp(Desc, Data, Error) || !FFileHelper::SaveArrayToFile(Data, *Map.BspFilePath))
+			{
+				UE_LOG(LogQuakeImportBenchmark, Error, TEXT("%s: could not generate corpus file. %s"), *Desc.Name, *Error);
+				Map.BspFilePath.Reset();
+				continue;
+			}
+			Map.FileBytes = Data.Num();
+		}
+	}
+
+	if (!CorpusSource.IsEmpty())
+	{
+		TArray<FString> Files;
+		if (!QuakeCommon::FindBspFiles(CorpusSource, Files))
+		{
+			UE_LOG(LogQuakeImportBenchmark, Error, TEXT("No BSP files found in %s"), *CorpusSource);
+			return 1;
+		}
+
+		for (const FString& File : Files)
+		{
+			FBenchMap& Map = Maps.AddDefaulted_GetRef();
+			Map.Name = FPaths::GetBaseFilename(File);
+			Map.BspFilePath = File;
+			Map.bBsp2 = IsBsp2File(File);
+			Map.FileBytes = IFileManager::Get().FileSize(*File);
+		}
+	}
+
+	if (Maps.Num() == 0)
+	{
+		UE_LOG(LogQuakeImportBenchmark, Error, TEXT("Empty corpus. Usage: %s"), *HelpUsage);
+		return 1;
+	}
+
+	// Class default settings, so results only move when the code does. Lightmaps are on to time the atlas stage.
+	const UQuakeBSPImportAsset& Defaults = *GetDefault<UQuakeBSPImportAsset>();
+	FWorldImportOptions WorldDefaults = MakeWorldImportOptions(Defaults);
+	WorldDefaults.TargetFolderLongPackagePath = DestFolder;
+	WorldDefaults.bImportLightmaps = true;
+	WorldDefaults.WorldChunkMode = EWorldChunkMode::Grid;
+
+	FEntitiesImportOptions EntitiesDefaults = MakeEntitiesImportOptions(Defaults);
+	EntitiesDefaults.TargetFolderLongPackagePath = DestFolder;
+	EntitiesDefaults.bImportLightmaps = true;
+	EntitiesDefaults.bImportFuncDoors = true;
+	EntitiesDefaults.bImportFuncPlats = true;
+	EntitiesDefaults.bImportTriggers = true;
+
+	int32 NumFailed = 0;
+	for (FBenchMap& Map : Maps)
+	{
+		if (Map.BspFilePath.IsEmpty())
+		{
+			NumFailed++;
+			continue;
+		}
+
+		FWorldImportOptions WorldOptions = WorldDefaults;
+		WorldOptions.BspFilePath = Map.BspFilePath;
+		FEntitiesImportOptions EntitiesOptions = EntitiesDefaults;
+		EntitiesOptions.BspFilePath = Map.BspFilePath;
+
+		Map.bSucceeded = true;
+		for (int32 Iteration = 0; Iteration < Iterations && Map.bSucceeded; Iteration++)
+		{
+			RunIteration(Map, WorldOptions, EntitiesOptions, bCommit && Iteration == 0);
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+
+		if (!Map.bSucceeded)
+		{
+			NumFailed++;
+			UE_LOG(LogQuakeImportBenchmark, Error, TEXT("%s: import failed"), *Map.Name);
+			continue;
+		}
+
+		double PrepareSeconds = 0.0;
+		for (int32 Stage = 0; Stage < int32(EPrepareStage::Num); Stage++)
+		{
+			PrepareSeconds += GetMin(Map.Samples[Stage]);
+		}
+		UE_LOG(LogQuakeImportBenchmark, Display, TEXT("%s: %d faces, %d textures, %d chunks, atlas %d x %d pages, prepare %.3fs (best of %d)"),
+			*Map.Name, Map.NumFaces, Map.NumTextures, Map.NumChunks, Map.AtlasSize, Map.AtlasPages, PrepareSeconds, Iterations);
+	}
+
+	TArray<TSharedPtr<FJsonValue>> Regressions;
+	const int32 NumRegressions = BaselinePath.IsEmpty() ? 0 : CompareWithBaseline(BaselinePath, Maps, Tolerance, Regressions);
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("engineVersion"), FEngineVersion::Current().ToString());
+	Root->SetNumberField(TEXT("iterations"), Iterations);
+	Root->SetNumberField(TEXT("scale"), Scale);
+	Root->SetBoolField(TEXT("commit"), bCommit);
+	Root->SetNumberField(TEXT("failed"), NumFailed);
+
+	TArray<TSharedPtr<FJsonValue>> MapValues;
+	for (const FBenchMap& Map : Maps)
+	{
+		MapValues.Add(MakeShared<FJsonValueObject>(MakeMapJson(Map)));
+	}
+	Root->SetArrayField(TEXT("maps"), MapValues);
+	Root->SetArrayField(TEXT("regressions"), Regressions);
+
+	FString Output;
+	if (!FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Output)) || !FFileHelper::SaveStringToFile(Output, *OutputPath))
+	{
+		UE_LOG(LogQuakeImportBenchmark, Error, TEXT("Failed to write results: %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogQuakeImportBenchmark, Display, TEXT("Benchmark results written to %s (%d failed, %d regressions)"), *OutputPath, NumFailed, NumRegressions);
+	return NumFailed + NumRegressions;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "QuakeImportBenchmarkCommandlet.generated.h"
+
+// Times every import stage over a fixed corpus, for CI regression tracking:
+//   UnrealEditor-Cmd Project.uproject -run=QuakeImportBenchmark -nullrhi [-Corpus=<dir|manifest>] [-NoSynthetic] [-Scale=1]
+//     [-Iterations=3] [-Commit] [-Output=<file.json>] [-Baseline=<file.json>] [-Tolerance=0.25]
+// The built-in corpus is generated procedurally (see FSyntheticBspDesc). Returns the number of failed maps plus
+// the number of stages slower than the baseline by more than the tolerance.
+UCLASS()
+class UQuakeImportBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UQuakeImportBenchmarkCommandlet();
+    virtual int32 Main(const FString& Params) override;
+};
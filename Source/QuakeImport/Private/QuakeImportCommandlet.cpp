@@ -0,0 +1,344 @@
+#include "QuakeImportCommandlet.h"
+
+#include "QuakeBSPImportAsset.h"
+#include "QuakeBSPImportRunner.h"
+#include "QuakeImportCommon.h"
+#include "QuakeImportStats.h"
+
+#include "Dom/JsonObject.h"
+#include "FileHelpers.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Tasks/Task.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogQuakeImportCommandlet, Log, All);
+
+namespace
+{
+	using namespace QuakeBspImportRunner;
+
+	struct FMapJob
+	{
+		FString BspFilePath;
+		FWorldImportOptions WorldOptions;
+		FEntitiesImportOptions EntitiesOptions;
+		bool bImportEntities = false;
+
+		UE::Tasks::TTask<TUniquePtr<FPreparedImport>> WorldTask;
+		UE::Tasks::TTask<TUniquePtr<FPreparedImport>> EntitiesTask;
+
+		// Written by the prepare tasks, read on the game thread once they completed.
+		double WorldPrepareSeconds = 0.0;
+		double EntitiesPrepareSeconds = 0.0;
+
+		double CommitSeconds = 0.0;
+		double SaveSeconds = 0.0;
+		int32 NumTextures = 0;
+		int32 NumChunks = 0;
+		int32 NumWorldMeshes = 0;
+		int32 NumEntityMeshes = 0;
+		int32 NumMeshesBuilt = 0;
+		int32 NumMeshesSkipped = 0;
+		int32 NumPackagesSaved = 0;
+		bool bSucceeded = false;
+		FString Error;
+	};
+
+	void LaunchPrepare(FMapJob& Job)
+	{
+		Job.WorldTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Job]()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			TUniquePtr<FPreparedImport> Prepared = PrepareBspWorld(Job.WorldOptions);
+			Job.WorldPrepareSeconds = FPlatformTime::Seconds() - StartTime;
+			return Prepared;
+		});
+
+		if (Job.bImportEntities)
+		{
+			Job.EntitiesTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Job]()
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				TUniquePtr<FPreparedImport> Prepared = PrepareBspEntities(Job.EntitiesOptions);
+				Job.EntitiesPrepareSeconds = FPlatformTime::Seconds() - StartTime;
+				return Prepared;
+			});
+		}
+	}
+
+	// Saves every dirty package under the destination folder; nothing else the editor may have touched.
+	int32 SaveGeneratedPackages(const FString& DestFolder)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeImportCommandlet::SaveGeneratedPackages);
+
+		TArray<UPackage*> DirtyPackages;
+		FEditorFileUtils::GetDirtyContentPackages(DirtyPackages);
+
+		int32 NumSaved = 0;
+		for (UPackage* Package : DirtyPackages)
+		{
+			if (Package && Package->GetName().StartsWith(DestFolder + TEXT("/")))
+			{
+				QuakeCommon::SavePackage(*Package);
+				NumSaved++;
+			}
+		}
+		return NumSaved;
+	}
+
+	void CommitJob(FMapJob& Job, const FString& DestFolder)
+	{
+		Job.WorldTask.Wait();
+		if (Job.bImportEntities)
+		{
+			Job.EntitiesTask.Wait();
+		}
+
+		TUniquePtr<FPreparedImport> PreparedWorld = MoveTemp(Job.WorldTask.GetResult());
+		TUniquePtr<FPreparedImport> PreparedEntities;
+		if (Job.bImportEntities)
+		{
+			PreparedEntities = MoveTemp(Job.EntitiesTask.GetResult());
+		}
+
+		// Whichever way the commit ends, its time is reported and neither prepared import outlives the job.
+		const double CommitStart = FPlatformTime::Seconds();
+		ON_SCOPE_EXIT
+		{
+			PreparedWorld.Reset();
+			PreparedEntities.Reset();
+			if (Job.CommitSeconds == 0.0)
+			{
+				Job.CommitSeconds = FPlatformTime::Seconds() - CommitStart;
+			}
+		};
+
+		if (!PreparedWorld)
+		{
+			Job.Error = TEXT("Failed to prepare BSP world (see log).");
+			return;
+		}
+
+		Job.NumTextures = PreparedWorld->Textures.Num();
+		Job.NumChunks = PreparedWorld->ChunkPlans.Num();
+
+		FImportResult WorldResult;
+		if (!CommitBspWorld(*PreparedWorld, Job.WorldOptions, WorldResult))
+		{
+			Job.Error = TEXT("Failed to commit BSP world.");
+			return;
+		}
+		PreparedWorld.Reset();
+
+		Job.NumWorldMeshes = WorldResult.SolidMeshObjectPaths.Num() + WorldResult.LiquidMeshObjectPaths.Num() + WorldResult.SkyMeshObjectPaths.Num();
+		Job.NumMeshesBuilt = WorldResult.BuildStats.NumBuilt;
+		Job.NumMeshesSkipped = WorldResult.BuildStats.NumSkipped;
+
+		if (Job.bImportEntities)
+		{
+			FImportResult EntitiesResult;
+			if (!PreparedEntities || !CommitBspEntities(*PreparedEntities, Job.EntitiesOptions, EntitiesResult))
+			{
+				Job.Error = TEXT("Failed to import BSP entities.");
+				return;
+			}
+
+			Job.NumChunks += PreparedEntities->ChunkPlans.Num();
+			Job.NumEntityMeshes = EntitiesResult.SolidMeshObjectPaths.Num() + EntitiesResult.TriggerMeshObjectPaths.Num();
+			Job.NumMeshesBuilt += EntitiesResult.BuildStats.NumBuilt;
+			Job.NumMeshesSkipped += EntitiesResult.BuildStats.NumSkipped;
+			PreparedEntities.Reset();
+		}
+		Job.CommitSeconds = FPlatformTime::Seconds() - CommitStart;
+
+		const double SaveStart = FPlatformTime::Seconds();
+		Job.NumPackagesSaved = SaveGeneratedPackages(DestFolder);
+		Job.SaveSeconds = FPlatformTime::Seconds() - SaveStart;
+
+		Job.bSucceeded = true;
+	}
+
+	bool WriteSummary(const FString& SummaryPath, const TArray<TUniquePtr<FMapJob>>& Jobs, int32 Parallel, double WallSeconds)
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		TArray<TSharedPtr<FJsonValue>> Maps;
+
+		int32 NumFailed = 0;
+		for (const TUniquePtr<FMapJob>& Job : Jobs)
+		{
+			TSharedRef<FJsonObject> Map = MakeShared<FJsonObject>();
+			Map->SetStringField(TEXT("map"), FPaths::GetBaseFilename(Job->BspFilePath));
+			Map->SetStringField(TEXT("source"), Job->BspFilePath);
+			Map->SetBoolField(TEXT("succeeded"), Job->bSucceeded);
+			if (!Job->bSucceeded)
+			{
+				Map->SetStringField(TEXT("error"), Job->Error);
+				NumFailed++;
+			}
+			Map->SetNumberField(TEXT("worldPrepareSeconds"), Job->WorldPrepareSeconds);
+			Map->SetNumberField(TEXT("entitiesPrepareSeconds"), Job->EntitiesPrepareSeconds);
+			Map->SetNumberField(TEXT("commitSeconds"), Job->CommitSeconds);
+			Map->SetNumberField(TEXT("saveSeconds"), Job->SaveSeconds);
+			Map->SetNumberField(TEXT("textures"), Job->NumTextures);
+			Map->SetNumberField(TEXT("chunks"), Job->NumChunks);
+			Map->SetNumberField(TEXT("worldMeshes"), Job->NumWorldMeshes);
+			Map->SetNumberField(TEXT("entityMeshes"), Job->NumEntityMeshes);
+			Map->SetNumberField(TEXT("meshesBuilt"), Job->NumMeshesBuilt);
+			Map->SetNumberField(TEXT("meshesSkipped"), Job->NumMeshesSkipped);
+			Map->SetNumberField(TEXT("packagesSaved"), Job->NumPackagesSaved);
+			Maps.Add(MakeShared<FJsonValueObject>(Map));
+		}
+
+		Root->SetNumberField(TEXT("maps"), Jobs.Num());
+		Root->SetNumberField(TEXT("failed"), NumFailed);
+		Root->SetNumberField(TEXT("parallel"), Parallel);
+		Root->SetNumberField(TEXT("wallSeconds"), WallSeconds);
+		Root->SetArrayField(TEXT("results"), Maps);
+
+		FString Output;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+		if (!FJsonSerializer::Serialize(Root, Writer))
+		{
+			return false;
+		}
+		return FFileHelper::SaveStringToFile(Output, *SummaryPath);
+	}
+}
+
+UQuakeImportCommandlet::UQuakeImportCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Batch import Quake BSP files into static mesh, texture and material assets.");
+	HelpUsage = TEXT("-run=QuakeImport -Source=<dir|manifest|file.bsp> -Dest=/Game/Path [-Preset=/Game/Path/Asset] [-Entities] [-Parallel=N] [-Summary=<file.json>]");
+	HelpParamNames = { TEXT("Source"), TEXT("Dest"), TEXT("Preset"), TEXT("Entities"), TEXT("Parallel"), TEXT("Summary") };
+	HelpParamDescriptions = {
+		TEXT("BSP file, directory searched recursively for *.bsp, or text manifest with one BSP path per line."),
+		TEXT("Long package path that receives the generated assets."),
+		TEXT("UQuakeBSPImportAsset whose settings are used for every map. Class defaults if omitted."),
+		TEXT("Also import brush entities."),
+		TEXT("Number of maps prepared concurrently. Defaults to 4."),
+		TEXT("Path of the JSON summary with per map timings, counts and failures.") };
+}
+
+int32 UQuakeImportCommandlet::Main(const FString& Params)
+{
+	FString Source;
+	FString DestFolder;
+	FString PresetPath;
+	FString SummaryPath;
+	int32 Parallel = 4;
+
+	FParse::Value(*Params, TEXT("Source="), Source);
+	FParse::Value(*Params, TEXT("Dest="), DestFolder);
+	FParse::Value(*Params, TEXT("Preset="), PresetPath);
+	FParse::Value(*Params, TEXT("Summary="), SummaryPath);
+	FParse::Value(*Params, TEXT("Parallel="), Parallel);
+	const bool bImportEntities = FParse::Param(*Params, TEXT("Entities"));
+	Parallel = FMath::Max(1, Parallel);
+
+	DestFolder.RemoveFromEnd(TEXT("/"));
+	if (Source.IsEmpty() || !FPackageName::IsValidLongPackageName(DestFolder))
+	{
+		UE_LOG(LogQuakeImportCommandlet, Error, TEXT("Usage: %s"), *HelpUsage);
+		return 1;
+	}
+
+	const UQuakeBSPImportAsset* Preset = GetDefault<UQuakeBSPImportAsset>();
+	if (!PresetPath.IsEmpty())
+	{
+		Preset = LoadObject<UQuakeBSPImportAsset>(nullptr, *PresetPath);
+		if (!Preset)
+		{
+			UE_LOG(LogQuakeImportCommandlet, Error, TEXT("Preset not found: %s"), *PresetPath);
+			return 1;
+		}
+	}
+
+	TArray<FString> BspFiles;
+	if (!QuakeCommon::FindBspFiles(Source, BspFiles))
+	{
+		UE_LOG(LogQuakeImportCommandlet, Error, TEXT("No BSP files found in %s"), *Source);
+		return 1;
+	}
+
+	// Parent materials are resolved once here, on the game thread, and shared by every job.
+	const FWorldImportOptions WorldDefaults = MakeWorldImportOptions(*Preset);
+	const FEntitiesImportOptions EntitiesDefaults = MakeEntitiesImportOptions(*Preset);
+
+	TArray<TUniquePtr<FMapJob>> Jobs;
+	for (const FString& BspFile : BspFiles)
+	{
+		TUniquePtr<FMapJob> Job = MakeUnique<FMapJob>();
+		Job->BspFilePath = BspFile;
+		Job->bImportEntities = bImportEntities;
+
+		// A .lit next to the BSP is picked up automatically when the preset imports lightmaps.
+		const FString LitFile = FPaths::ChangeExtension(BspFile, TEXT("lit"));
+		const FString LitFilePath = FPaths::FileExists(LitFile) ? LitFile : FString();
+
+		Job->WorldOptions = WorldDefaults;
+		Job->WorldOptions.BspFilePath = BspFile;
+		Job->WorldOptions.LitFilePath = LitFilePath;
+		Job->WorldOptions.TargetFolderLongPackagePath = DestFolder;
+
+		Job->EntitiesOptions = EntitiesDefaults;
+		Job->EntitiesOptions.BspFilePath = BspFile;
+		Job->EntitiesOptions.LitFilePath = LitFilePath;
+		Job->EntitiesOptions.TargetFolderLongPackagePath = DestFolder;
+
+		Jobs.Add(MoveTemp(Job));
+	}
+
+	UE_LOG(LogQuakeImportCommandlet, Display, TEXT("Importing %d BSP files into %s (%d in parallel)"), Jobs.Num(), *DestFolder, Parallel);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Keep at most Parallel maps prepared ahead of the commit, which bounds memory to a few parsed maps.
+	int32 NextToLaunch = 0;
+	int32 NumFailed = 0;
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); JobIndex++)
+	{
+		while (NextToLaunch < Jobs.Num() && NextToLaunch < JobIndex + Parallel)
+		{
+			LaunchPrepare(*Jobs[NextToLaunch]);
+			NextToLaunch++;
+		}
+
+		FMapJob& Job = *Jobs[JobIndex];
+		CommitJob(Job, DestFolder);
+
+		if (Job.bSucceeded)
+		{
+			UE_LOG(LogQuakeImportCommandlet, Display, TEXT("[%d/%d] %s: %d meshes built, %d unchanged (prepare %.2fs, commit %.2fs, save %.2fs)"),
+				JobIndex + 1, Jobs.Num(), *FPaths::GetBaseFilename(Job.BspFilePath), Job.NumMeshesBuilt, Job.NumMeshesSkipped,
+				Job.WorldPrepareSeconds + Job.EntitiesPrepareSeconds, Job.CommitSeconds, Job.SaveSeconds);
+		}
+		else
+		{
+			NumFailed++;
+			UE_LOG(LogQuakeImportCommandlet, Error, TEXT("[%d/%d] %s: %s"), JobIndex + 1, Jobs.Num(), *Job.BspFilePath, *Job.Error);
+		}
+
+		// Meshes of finished maps are saved; drop them before the next commit.
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	const double WallSeconds = FPlatformTime::Seconds() - StartTime;
+	UE_LOG(LogQuakeImportCommandlet, Display, TEXT("Imported %d BSP files, %d failed, in %.2fs"), Jobs.Num() - NumFailed, NumFailed, WallSeconds);
+
+	if (!SummaryPath.IsEmpty() && !WriteSummary(SummaryPath, Jobs, Parallel, WallSeconds))
+	{
+		UE_LOG(LogQuakeImportCommandlet, Error, TEXT("Failed to write summary: %s"), *SummaryPath);
+	}
+
+	return NumFailed;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "QuakeImportCommandlet.generated.h"
+
+// Headless batch import of many BSP files, e.g. on a build machine:
+//   UnrealEditor-Cmd Project.uproject -run=QuakeImport -Source=<dir|manifest|file.bsp> -Dest=/Game/Maps
+//     [-Preset=/Game/Maps/BSP_Settings] [-Entities] [-Parallel=N] [-Summary=<file.json>] -nullrhi
+// Parse, texture, atlas and geometry stages of up to N maps run concurrently; UObject creation and saving
+// stay serialized on the game thread. Returns the number of failed maps.
+UCLASS()
+class UQuakeImportCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UQuakeImportCommandlet();
+    virtual int32 Main(const FString& Params) override;
+};
@@ -1,22 +1,68 @@
 #include "QuakeImportCommon.h"
 
+#include "QuakeImportStats.h"
+
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "Interfaces/IPluginManager.h"
+#include "Materials/MaterialExpressionAdd.h"
+#include "Materials/MaterialExpressionAppendVector.h"
+#include "Materials/MaterialExpressionCollectionParameter.h"
 #include "Materials/MaterialExpressionConstant.h"
+#include "Materials/MaterialExpressionCustom.h"
+#include "Materials/MaterialExpressionFloor.h"
+#include "Materials/MaterialExpressionFmod.h"
+#include "Materials/MaterialExpressionMax.h"
+#include "Materials/MaterialExpressionMultiply.h"
+#include "Materials/MaterialExpressionOneMinus.h"
+#include "Materials/MaterialExpressionScalarParameter.h"
+#include "Materials/MaterialExpressionTextureCoordinate.h"
 #include "Materials/MaterialExpressionTextureSampleParameter2D.h"
+#include "Materials/MaterialExpressionTextureSampleParameter2DArray.h"
+#include "Materials/MaterialExpressionTime.h"
+#include "Materials/MaterialExpressionVertexColor.h"
 #include "Engine/Texture2D.h"
+#include "Engine/Texture2DArray.h"
 #include "Factories/MaterialFactoryNew.h"
 #include "Factories/TextureFactory.h"
+#include "HAL/FileManager.h"
 #include "Materials/Material.h"
 #include "Materials/MaterialInstanceConstant.h"
+#include "Materials/MaterialParameterCollection.h"
 #include "Misc/FileHelper.h"
 #include "Misc/PackageName.h"
+#include "Misc/Paths.h"
 #include "UObject/SavePackage.h"
 #include "UObject/Package.h"
 
+#if PLATFORM_CPU_X86_FAMILY
+#include <immintrin.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#endif
+
+// The AVX2 palette expansion is compiled for every x86 build and picked at runtime unless the target always has
+// AVX2; default editor builds only assume SSE4.
+#if PLATFORM_CPU_X86_FAMILY && (PLATFORM_ALWAYS_HAS_AVX_2 || PLATFORM_WINDOWS || PLATFORM_LINUX)
+#define QUAKEIMPORT_AVX2_PALETTE_EXPAND 1
+#if PLATFORM_ALWAYS_HAS_AVX_2 || !(defined(__clang__) || defined(__GNUC__))
+#define QUAKEIMPORT_AVX2_TARGET
+#else
+#define QUAKEIMPORT_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define QUAKEIMPORT_AVX2_PALETTE_EXPAND 0
+#endif
+
 namespace QuakeCommon
 {
     static const FName ColorParamName(TEXT("Color"));
+    static const FName ColorArrayParamName(TEXT("ColorArray"));
+    static const FName AnimationFramesParamName(TEXT("AnimationFrames"));
+    static const FName PaletteLUTParamName(TEXT("PaletteLUT"));
+    static const FName ColormapParamName(TEXT("Colormap"));
+    static const FName PaletteIndexedParamName(TEXT("PaletteIndexed"));
+    static const FName FullbrightInAlphaParamName(TEXT("FullbrightInAlpha"));
+    static const FName LightmapParamName(TEXT("Lightmap"));
 
     static bool IsPlatformDataValid(const UTexture2D* Texture)
     {
@@ -45,6 +91,20 @@ namespace QuakeCommon
         return false;
     }
 
+	bool LoadColormap(TArray<uint8>& outColormap)
+	{
+		const FString ColormapFilename = IPluginManager::Get().FindPlugin(TEXT("QuakeImport"))->GetContentDir() / FString("colormap.lmp");
+
+		// The file ends with one extra byte, the first fullbright row in some versions; only the light levels are kept.
+		if (!FFileHelper::LoadFileToArray(outColormap, *ColormapFilename) || outColormap.Num() < ColormapLevels * 256)
+		{
+			outColormap.Empty();
+			return false;
+		}
+		outColormap.SetNum(ColormapLevels * 256);
+		return true;
+	}
+
 	UTexture2D* CreateUTexture2D(const FString& name, int width, int height, const TArray<uint8>& data, UPackage& texturePackage, const TArray<QColor>& pal, bool bUsePaletteAlpha, bool savePackage)
 	{
 		// Defensive validation: some BSPs reference external WAD textures (or contain bad miptex headers)
@@ -73,15 +133,8 @@ namespace QuakeCommon
 			}
 		}
 
-		TArray<uint8> FinalData;
-		FinalData.Reserve(int32(PixelCount) * 4);
-		for (const uint8& It : data)
-		{
-			FinalData.Add(pal[It].b);
-			FinalData.Add(pal[It].g);
-			FinalData.Add(pal[It].r);
-			FinalData.Add((bUsePaletteAlpha && It == 255) ? 0 : 255);
-		}
+		FPaletteLUT LUT;
+		BuildPaletteLUT(pal, bUsePaletteAlpha ? EPaletteLUTVariant::Masked : EPaletteLUTVariant::Opaque, LUT);
 
 		UTexture2D* Texture = NewObject<UTexture2D>(&texturePackage, FName(*FinalName), RF_Public | RF_Standalone);
 		if (!Texture)
@@ -107,12 +160,12 @@ namespace QuakeCommon
 		TexMip->BulkData.Lock(LOCK_READ_WRITE);
 		const uint32 TextureDataSize = (width * height) * sizeof(uint8) * 4;
 		uint8* TextureData = (uint8*)TexMip->BulkData.Realloc(TextureDataSize);
-		FMemory::Memcpy(TextureData, FinalData.GetData(), TextureDataSize);
-		TexMip->BulkData.Unlock();
+		ExpandPaletteIndices(data.GetData(), PixelCount, LUT, TextureData);
 
 		Texture->MipGenSettings = TMGS_NoMipmaps;
 		Texture->CompressionSettings = TextureCompressionSettings::TC_Default;
-		Texture->Source.Init(width, height, 1, 1, TSF_BGRA8, FinalData.GetData());
+		Texture->Source.Init(width, height, 1, 1, TSF_BGRA8, TextureData);
+		TexMip->BulkData.Unlock();
 
 		FAssetRegistryModule::AssetCreated(Texture);
 		Texture->UpdateResource();
@@ -147,16 +200,336 @@ namespace QuakeCommon
 		}
 
 		TArray<uint8> FinalData;
-		FinalData.Reserve(int32(PixelCount) * 4);
-		for (const uint8& It : data)
+		ExpandPaletteToBGRA(data, pal, bUsePaletteAlpha, FinalData);
+		return CreateOrUpdatePaletteUTexture2DFromBGRA(name, width, height, FinalData, texturePackage, true);
+	}
+
+	void BuildPaletteLUT(const TArray<QColor>& pal, EPaletteLUTVariant variant, FPaletteLUT& outLUT)
+	{
+		for (int32 Index = 0; Index < 256; Index++)
+		{
+			const QColor Color = pal.IsValidIndex(Index) ? pal[Index] : QColor{ 0, 0, 0 };
+			uint8 Alpha = 255;
+			if (variant == EPaletteLUTVariant::Masked)
+			{
+				Alpha = Index == 255 ? 0 : 255;
+			}
+			else if (variant == EPaletteLUTVariant::Fullbright)
+			{
+				Alpha = Index >= FirstFullbrightIndex ? 255 : 0;
+			}
+			outLUT.Entries[Index] = FColor(Color.r, Color.g, Color.b, Alpha).ToPackedARGB();
+		}
+	}
+
+#if QUAKEIMPORT_AVX2_PALETTE_EXPAND
+	// Eight indices widened to 32 bits, then one gather from the table. Returns how many texels it expanded.
+	static QUAKEIMPORT_AVX2_TARGET int64 ExpandPaletteIndicesAVX2(const uint8* indices, int64 count, const FPaletteLUT& lut, uint32* out)
+	{
+		int64 I = 0;
+		for (; I + 8 <= count; I += 8)
+		{
+			const __m256i Index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + I)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + I), _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut.Entries), Index, 4));
+		}
+		return I;
+	}
+
+	static bool CanExpandPaletteIndicesAVX2()
+	{
+#if PLATFORM_ALWAYS_HAS_AVX_2
+		return true;
+#else
+		static const bool bHasAVX2 = FPlatformMisc::HasAVX2InstructionSupport();
+		return bHasAVX2;
+#endif
+	}
+#elif PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+	// Sixteen indices at a time, one byte plane of the table per channel. Each plane is four 64 entry TBL lookups:
+	// TBX keeps the lane for indices outside its quarter, which wrap past 63 after the subtract.
+	static int64 ExpandPaletteIndicesNEON(const uint8* indices, int64 count, const FPaletteLUT& lut, uint8* outBGRA)
+	{
+		if (count < 64)
+		{
+			return 0;
+		}
+
+		alignas(16) uint8 Planes[4][256];
+		for (int32 Index = 0; Index < 256; Index++)
+		{
+			const uint32 Entry = lut.Entries[Index];
+			Planes[0][Index] = uint8(Entry);
+			Planes[1][Index] = uint8(Entry >> 8);
+			Planes[2][Index] = uint8(Entry >> 16);
+			Planes[3][Index] = uint8(Entry >> 24);
+		}
+
+		const uint8x16_t Quarter = vdupq_n_u8(64);
+		int64 I = 0;
+		for (; I + 16 <= count; I += 16)
 		{
-			FinalData.Add(pal[It].b);
-			FinalData.Add(pal[It].g);
-			FinalData.Add(pal[It].r);
-			FinalData.Add((bUsePaletteAlpha && It == 255) ? 0 : 255);
+			const uint8x16_t Index0 = vld1q_u8(indices + I);
+			const uint8x16_t Index1 = vsubq_u8(Index0, Quarter);
+			const uint8x16_t Index2 = vsubq_u8(Index1, Quarter);
+			const uint8x16_t Index3 = vsubq_u8(Index2, Quarter);
+
+			uint8x16x4_t Bgra;
+			for (int32 Channel = 0; Channel < 4; Channel++)
+			{
+				const uint8* Plane = Planes[Channel];
+				uint8x16_t Value = vqtbl4q_u8(vld1q_u8_x4(Plane), Index0);
+				Value = vqtbx4q_u8(Value, vld1q_u8_x4(Plane + 64), Index1);
+				Value = vqtbx4q_u8(Value, vld1q_u8_x4(Plane + 128), Index2);
+				Bgra.val[Channel] = vqtbx4q_u8(Value, vld1q_u8_x4(Plane + 192), Index3);
+			}
+			vst4q_u8(outBGRA + I * 4, Bgra);
+		}
+		return I;
+	}
+#endif
+
+	void ExpandPaletteIndices(const uint8* indices, int64 count, const FPaletteLUT& lut, uint8* outBGRA)
+	{
+		uint32* Out = reinterpret_cast<uint32*>(outBGRA);
+		int64 I = 0;
+#if QUAKEIMPORT_AVX2_PALETTE_EXPAND
+		if (CanExpandPaletteIndicesAVX2())
+		{
+			I = ExpandPaletteIndicesAVX2(indices, count, lut, Out);
+		}
+#elif PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		I = ExpandPaletteIndicesNEON(indices, count, lut, outBGRA);
+#endif
+		for (; I + 4 <= count; I += 4)
+		{
+			Out[I + 0] = lut.Entries[indices[I + 0]];
+			Out[I + 1] = lut.Entries[indices[I + 1]];
+			Out[I + 2] = lut.Entries[indices[I + 2]];
+			Out[I + 3] = lut.Entries[indices[I + 3]];
+		}
+		for (; I < count; I++)
+		{
+			Out[I] = lut.Entries[indices[I]];
+		}
+	}
+
+	void ExpandPaletteToBGRA(const TArray<uint8>& data, const TArray<QColor>& pal, bool bUsePaletteAlpha, TArray<uint8>& outBGRA)
+	{
+		FPaletteLUT LUT;
+		BuildPaletteLUT(pal, bUsePaletteAlpha ? EPaletteLUTVariant::Masked : EPaletteLUTVariant::Opaque, LUT);
+		ExpandPaletteToBGRA(data, LUT, outBGRA);
+	}
+
+	void ExpandPaletteToBGRA(const TArray<uint8>& data, const FPaletteLUT& lut, TArray<uint8>& outBGRA)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeCommon::ExpandPaletteToBGRA);
+		INC_MEMORY_STAT_BY(STAT_QuakeImport_BytesCopied, int64(data.Num()) * 4);
+
+		outBGRA.SetNumUninitialized(data.Num() * 4);
+		ExpandPaletteIndices(data.GetData(), data.Num(), lut, outBGRA.GetData());
+	}
+
+	int32 GetBytesPerTexel(EPaletteTextureFormat format)
+	{
+		return format == EPaletteTextureFormat::Indexed ? 1 : 4;
+	}
+
+	void ResamplePaletteIndicesNearest(const uint8* src, int srcWidth, int srcHeight, uint8* dst, int dstWidth, int dstHeight)
+	{
+		for (int32 Y = 0; Y < dstHeight; Y++)
+		{
+			const uint8* SrcRow = src + int64(int64(Y) * srcHeight / dstHeight) * srcWidth;
+			for (int32 X = 0; X < dstWidth; X++)
+			{
+				dst[int64(Y) * dstWidth + X] = SrcRow[int64(X) * srcWidth / dstWidth];
+			}
 		}
+	}
+
+	static int64 GetMipChainBytes(int width, int height, int32 numMips, int32 numSlices = 1, int32 bytesPerTexel = 4)
+	{
+		int64 Bytes = 0;
+		for (int32 Mip = 0; Mip < numMips; Mip++)
+		{
+			Bytes += int64(FMath::Max(width >> Mip, 1)) * FMath::Max(height >> Mip, 1) * bytesPerTexel * numSlices;
+		}
+		return Bytes;
+	}
+
+	int32 AppendBoxFilteredMipsBGRA(TArray<uint8>& chain, int width, int height, int32 numMips, int32 numSlices)
+	{
+		int64 SrcOfs = GetMipChainBytes(width, height, numMips - 1, numSlices);
+		int32 SrcW = FMath::Max(width >> (numMips - 1), 1);
+		int32 SrcH = FMath::Max(height >> (numMips - 1), 1);
+		while (SrcW > 1 || SrcH > 1)
+		{
+			const int32 DstW = FMath::Max(SrcW / 2, 1);
+			const int32 DstH = FMath::Max(SrcH / 2, 1);
+			const int64 DstOfs = chain.Num();
+			chain.AddUninitialized(int64(DstW) * DstH * 4 * numSlices);
 
+			for (int32 Slice = 0; Slice < numSlices; Slice++)
+			{
+				const uint8* Src = chain.GetData() + SrcOfs + int64(Slice) * SrcW * SrcH * 4;
+				uint8* Dst = chain.GetData() + DstOfs + int64(Slice) * DstW * DstH * 4;
+				for (int32 Y = 0; Y < DstH; Y++)
+				{
+					const uint8* Row0 = Src + int64(Y * 2) * SrcW * 4;
+					const uint8* Row1 = Src + int64(FMath::Min(Y * 2 + 1, SrcH - 1)) * SrcW * 4;
+					for (int32 X = 0; X < DstW; X++)
+					{
+						const int32 X0 = X * 2 * 4;
+						const int32 X1 = FMath::Min(X * 2 + 1, SrcW - 1) * 4;
+						for (int32 C = 0; C < 4; C++)
+						{
+							const int32 Sum = Row0[X0 + C] + Row0[X1 + C] + Row1[X0 + C] + Row1[X1 + C];
+							Dst[(int64(Y) * DstW + X) * 4 + C] = uint8((Sum + 2) / 4);
+						}
+					}
+				}
+			}
+
+			SrcOfs = DstOfs;
+			SrcW = DstW;
+			SrcH = DstH;
+			numMips++;
+		}
+		return numMips;
+	}
+
+	// Nearest palette color among indices first to last.
+	static uint8 FindNearestPaletteIndex(const TArray<QColor>& pal, int32 R, int32 G, int32 B, int32 first, int32 last)
+	{
+		uint8 Best = uint8(first);
+		int32 BestDistance = MAX_int32;
+		for (int32 Index = first; Index <= FMath::Min(pal.Num() - 1, last); Index++)
+		{
+			const int32 DR = pal[Index].r - R;
+			const int32 DG = pal[Index].g - G;
+			const int32 DB = pal[Index].b - B;
+			const int32 Distance = DR * DR + DG * DG + DB * DB;
+			if (Distance < BestDistance)
+			{
+				Best = uint8(Index);
+				BestDistance = Distance;
+			}
+		}
+		return Best;
+	}
+
+	int32 AppendPaletteMipsIndexed(TArray<uint8>& chain, int width, int height, int32 numMips, const TArray<QColor>& pal, bool bMasked, int32 numSlices)
+	{
+		// 255 is the transparent index of masked textures, never a color there.
+		const int32 LastFullbrightIndex = bMasked ? 254 : 255;
+
+		int64 SrcOfs = GetMipChainBytes(width, height, numMips - 1, numSlices, 1);
+		int32 SrcW = FMath::Max(width >> (numMips - 1), 1);
+		int32 SrcH = FMath::Max(height >> (numMips - 1), 1);
+		while (SrcW > 1 || SrcH > 1)
+		{
+			const int32 DstW = FMath::Max(SrcW / 2, 1);
+			const int32 DstH = FMath::Max(SrcH / 2, 1);
+			const int64 DstOfs = chain.Num();
+			chain.AddUninitialized(int64(DstW) * DstH * numSlices);
+
+			for (int32 Slice = 0; Slice < numSlices; Slice++)
+			{
+				const uint8* Src = chain.GetData() + SrcOfs + int64(Slice) * SrcW * SrcH;
+				uint8* Dst = chain.GetData() + DstOfs + int64(Slice) * DstW * DstH;
+				for (int32 Y = 0; Y < DstH; Y++)
+				{
+					const int32 Y0 = Y * 2;
+					const int32 Y1 = FMath::Min(Y * 2 + 1, SrcH - 1);
+					for (int32 X = 0; X < DstW; X++)
+					{
+						const int32 X0 = X * 2;
+						const int32 X1 = FMath::Min(X * 2 + 1, SrcW - 1);
+						const uint8 Block[4] = { Src[Y0 * SrcW + X0], Src[Y0 * SrcW + X1], Src[Y1 * SrcW + X0], Src[Y1 * SrcW + X1] };
+
+						int32 R = 0, G = 0, B = 0, NumOpaque = 0, NumFullbright = 0;
+						for (const uint8 Index : Block)
+						{
+							if ((!bMasked || Index != 255) && pal.IsValidIndex(Index))
+							{
+								R += pal[Index].r;
+								G += pal[Index].g;
+								B += pal[Index].b;
+								NumOpaque++;
+								NumFullbright += Index >= FirstFullbrightIndex ? 1 : 0;
+							}
+						}
+						if (NumOpaque < 2)
+						{
+							Dst[int64(Y) * DstW + X] = uint8(255);
+							continue;
+						}
+
+						// Mostly fullbright blocks stay fullbright and the others stay lit, so a mip never changes how
+						// light affects a texel.
+						const bool bFullbright = NumFullbright * 2 > NumOpaque;
+						Dst[int64(Y) * DstW + X] = FindNearestPaletteIndex(pal, R / NumOpaque, G / NumOpaque, B / NumOpaque,
+							bFullbright ? FirstFullbrightIndex : 0, bFullbright ? LastFullbrightIndex : FirstFullbrightIndex - 1);
+					}
+				}
+			}
+
+			SrcOfs = DstOfs;
+			SrcW = DstW;
+			SrcH = DstH;
+			numMips++;
+		}
+		return numMips;
+	}
+
+	// Settings shared by the palette textures and texture arrays.
+	static void ApplyPaletteTextureSettings(UTexture& texture, int32 numMips, EPaletteTextureFormat format)
+	{
+		texture.SRGB = format != EPaletteTextureFormat::Indexed;
+		texture.Filter = TF_Nearest;
+		texture.LODGroup = TEXTUREGROUP_Pixels2D;
+		// Only a mip chain lets distant surfaces stream out their top mips.
+		texture.NeverStream = numMips <= 1;
+		texture.MipGenSettings = numMips > 1 ? TMGS_LeaveExistingMips : TMGS_NoMipmaps;
+		switch (format)
+		{
+		case EPaletteTextureFormat::Indexed:
+			// Indices must reach the material unfiltered and uncompressed.
+			texture.CompressionSettings = TextureCompressionSettings::TC_Grayscale;
+			break;
+		case EPaletteTextureFormat::BC7:
+			texture.CompressionSettings = TextureCompressionSettings::TC_BC7;
+			break;
+		default:
+			// TC_Default builds DXT1 (BC1) without alpha, DXT5 (BC3) with it.
+			texture.CompressionSettings = TextureCompressionSettings::TC_Default;
+			break;
+		}
+		texture.CompressionNoAlpha = format == EPaletteTextureFormat::BC1;
+	}
+
+	UTexture2D* CreateOrUpdatePaletteUTexture2DFromBGRA(const FString& name, int width, int height, const TArray<uint8>& pixels, UPackage& texturePackage, bool bOverwrite, int32 numMips, EPaletteTextureFormat format)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeCommon::CreateOrUpdatePaletteUTexture2DFromBGRA);
+
+		if (width <= 0 || height <= 0 || width > 8192 || height > 8192 || numMips < 1)
+		{
+			return nullptr;
+		}
+
+		const int32 BytesPerTexel = GetBytesPerTexel(format);
+		const int64 PixelCount = int64(width) * int64(height);
+		if (PixelCount <= 0 || pixels.Num() != GetMipChainBytes(width, height, numMips, 1, BytesPerTexel))
+		{
+			return nullptr;
+		}
+
+		const FString FinalName = TEXT("T_") + name;
 		UTexture2D* Texture = CheckIfAssetExist<UTexture2D>(FinalName, texturePackage);
+		if (Texture && !bOverwrite && IsPlatformDataValid(Texture))
+		{
+			return Texture;
+		}
+
 		if (!Texture)
 		{
 			Texture = NewObject<UTexture2D>(&texturePackage, FName(*FinalName), RF_Public | RF_Standalone);
@@ -168,12 +541,7 @@ namespace QuakeCommon
 		}
 
 		Texture->PreEditChange(nullptr);
-		Texture->SRGB = true;
-		Texture->Filter = TF_Nearest;
-		Texture->LODGroup = TEXTUREGROUP_Pixels2D;
-		Texture->NeverStream = true;
-		Texture->MipGenSettings = TMGS_NoMipmaps;
-		Texture->CompressionSettings = TextureCompressionSettings::TC_Default;
+		ApplyPaletteTextureSettings(*Texture, numMips, format);
 
 		FTexturePlatformData* PlatformData = Texture->GetPlatformData();
 		if (!PlatformData)
@@ -183,20 +551,67 @@ namespace QuakeCommon
 		}
 		PlatformData->SizeX = width;
 		PlatformData->SizeY = height;
-		PlatformData->PixelFormat = PF_B8G8R8A8;
+		PlatformData->PixelFormat = format == EPaletteTextureFormat::Indexed ? PF_G8 : PF_B8G8R8A8;
 
 		PlatformData->Mips.Empty();
-		const int32 MipIndex = PlatformData->Mips.Add(new FTexture2DMipMap());
-		FTexture2DMipMap* TexMip = &PlatformData->Mips[MipIndex];
-		TexMip->SizeX = width;
-		TexMip->SizeY = height;
-		TexMip->BulkData.Lock(LOCK_READ_WRITE);
-		const uint32 TextureDataSize = (width * height) * sizeof(uint8) * 4;
-		uint8* TextureData = (uint8*)TexMip->BulkData.Realloc(TextureDataSize);
-		FMemory::Memcpy(TextureData, FinalData.GetData(), TextureDataSize);
-		TexMip->BulkData.Unlock();
+		int64 MipOffset = 0;
+		for (int32 Mip = 0; Mip < numMips; Mip++)
+		{
+			FTexture2DMipMap* TexMip = new FTexture2DMipMap();
+			PlatformData->Mips.Add(TexMip);
+			TexMip->SizeX = FMath::Max(width >> Mip, 1);
+			TexMip->SizeY = FMath::Max(height >> Mip, 1);
+			TexMip->BulkData.Lock(LOCK_READ_WRITE);
+			const uint32 TextureDataSize = uint32(TexMip->SizeX * TexMip->SizeY) * BytesPerTexel;
+			uint8* TextureData = (uint8*)TexMip->BulkData.Realloc(TextureDataSize);
+			FMemory::Memcpy(TextureData, pixels.GetData() + MipOffset, TextureDataSize);
+			TexMip->BulkData.Unlock();
+			MipOffset += TextureDataSize;
+		}
 
-		Texture->Source.Init(width, height, 1, 1, TSF_BGRA8, FinalData.GetData());
+		Texture->Source.Init(width, height, 1, numMips, format == EPaletteTextureFormat::Indexed ? TSF_G8 : TSF_BGRA8, pixels.GetData());
+		Texture->UpdateResource();
+		Texture->MarkPackageDirty();
+		texturePackage.MarkPackageDirty();
+		Texture->PostEditChange();
+		return Texture;
+	}
+
+	UTexture2DArray* CreateOrUpdatePaletteUTexture2DArrayFromBGRA(const FString& name, int width, int height, int32 numSlices, const TArray<uint8>& pixels, UPackage& texturePackage, bool bOverwrite, int32 numMips, EPaletteTextureFormat format)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeCommon::CreateOrUpdatePaletteUTexture2DArrayFromBGRA);
+
+		if (width <= 0 || height <= 0 || width > 8192 || height > 8192 || numSlices < 1 || numMips < 1)
+		{
+			return nullptr;
+		}
+		if (pixels.Num() != GetMipChainBytes(width, height, numMips, numSlices, GetBytesPerTexel(format)))
+		{
+			return nullptr;
+		}
+
+		const FString FinalName = TEXT("TA_") + name;
+		UTexture2DArray* Texture = CheckIfAssetExist<UTexture2DArray>(FinalName, texturePackage);
+		if (Texture && !bOverwrite && Texture->Source.IsValid())
+		{
+			return Texture;
+		}
+
+		if (!Texture)
+		{
+			Texture = NewObject<UTexture2DArray>(&texturePackage, FName(*FinalName), RF_Public | RF_Standalone);
+			if (!Texture)
+			{
+				return nullptr;
+			}
+			FAssetRegistryModule::AssetCreated(Texture);
+		}
+
+		Texture->PreEditChange(nullptr);
+		ApplyPaletteTextureSettings(*Texture, numMips, format);
+
+		// Source layers of an array are its slices, stored slice after slice within each mip.
+		Texture->Source.Init(width, height, numSlices, numMips, format == EPaletteTextureFormat::Indexed ? TSF_G8 : TSF_BGRA8, pixels.GetData());
 		Texture->UpdateResource();
 		Texture->MarkPackageDirty();
 		texturePackage.MarkPackageDirty();
@@ -206,6 +621,8 @@ namespace QuakeCommon
 
 	UTexture2D* CreateOrUpdateUTexture2DFromBGRA(const FString& name, int width, int height, const TArray<uint8>& data, UPackage& texturePackage, bool bOverwrite, bool savePackage)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeCommon::CreateOrUpdateUTexture2DFromBGRA);
+
 		if (width <= 0 || height <= 0 || width > 8192 || height > 8192)
 		{
 			return nullptr;
@@ -432,6 +849,272 @@ namespace QuakeCommon
         return Material;
     }
 
+	FString GetSurfaceMaterialName(const FSurfaceMaterialFeatures& features)
+	{
+		FString Name = TEXT("M_QuakeSurface");
+		if (features.bMasked)
+		{
+			Name += TEXT("_Masked");
+		}
+		if (features.bAnimated)
+		{
+			Name += TEXT("_Anim");
+		}
+		if (features.bPaletteIndexed)
+		{
+			Name += TEXT("_Indexed");
+		}
+		if (features.bFullbrightInAlpha)
+		{
+			Name += TEXT("_FB");
+		}
+		if (features.bLightmap)
+		{
+			Name += features.bLightStyles ? FString::Printf(TEXT("_Styles%d"), features.NumStyleLayers) : FString(TEXT("_LM"));
+		}
+		return Name;
+	}
+
+	template<typename ExpressionType>
+	static ExpressionType* AddMaterialExpression(UMaterial& material, int32 x, int32 y)
+	{
+		ExpressionType* Expression = NewObject<ExpressionType>(&material);
+		Expression->MaterialExpressionEditorX = x;
+		Expression->MaterialExpressionEditorY = y;
+		material.GetEditorOnlyData()->ExpressionCollection.Expressions.Add(Expression);
+		return Expression;
+	}
+
+	// The sampler type has to match the default texture, or the material fails to compile.
+	static UMaterialExpressionTextureSampleParameter2D* AddTextureParameter(UMaterial& material, FName name, UTexture* texture, int32 x, int32 y)
+	{
+		UMaterialExpressionTextureSampleParameter2D* TexParam = AddMaterialExpression<UMaterialExpressionTextureSampleParameter2D>(material, x, y);
+		TexParam->ParameterName = name;
+		TexParam->Texture = texture;
+		TexParam->SamplerType = UMaterialExpressionTextureBase::GetSamplerTypeForTexture(texture);
+		return TexParam;
+	}
+
+	// "ColorArray" slice floor(Time * 5) modulo "AnimationFrames": Quake steps texture animations five times a second.
+	static UMaterialExpression* AddAnimatedColorSample(UMaterial& material, UTexture2DArray& frames)
+	{
+		UMaterialExpressionTime* Time = AddMaterialExpression<UMaterialExpressionTime>(material, -1700, -200);
+
+		UMaterialExpressionMultiply* FrameTime = AddMaterialExpression<UMaterialExpressionMultiply>(material, -1550, -200);
+		FrameTime->A.Connect(0, Time);
+		FrameTime->ConstB = 5.0f;
+
+		UMaterialExpressionScalarParameter* NumFrames = AddMaterialExpression<UMaterialExpressionScalarParameter>(material, -1700, -50);
+		NumFrames->ParameterName = AnimationFramesParamName;
+		NumFrames->DefaultValue = 1.0f;
+
+		UMaterialExpressionMax* SafeNumFrames = AddMaterialExpression<UMaterialExpressionMax>(material, -1550, -50);
+		SafeNumFrames->A.Connect(0, NumFrames);
+		SafeNumFrames->ConstB = 1.0f;
+
+		UMaterialExpressionFmod* Cycle = AddMaterialExpression<UMaterialExpressionFmod>(material, -1400, -150);
+		Cycle->A.Connect(0, FrameTime);
+		Cycle->B.Connect(0, SafeNumFrames);
+
+		UMaterialExpressionFloor* Frame = AddMaterialExpression<UMaterialExpressionFloor>(material, -1250, -150);
+		Frame->Input.Connect(0, Cycle);
+
+		UMaterialExpressionTextureCoordinate* UV = AddMaterialExpression<UMaterialExpressionTextureCoordinate>(material, -1250, -300);
+
+		UMaterialExpressionAppendVector* Coordinates = AddMaterialExpression<UMaterialExpressionAppendVector>(material, -1100, -200);
+		Coordinates->A.Connect(0, UV);
+		Coordinates->B.Connect(0, Frame);
+
+		UMaterialExpressionTextureSampleParameter2DArray* ArrayParam = AddMaterialExpression<UMaterialExpressionTextureSampleParameter2DArray>(material, -900, 0);
+		ArrayParam->ParameterName = ColorArrayParamName;
+		ArrayParam->Texture = &frames;
+		ArrayParam->SamplerType = UMaterialExpressionTextureBase::GetSamplerTypeForTexture(&frames);
+		ArrayParam->Coordinates.Connect(0, Coordinates);
+		return ArrayParam;
+	}
+
+	// "PaletteLUT" texel of the index in the red channel of indices: index / 255 maps to the center of texel index of the
+	// 256 wide row.
+	static UMaterialExpression* AddPaletteLookup(UMaterial& material, UMaterialExpression& indices, UTexture2D& palette)
+	{
+		UMaterialExpressionMultiply* Scaled = AddMaterialExpression<UMaterialExpressionMultiply>(material, -750, 0);
+		Scaled->A.Connect(1, &indices);
+		Scaled->ConstB = 255.0f / 256.0f;
+
+		UMaterialExpressionAdd* Centered = AddMaterialExpression<UMaterialExpressionAdd>(material, -650, 0);
+		Centered->A.Connect(0, Scaled);
+		Centered->ConstB = 0.5f / 256.0f;
+
+		UMaterialExpressionConstant* Row = AddMaterialExpression<UMaterialExpressionConstant>(material, -650, 100);
+		Row->R = 0.5f;
+
+		UMaterialExpressionAppendVector* Coordinates = AddMaterialExpression<UMaterialExpressionAppendVector>(material, -550, 0);
+		Coordinates->A.Connect(0, Centered);
+		Coordinates->B.Connect(0, Row);
+
+		UMaterialExpressionTextureSampleParameter2D* PaletteParam = AddTextureParameter(material, PaletteLUTParamName, &palette, -450, 0);
+		PaletteParam->Coordinates.Connect(0, Coordinates);
+		return PaletteParam;
+	}
+
+	// Emissive = Color.rgb * Color.a * "FullbrightInAlpha". Returns the unlit part of the color, Color.rgb * (1 - mask),
+	// so fullbright texels ignore the lightmap as in Quake.
+	static UMaterialExpression* AddFullbrightFromAlpha(UMaterial& material, UMaterialExpression& color)
+	{
+		UMaterialExpressionScalarParameter* FullbrightParam = AddMaterialExpression<UMaterialExpressionScalarParameter>(material, -700, -250);
+		FullbrightParam->ParameterName = FullbrightInAlphaParamName;
+		FullbrightParam->DefaultValue = 1.0f;
+
+		UMaterialExpressionMultiply* FullbrightMask = AddMaterialExpression<UMaterialExpressionMultiply>(material, -550, -200);
+		FullbrightMask->A.Connect(4, &color);
+		FullbrightMask->B.Connect(0, FullbrightParam);
+
+		UMaterialExpressionMultiply* Emissive = AddMaterialExpression<UMaterialExpressionMultiply>(material, -350, -250);
+		Emissive->A.Connect(0, &color);
+		Emissive->B.Connect(0, FullbrightMask);
+		material.GetEditorOnlyData()->EmissiveColor.Connect(0, Emissive);
+
+		UMaterialExpressionOneMinus* LitMask = AddMaterialExpression<UMaterialExpressionOneMinus>(material, -400, -100);
+		LitMask->Input.Connect(0, FullbrightMask);
+
+		UMaterialExpressionMultiply* LitColor = AddMaterialExpression<UMaterialExpressionMultiply>(material, -300, -100);
+		LitColor->A.Connect(0, &color);
+		LitColor->B.Connect(0, LitMask);
+		return LitColor;
+	}
+
+	// HLSL summing the style layers, each scaled by the intensity of its style, as Quake's R_BuildLightMap does with
+	// d_lightstylevalue. Intensities come from the LightStyles<n> collection vectors, four styles each.
+	static FString GetLightStyleCode(int32 numLayers)
+	{
+		static const TCHAR* Slots[4] = { TEXT("x"), TEXT("y"), TEXT("z"), TEXT("w") };
+
+		FString Code = TEXT("float4 Styles[16] = { ");
+		for (int32 Index = 0; Index < 16; Index++)
+		{
+			Code += FString::Printf(TEXT("%sLightStyles%d"), Index > 0 ? TEXT(", ") : TEXT(""), Index);
+		}
+		Code += TEXT(" };\nuint4 Style = min(uint4(round(StyleNumbers * 255.0)), 63u);\nfloat3 Light = 0;\n");
+		for (int32 Layer = 0; Layer < numLayers; Layer++)
+		{
+			Code += FString::Printf(TEXT("Light += Layer%d * Styles[Style.%s / 4][Style.%s %% 4];\n"), Layer, Slots[Layer], Slots[Layer]);
+		}
+		Code += TEXT("return Light;");
+		return Code;
+	}
+
+	UMaterial* GetOrCreateSurfaceMaterial(const FSurfaceMaterialFeatures& features, const FSurfaceMaterialDefaults& defaults, UPackage& materialPackage)
+	{
+		const FString MaterialName = GetSurfaceMaterialName(features);
+		if (UMaterial* Existing = CheckIfAssetExist<UMaterial>(MaterialName, materialPackage))
+		{
+			return Existing;
+		}
+
+		const int32 NumLayers = features.bLightStyles ? FMath::Clamp(features.NumStyleLayers, 1, 4) : 1;
+		if ((features.bAnimated ? !defaults.ColorArray : !defaults.Color) || (features.bPaletteIndexed && !defaults.PaletteLUT) || (features.bLightmap && defaults.LightmapLayers.Num() < NumLayers) || (features.bLightStyles && !defaults.LightStyles))
+		{
+			return nullptr;
+		}
+
+		UMaterial* Material = NewObject<UMaterial>(&materialPackage, FName(*MaterialName), RF_Public | RF_Standalone);
+		if (!Material)
+		{
+			return nullptr;
+		}
+
+		Material->BlendMode = features.bMasked ? BLEND_Masked : BLEND_Opaque;
+		Material->SetShadingModel(MSM_DefaultLit);
+		Material->TwoSided = false;
+
+		UMaterialEditorOnlyData* EditorOnly = Material->GetEditorOnlyData();
+		UMaterialExpression* ColorParam = features.bAnimated ? AddAnimatedColorSample(*Material, *defaults.ColorArray)
+			: AddTextureParameter(*Material, ColorParamName, defaults.Color, -900, 0);
+		if (features.bPaletteIndexed)
+		{
+			ColorParam = AddPaletteLookup(*Material, *ColorParam, *defaults.PaletteLUT);
+		}
+		if (features.bMasked)
+		{
+			EditorOnly->OpacityMask.Connect(4, ColorParam);
+		}
+		UMaterialExpression* Albedo = features.bFullbrightInAlpha ? AddFullbrightFromAlpha(*Material, *ColorParam) : ColorParam;
+
+		// BaseColor = Color * Lightmap, as the shipped M_BSP_Solid.
+		UMaterialExpression* Light = nullptr;
+		if (features.bLightmap)
+		{
+			TArray<UMaterialExpressionTextureSampleParameter2D*> Layers;
+			for (int32 Layer = 0; Layer < NumLayers; Layer++)
+			{
+				const FName LayerName = Layer == 0 ? LightmapParamName : FName(*FString::Printf(TEXT("LightmapStyle%d"), Layer));
+				UMaterialExpressionTextureSampleParameter2D* LayerParam = AddTextureParameter(*Material, LayerName, defaults.LightmapLayers[Layer], -900, 300 + Layer * 250);
+				LayerParam->ConstCoordinate = 1;
+				Layers.Add(LayerParam);
+			}
+			Light = Layers[0];
+
+			if (features.bLightStyles)
+			{
+				UMaterialExpressionCustom* Styles = AddMaterialExpression<UMaterialExpressionCustom>(*Material, -500, 300);
+				Styles->Description = TEXT("Light styles");
+				Styles->OutputType = CMOT_Float3;
+				Styles->Code = GetLightStyleCode(NumLayers);
+				Styles->Inputs.Reset();
+				for (int32 Layer = 0; Layer < NumLayers; Layer++)
+				{
+					FCustomInput& Input = Styles->Inputs.AddDefaulted_GetRef();
+					Input.InputName = FName(*FString::Printf(TEXT("Layer%d"), Layer));
+					Input.Input.Connect(0, Layers[Layer]);
+				}
+
+				// Output 0 of the vertex color is RGB only; slot 3 is in the alpha.
+				UMaterialExpressionVertexColor* VertexColor = AddMaterialExpression<UMaterialExpressionVertexColor>(*Material, -900, 300 + NumLayers * 250);
+				UMaterialExpressionAppendVector* StyleNumbers = AddMaterialExpression<UMaterialExpressionAppendVector>(*Material, -750, 300 + NumLayers * 250);
+				StyleNumbers->A.Connect(0, VertexColor);
+				StyleNumbers->B.Connect(4, VertexColor);
+				FCustomInput& StyleNumbersInput = Styles->Inputs.AddDefaulted_GetRef();
+				StyleNumbersInput.InputName = TEXT("StyleNumbers");
+				StyleNumbersInput.Input.Connect(0, StyleNumbers);
+
+				for (int32 Index = 0; Index < 16; Index++)
+				{
+					UMaterialExpressionCollectionParameter* Intensities = AddMaterialExpression<UMaterialExpressionCollectionParameter>(*Material, -900, 500 + NumLayers * 250 + Index * 100);
+					Intensities->Collection = defaults.LightStyles;
+					Intensities->ParameterName = FName(*FString::Printf(TEXT("LightStyles%d"), Index));
+					Intensities->ParameterId = defaults.LightStyles->GetParameterId(Intensities->ParameterName);
+					FCustomInput& Input = Styles->Inputs.AddDefaulted_GetRef();
+					Input.InputName = Intensities->ParameterName;
+					Input.Input.Connect(0, Intensities);
+				}
+				Light = Styles;
+			}
+		}
+
+		if (Light)
+		{
+			UMaterialExpressionMultiply* Lit = AddMaterialExpression<UMaterialExpressionMultiply>(*Material, -200, 0);
+			Lit->A.Connect(0, Albedo);
+			Lit->B.Connect(0, Light);
+			EditorOnly->BaseColor.Connect(0, Lit);
+		}
+		else
+		{
+			EditorOnly->BaseColor.Connect(0, Albedo);
+		}
+		EditorOnly->Roughness.Constant = 1.0f;
+		EditorOnly->Metallic.Constant = 0.0f;
+		EditorOnly->Specular.Constant = 0.0f;
+
+		FAssetRegistryModule::AssetCreated(Material);
+		Material->PreEditChange(nullptr);
+		Material->MarkPackageDirty();
+		materialPackage.SetDirtyFlag(true);
+		Material->PostEditChange();
+
+		return Material;
+	}
+
     UMaterialInstanceConstant* GetOrCreateMaterialInstance(const FString& instanceName, UPackage& materialPackage, UMaterial& parentMaterial, UTexture2D& albedoTexture)
     {
         return GetOrCreateMaterialInstance(instanceName, materialPackage, (UMaterialInterface&)parentMaterial, albedoTexture);
@@ -470,6 +1153,8 @@ namespace QuakeCommon
 
 	UMaterialInstanceConstant* GetOrCreateMaterialInstance(const FString& instanceName, UPackage& materialPackage, UMaterialInterface& parentMaterial, UTexture2D& albedoTexture, bool bOverwrite)
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuakeCommon::GetOrCreateMaterialInstance);
+
 		if (UMaterialInstanceConstant* Existing = CheckIfAssetExist<UMaterialInstanceConstant>(instanceName, materialPackage))
 		{
 			if (!bOverwrite)
@@ -506,8 +1191,76 @@ namespace QuakeCommon
 		return MI;
 	}
 
+	void SetAnimatedTextureParameters(UMaterialInstanceConstant& instance, UTexture2DArray& frames, int32 numFrames, bool bOverwrite)
+	{
+		const FMaterialParameterInfo ArrayInfo(ColorArrayParamName);
+		UTexture* Current = nullptr;
+		if (!bOverwrite && instance.GetTextureParameterValue(ArrayInfo, Current, true) && Current)
+		{
+			return;
+		}
+
+		instance.PreEditChange(nullptr);
+		instance.SetTextureParameterValueEditorOnly(ArrayInfo, &frames);
+		instance.SetScalarParameterValueEditorOnly(FMaterialParameterInfo(AnimationFramesParamName), float(numFrames));
+		instance.MarkPackageDirty();
+		instance.PostEditChange();
+	}
+
+	void SetPaletteLookupParameters(UMaterialInstanceConstant& instance, UTexture2D* palette, UTexture2D* colormap, bool bOverwrite)
+	{
+		const FMaterialParameterInfo IndexedInfo(PaletteIndexedParamName);
+		float CurrentIndexed = 0.f;
+		const bool bHasIndexed = instance.GetScalarParameterValue(IndexedInfo, CurrentIndexed, true);
+		if (!palette)
+		{
+			// Back to BGRA8 textures, which only replace the indexed ones when overwriting.
+			if (bOverwrite && bHasIndexed && CurrentIndexed != 0.f)
+			{
+				instance.PreEditChange(nullptr);
+				instance.SetScalarParameterValueEditorOnly(IndexedInfo, 0.f);
+				instance.MarkPackageDirty();
+				instance.PostEditChange();
+			}
+			return;
+		}
+		if (!bOverwrite && bHasIndexed && CurrentIndexed != 0.f)
+		{
+			return;
+		}
+
+		instance.PreEditChange(nullptr);
+		instance.SetTextureParameterValueEditorOnly(FMaterialParameterInfo(PaletteLUTParamName), palette);
+		if (colormap)
+		{
+			instance.SetTextureParameterValueEditorOnly(FMaterialParameterInfo(ColormapParamName), colormap);
+		}
+		instance.SetScalarParameterValueEditorOnly(IndexedInfo, 1.f);
+		instance.MarkPackageDirty();
+		instance.PostEditChange();
+	}
+
+	void SetFullbrightInAlphaParameter(UMaterialInstanceConstant& instance, bool bFullbrightInAlpha, bool bOverwrite)
+	{
+		const FMaterialParameterInfo Info(FullbrightInAlphaParamName);
+		float Current = 0.f;
+		const bool bHasParameter = instance.GetScalarParameterValue(Info, Current, true);
+		if ((Current != 0.f) == bFullbrightInAlpha || (bHasParameter && !bOverwrite))
+		{
+			return;
+		}
+
+		instance.PreEditChange(nullptr);
+		instance.SetScalarParameterValueEditorOnly(Info, bFullbrightInAlpha ? 1.f : 0.f);
+		instance.MarkPackageDirty();
+		instance.PostEditChange();
+	}
+
     void SaveAsset(UObject& object, UPackage& package)
     {
+        TRACE_CPUPROFILER_EVENT_SCOPE(QuakeCommon::SaveAsset);
+        INC_DWORD_STAT(STAT_QuakeImport_PackagesSaved);
+
         const FString filename = FPackageName::LongPackageNameToFilename(
             package.GetName(),
             FPackageName::GetAssetPackageExtension()
@@ -523,6 +1276,9 @@ namespace QuakeCommon
 
     void SavePackage(UPackage& package)
     {
+        TRACE_CPUPROFILER_EVENT_SCOPE(QuakeCommon::SavePackage);
+        INC_DWORD_STAT(STAT_QuakeImport_PackagesSaved);
+
         const FString filename = FPackageName::LongPackageNameToFilename(
             package.GetName(),
             FPackageName::GetAssetPackageExtension()
@@ -536,4 +1292,44 @@ namespace QuakeCommon
         UPackage::SavePackage(&package, nullptr, *filename, args);
     }
 
+    bool FindBspFiles(const FString& Source, TArray<FString>& OutFiles)
+    {
+        FString SourcePath = Source;
+        if (FPaths::IsRelative(SourcePath))
+        {
+            SourcePath = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), SourcePath);
+        }
+
+        if (FPaths::DirectoryExists(SourcePath))
+        {
+            IFileManager::Get().FindFilesRecursive(OutFiles, *SourcePath, TEXT("*.bsp"), true, false);
+        }
+        else if (FPaths::GetExtension(SourcePath).Equals(TEXT("bsp"), ESearchCase::IgnoreCase))
+        {
+            OutFiles.Add(SourcePath);
+        }
+        else
+        {
+            TArray<FString> Lines;
+            if (!FFileHelper::LoadFileToStringArray(Lines, *SourcePath))
+            {
+                return false;
+            }
+
+            const FString ManifestDir = FPaths::GetPath(SourcePath);
+            for (FString Line : Lines)
+            {
+                Line.TrimStartAndEndInline();
+                if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+                {
+                    continue;
+                }
+                OutFiles.Add(FPaths::IsRelative(Line) ? FPaths::ConvertRelativePathToFull(ManifestDir, Line) : Line);
+            }
+        }
+
+        OutFiles.Sort();
+        return OutFiles.Num() > 0;
+    }
+
 } // namespace QuakeCommon
@@ -2,9 +2,12 @@
 
 #include "CoreMinimal.h"
 
+class UTexture;
 class UTexture2D;
+class UTexture2DArray;
 class UPackage;
 class UMaterial;
+class UMaterialParameterCollection;
 class UMaterialInstanceConstant;
 class UMaterialInterface;
 
@@ -21,6 +24,13 @@ namespace QuakeCommon
     // Load Quake color palette from file in our plugin content
     bool LoadPalette(TArray<QColor>& outPalette);
 
+	// Light levels of the Quake colormap: ColormapLevels rows of 256 palette indices, from the plugin content.
+	static constexpr int32 ColormapLevels = 64;
+
+	// Load colormap.lmp from our plugin content, ColormapLevels * 256 bytes. Row 32 leaves colors unchanged, lower rows
+	// brighten and higher rows darken them.
+	bool LoadColormap(TArray<uint8>& outColormap);
+
     // Create a UTexture2D in the given package then save
     UTexture2D* CreateUTexture2D(const FString& name, int width, int height, const TArray<uint8>& data, UPackage& texturePackage, const TArray<QColor>& pal, bool savePackage = true);
 
@@ -28,6 +38,72 @@ namespace QuakeCommon
 	UTexture2D* CreateOrUpdateUTexture2D(const FString& name, int width, int height, const TArray<uint8>& data, UPackage& texturePackage, const TArray<QColor>& pal, bool bOverwrite, bool bUsePaletteAlpha, bool savePackage = true);
 	UTexture2D* CreateOrUpdateUTexture2DFromBGRA(const FString& name, int width, int height, const TArray<uint8>& data, UPackage& texturePackage, bool bOverwrite, bool savePackage = true);
 
+	// Palette indices 224 to 255 are drawn fullbright by Quake, ignoring the lightmap.
+	static constexpr int32 FirstFullbrightIndex = 224;
+
+	enum class EPaletteLUTVariant : uint8
+	{
+		// Alpha 255 everywhere.
+		Opaque,
+		// Index 255 transparent, for masked textures.
+		Masked,
+		// Alpha 255 on fullbright indices, 0 elsewhere.
+		Fullbright,
+	};
+
+	// Palette index to BGRA8 texel, as a uint32 in BGRA memory order.
+	struct FPaletteLUT
+	{
+		uint32 Entries[256];
+	};
+
+	void BuildPaletteLUT(const TArray<QColor>& pal, EPaletteLUTVariant variant, FPaletteLUT& outLUT);
+
+	// Expands count palette indices to BGRA8 texels through the table. Safe off the game thread.
+	void ExpandPaletteIndices(const uint8* indices, int64 count, const FPaletteLUT& lut, uint8* outBGRA);
+
+	// Expand 8 bit palette indices to BGRA8. Index 255 becomes transparent when bUsePaletteAlpha. Safe off the game thread.
+	void ExpandPaletteToBGRA(const TArray<uint8>& data, const TArray<QColor>& pal, bool bUsePaletteAlpha, TArray<uint8>& outBGRA);
+	void ExpandPaletteToBGRA(const TArray<uint8>& data, const FPaletteLUT& lut, TArray<uint8>& outBGRA);
+
+	// Appends 2x2 box filtered BGRA8 mips after the numMips levels already in chain, down to 1x1. Returns the new mip count.
+	// Each level holds numSlices images one after the other, filtered separately.
+	int32 AppendBoxFilteredMipsBGRA(TArray<uint8>& chain, int width, int height, int32 numMips, int32 numSlices = 1);
+
+	// Same as AppendBoxFilteredMipsBGRA for a chain of palette indices: each texel becomes the palette color nearest to the
+	// average of its 2x2 block, among the fullbright indices for mostly fullbright blocks and the lit ones otherwise.
+	// Index 255 is transparent only when bMasked, which makes a texel 255 when most of its block is transparent.
+	int32 AppendPaletteMipsIndexed(TArray<uint8>& chain, int width, int height, int32 numMips, const TArray<QColor>& pal, bool bMasked, int32 numSlices = 1);
+
+	// Texel storage of the palette textures.
+	enum class EPaletteTextureFormat : uint8
+	{
+		// Colors expanded through the palette, sRGB, compressed as the engine picks for TC_Default.
+		BGRA8,
+		// Raw palette indices in a linear G8 texture, a quarter of the size. The material looks the color up in the
+		// shared palette (or colormap) texture.
+		Indexed,
+		// Expanded colors, block compressed by the texture build: BC1 ignores alpha, BC3 and BC7 keep it. Sizes must
+		// be multiples of 4, which power-of-two sizes are down to the 4x4 mip.
+		BC1,
+		BC3,
+		BC7,
+	};
+
+	// Bytes per texel of the pixels handed to the texture functions (the source, before any block compression).
+	int32 GetBytesPerTexel(EPaletteTextureFormat format);
+
+	// Nearest neighbour resize of a srcWidth x srcHeight image of palette indices; indices are never blended.
+	void ResamplePaletteIndicesNearest(const uint8* src, int srcWidth, int srcHeight, uint8* dst, int dstWidth, int dstHeight);
+
+	// Same texture settings as CreateOrUpdateUTexture2D (pixel art, nearest), from already expanded texels.
+	// pixels holds numMips levels in the given format, mip 0 first; textures with mips stream.
+	UTexture2D* CreateOrUpdatePaletteUTexture2DFromBGRA(const FString& name, int width, int height, const TArray<uint8>& pixels, UPackage& texturePackage, bool bOverwrite, int32 numMips = 1, EPaletteTextureFormat format = EPaletteTextureFormat::BGRA8);
+
+	// Array of numSlices frames named TA_<name>, same settings. Each of the numMips levels of pixels holds every slice in order.
+	// Platform data is built from the source by the texture compiler.
+	UTexture2DArray* CreateOrUpdatePaletteUTexture2DArrayFromBGRA(const FString& name, int width, int height, int32 numSlices, const TArray<uint8>& pixels, UPackage& texturePackage, bool bOverwrite, int32 numMips = 1, EPaletteTextureFormat format = EPaletteTextureFormat::BGRA8);
+
     // Create matching material for texture
     void CreateUMaterial(const FString& textureName, UPackage& materialPackage, UTexture2D& initialTexture);
 
@@ -40,6 +116,47 @@ namespace QuakeCommon
     // Create (or reuse) a master unlit material that drives Emissive from the same color texture parameter.
     UMaterial* GetOrCreateSkyUnlitMasterMaterial(const FString& materialName, UPackage& materialPackage);
 
+	// Graph of a generated surface parent material. Each combination is its own material, named by GetSurfaceMaterialName.
+	struct FSurfaceMaterialFeatures
+	{
+		// Opacity mask from the alpha of the color.
+		bool bMasked = false;
+		// Samples the "ColorArray" frames of an animated texture instead of "Color", stepping through "AnimationFrames"
+		// of them five times a second as Quake does.
+		bool bAnimated = false;
+		// The color texture holds palette indices (G8), looked up in the "PaletteLUT" row. Index 255 of the row is
+		// transparent, which only matters to masked materials.
+		bool bPaletteIndexed = false;
+		// The color alpha is the fullbright mask: masked texels are emissive and ignore the lightmap, scaled by the
+		// "FullbrightInAlpha" scalar.
+		bool bFullbrightInAlpha = false;
+		// Base color multiplied by the "Lightmap" texture, sampled at UV1.
+		bool bLightmap = false;
+		// "Lightmap" and "LightmapStyle1" to "LightmapStyle<NumStyleLayers - 1>" each weighted by the intensity of the
+		// light style stored in the matching vertex color channel (R, G, B, then alpha for slot 3), read from the
+		// LightStyles<style / 4> vectors of the light style collection.
+		bool bLightStyles = false;
+		int32 NumStyleLayers = 1;
+	};
+
+	// Default values of the generated parent parameters. Texture parameters sample with the settings of their
+	// default, so these must be textures of the kind the instances bind.
+	struct FSurfaceMaterialDefaults
+	{
+		UTexture2D* Color = nullptr;
+		UTexture2DArray* ColorArray = nullptr;
+		UTexture2D* PaletteLUT = nullptr;
+		// The lightmap page followed by its style layers.
+		TArray<UTexture2D*> LightmapLayers;
+		UMaterialParameterCollection* LightStyles = nullptr;
+	};
+
+	FString GetSurfaceMaterialName(const FSurfaceMaterialFeatures& features);
+
+	// Create (or reuse) the parent material drawing surfaces with the given features, named GetSurfaceMaterialName.
+	// An existing material is never rebuilt, so edits made to it survive reimports.
+	UMaterial* GetOrCreateSurfaceMaterial(const FSurfaceMaterialFeatures& features, const FSurfaceMaterialDefaults& defaults, UPackage& materialPackage);
+
     // Create (or reuse) a material instance that binds the master material's albedo parameter.
     UMaterialInstanceConstant* GetOrCreateMaterialInstance(const FString& instanceName, UPackage& materialPackage, UMaterial& parentMaterial, UTexture2D& albedoTexture);
 
@@ -52,6 +169,18 @@ namespace QuakeCommon
 	// Same as above, but supports overwriting an existing instance.
 	UMaterialInstanceConstant* GetOrCreateMaterialInstance(const FString& instanceName, UPackage& materialPackage, UMaterialInterface& parentMaterial, UTexture2D& albedoTexture, bool bOverwrite);
 
+	// Binds the frames of an animated texture to the "ColorArray" parameter and their count to "AnimationFrames", which
+	// the animated surface parents sample. Values already set are kept unless bOverwrite.
+	void SetAnimatedTextureParameters(UMaterialInstanceConstant& instance, UTexture2DArray& frames, int32 numFrames, bool bOverwrite);
+
+	// Binds the shared "PaletteLUT" and "Colormap" textures and sets "PaletteIndexed" to 1, for instances whose "Color"
+	// holds palette indices. A null palette sets "PaletteIndexed" back to 0 when overwriting an instance that has it.
+	void SetPaletteLookupParameters(UMaterialInstanceConstant& instance, UTexture2D* palette, UTexture2D* colormap, bool bOverwrite);
+
+	// Sets "FullbrightInAlpha" to 1 on instances whose "Color" alpha is the fullbright mask, or back to 0 when overwriting
+	// an instance that has it.
+	void SetFullbrightInAlphaParameter(UMaterialInstanceConstant& instance, bool bFullbrightInAlpha, bool bOverwrite);
+
     // Utilities
 
     template<class T>
@@ -78,4 +207,8 @@ namespace QuakeCommon
 
     void SavePackage(UPackage& package);
 
+    // Collect BSP files from a single .bsp, a directory (recursive) or a text manifest with one path per line.
+    // Relative paths resolve against the project (Source) or the manifest folder (manifest entries). Sorted.
+    bool FindBspFiles(const FString& Source, TArray<FString>& OutFiles);
+
 } // namespace QuakeCommon
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+
+// Import counters: "stat QuakeImport" in the editor, or the stats channel in Unreal Insights.
+// Accumulators, so they hold totals since editor start; diff two captures to get one import.
+DECLARE_STATS_GROUP(TEXT("QuakeImport"), STATGROUP_QuakeImport, STATCAT_Advanced);
+
+// Faces appended to world and entity chunks.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Faces"), STAT_QuakeImport_Faces, STATGROUP_QuakeImport, );
+// Triangles written to static meshes.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Triangles"), STAT_QuakeImport_Triangles, STATGROUP_QuakeImport, );
+// Chunks assembled, and how many of them were rebuilt into static meshes.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Chunks"), STAT_QuakeImport_Chunks, STATGROUP_QuakeImport, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Meshes built"), STAT_QuakeImport_MeshesBuilt, STATGROUP_QuakeImport, );
+// Textures converted from the BSP palette, and lightmap atlases packed.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Textures"), STAT_QuakeImport_Textures, STATGROUP_QuakeImport, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Lightmap atlases"), STAT_QuakeImport_LightmapAtlases, STATGROUP_QuakeImport, );
+// Bytes copied out of the file and into texture data (lumps, mips, BGRA expansion, atlas pixels).
+// A 64-bit memory stat, shown in MB: a few large imports overflow a DWORD.
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Bytes copied"), STAT_QuakeImport_BytesCopied, STATGROUP_QuakeImport, );
+// Packages written to disk.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Packages saved"), STAT_QuakeImport_PackagesSaved, STATGROUP_QuakeImport, );
@@ -4,6 +4,7 @@
 #include "UObject/SoftObjectPtr.h"
 #include "Engine/EngineTypes.h"
 #include "Engine/CollisionProfile.h"
+#include "QuakeBSPImportReport.h"
 #include "QuakeBSPImportAsset.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogQuakeImporter, Log, All);
@@ -15,6 +16,36 @@ enum class EWorldChunkMode : uint8
 	Leaves UMETA(DisplayName="Leaves")
 };
 
+// Storage of the lightmap atlas textures. Every encoding is sampled as is, so parents need no decode.
+UENUM(BlueprintType)
+enum class ELightmapAtlasEncoding : uint8
+{
+	// BGRA8, 4 bytes per texel.
+	Uncompressed UMETA(DisplayName="Uncompressed (BGRA8)"),
+	BC1 UMETA(DisplayName="BC1"),
+	BC7 UMETA(DisplayName="BC7")
+};
+
+// Storage of the generated BSP textures (not lightmaps), when they are not palette indexed. The BC formats come from
+// the engine's texture compressor working on the expanded colors; the endpoints it picks are not palette colors.
+UENUM(BlueprintType)
+enum class EBspTextureEncoding : uint8
+{
+	// BSP sizes, TC_Default.
+	Default UMETA(DisplayName="Default"),
+	// Power-of-two sizes, BC1, or BC3 for textures that use alpha (masked or fullbright).
+	BC1_BC3 UMETA(DisplayName="BC1 / BC3", ToolTip="Power-of-two sizes, engine BC1 compression, or BC3 for textures that use alpha"),
+	// Power-of-two sizes, BC1, or BC7 for textures that use alpha.
+	BC1_BC7 UMETA(DisplayName="BC1 / BC7", ToolTip="Power-of-two sizes, engine BC1 compression, or BC7 for textures that use alpha")
+};
+
+class FQuakeBSPFileWatcher;
+
+namespace QuakeBspImportRunner
+{
+	struct FImportResult;
+}
+
 UCLASS(BlueprintType)
 class QUAKEIMPORT_API UQuakeBSPImportAsset : public UObject
 {
@@ -22,6 +53,19 @@ class QUAKEIMPORT_API UQuakeBSPImportAsset : public UObject
 
 public:
 	UQuakeBSPImportAsset();
+
+	virtual void PostLoad() override;
+	virtual void BeginDestroy() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Called by the file watcher once BSPFile / BSPLitFile changed and the debounce delay expired.
+	// Prepares in the background and commits on a later tick, without a modal progress dialog.
+	void ReimportFromWatcher();
+
+	// True from the start of an import until its generated level is populated, including background reimports.
+	bool IsImportInProgress() const { return bImportInProgress; }
     
     UFUNCTION(CallInEditor, Category="Quake Import", meta = (DisplayName="Import BSP World"))
     void ImportBSP();
@@ -47,10 +91,79 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Quake Import")
 	bool bOverwriteMaterialsAndTextures = true;
 
+	// Imports the mips authored in the BSP miptex (box filtering the rest down to 1x1) so distant surfaces sample
+	// small mips and textures stream. Disable for the unfiltered look of full resolution textures everywhere.
+	UPROPERTY(EditAnywhere, Category = "Quake Import")
+	bool bImportTextureMips = true;
+
+	// Stores textures as their 8-bit palette indices (G8, a quarter of the BGRA8 size) instead of expanded colors.
+	// Their instances get a generated M_QuakeSurface_..._Indexed parent that looks the color up in the shared
+	// T_QuakePalette, plus T_QuakeColormap (when colormap.lmp is next to palette.lmp) and PaletteIndexed = 1 for custom
+	// parents. Sky, liquids and triggers keep BGRA8 textures, as their configured parents sample colors.
+	UPROPERTY(EditAnywhere, Category = "Quake Import")
+	bool bPaletteIndexedTextures = false;
+
+	// Stores which texels are fullbright (palette indices 224 and up, unaffected by light in Quake) in the alpha of opaque
+	// lit textures. Their instances get a generated M_QuakeSurface_..._FB parent that makes those texels emissive and
+	// unlit, scaled by FullbrightInAlpha. The alpha makes block compressed textures BC3 or BC7 instead of BC1. Masked
+	// textures keep alpha for opacity.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="!bPaletteIndexedTextures"))
+	bool bFullbrightInAlpha = false;
+
+	// Block compressed encodings resize non power-of-two textures (48x80 becomes 64x128) with nearest neighbour
+	// sampling of the palette indices, so every mip can be compressed and streamed, then leave the compression to the
+	// engine's BC1 / BC3 / BC7 encoders. These are not palette aware, so texels may drift off the Quake palette. UVs
+	// are normalized to the texture size, so meshes need no change. 4 (BC1) to 8 (BC3, BC7) times less GPU memory
+	// than BGRA8.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="!bPaletteIndexedTextures"))
+	EBspTextureEncoding TextureEncoding = EBspTextureEncoding::Default;
+
 	// If enabled, the importer will extract Quake BSP lightmaps into a shared atlas texture and generate UV1 for meshes to sample it.
+	// If disabled, UV1 is still laid out from the BSP lightmap charts, packed per chunk, so UE never unwraps the meshes.
 	UPROPERTY(EditAnywhere, Category = "Quake Import")
 	bool bImportLightmaps = false;
 
+	// If enabled, the up to four light styles of every face are imported instead of the first one only, one atlas
+	// texture per style slot. Faces carry their style numbers in the vertex color and a shared MPC_QuakeLightStyles
+	// collection holds the style intensities. Lit surfaces get a generated M_QuakeSurface parent, next to the maps,
+	// that weights the styles by the collection, instead of the configured solid and masked materials.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="bImportLightmaps", EditConditionHides))
+	bool bImportLightStyles = false;
+
+	// Texture format of the lightmap atlas. The compressed encodings cut lightmap memory 4 to 8 times.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="bImportLightmaps", EditConditionHides))
+	ELightmapAtlasEncoding LightmapEncoding = ELightmapAtlasEncoding::Uncompressed;
+
+	// Generates lightmap mips, only as far down as the padding around each face lightmap keeps neighbours from bleeding in.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="bImportLightmaps", EditConditionHides))
+	bool bLightmapMips = false;
+
+	// If enabled, every mesh chunk (or cluster of chunks) gets lightmap atlas pages of its own instead of sharing the map
+	// atlas, sampled through per-page material instances. Streaming a chunk out, e.g. with World Partition, then also
+	// releases its lightmaps, at the cost of more textures and material instances.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="bImportLightmaps", EditConditionHides))
+	bool bPerChunkLightmapAtlas = false;
+
+	// Consecutive chunks sharing lightmap pages when bPerChunkLightmapAtlas is enabled.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="bImportLightmaps && bPerChunkLightmapAtlas", EditConditionHides, ClampMin="1", UIMin="1"))
+	int32 LightmapChunkClusterSize = 1;
+
+	// If enabled, the lightmaps (or .lit colors) are baked into the vertex colors, light styles summed at normal
+	// intensity, for low-end targets that cannot afford a lightmap sample. Independent of bImportLightmaps; replaces
+	// the light style numbers in the vertex color. Parent materials have to read the vertex color as the lightmap.
+	UPROPERTY(EditAnywhere, Category = "Quake Import")
+	bool bBakeVertexLighting = false;
+
+	// Cuts faces along the 16 unit luxel grid so every luxel gets a vertex, instead of interpolating the lightmap
+	// across whole faces. Many more triangles, and T-junctions where lit faces meet unlit ones.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(EditCondition="bBakeVertexLighting", EditConditionHides))
+	bool bTessellateVertexLighting = false;
+
+	// Upper bound, in MB, on chunk geometry held in memory while meshes are built. Chunks are assembled and
+	// built a batch at a time under this budget; lower it if huge maps run the editor out of memory.
+	UPROPERTY(EditAnywhere, Category = "Quake Import", AdvancedDisplay, meta=(ClampMin="16", UIMin="64"))
+	int32 ChunkBuildMemoryBudgetMB = 512;
+
 	// Optional .lit file (BSP2 colored lightmaps). If set and valid, it will be used instead of BSP lightdata.
 	UPROPERTY(EditAnywhere, Category = "Quake Import", meta=(DisplayName="BSP Lightmap File (.lit)", EditCondition="bImportLightmaps", EditConditionHides))
 	FFilePath BSPLitFile;
@@ -158,6 +271,54 @@ public:
     UPROPERTY(VisibleAnywhere, Category="Quake Import|Level Instances")
     FGuid EntitiesLevelInstanceId;
     
+    // Watch the BSP file (and the .lit file) on disk and reimport automatically after the map is recompiled.
+    // Only chunks whose content changed are rebuilt; placed Level Instances are reloaded only when the chunk set changed.
+    UPROPERTY(EditAnywhere, Category = "Quake Import|Hot Reload", meta = (DisplayName="Watch BSP File"))
+    bool bWatchBSPFile = false;
+
+    // Delay after the last file change before reimporting, so the compiler has finished writing the BSP.
+    UPROPERTY(EditAnywhere, Category = "Quake Import|Hot Reload", meta = (ClampMin="0.0", EditCondition="bWatchBSPFile", EditConditionHides))
+    float WatchDebounceSeconds = 1.0f;
+
+    // Also reimport brush entities on change (only if they were imported before).
+    UPROPERTY(EditAnywhere, Category = "Quake Import|Hot Reload", meta = (EditCondition="bWatchBSPFile", EditConditionHides))
+    bool bWatchReimportEntities = true;
+
+    // Writes the last world and entities reports to Saved/QuakeImport/Reports as <Map>_<Kind>.json and .csv.
+    UFUNCTION(CallInEditor, Category = "Quake Import|Report", meta = (DisplayName="Export Import Reports"))
+    void ExportImportReports();
+
+    // Chunks with more material sections (draw calls) than this are flagged in the import report. 0 disables the check.
+    UPROPERTY(EditAnywhere, Category = "Quake Import|Report", meta = (ClampMin="0"))
+    int32 ReportMaxSectionsPerChunk = 8;
+
+    // Chunks with fewer triangles than this are flagged as nearly empty in the import report. 0 disables the check.
+    UPROPERTY(EditAnywhere, Category = "Quake Import|Report", meta = (ClampMin="0"))
+    int32 ReportMinTrianglesPerChunk = 16;
+
+    // Stage timings and per-chunk content of the last world import. Transient: timings differ on every run, so
+    // keeping them would dirty the asset even when an import changed nothing. Use Export Import Reports to keep one.
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Quake Import|Report")
+    FQuakeImportReport LastWorldImportReport;
+
+    // Stage timings and per-chunk content of the last entities import.
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Quake Import|Report")
+    FQuakeImportReport LastEntitiesImportReport;
+
     // Generated mesh references were previously stored for convenience/debugging.
     // Removed to keep the asset UI lean.
+
+private:
+	void UpdateFileWatcher();
+
+	// Populate the generated level from a committed import and store its report. A failed or cancelled import
+	// only stores the report.
+	void FinishWorldImport(bool bImported, QuakeBspImportRunner::FImportResult& Result);
+	void FinishEntitiesImport(bool bImported, QuakeBspImportRunner::FImportResult& Result);
+
+	// Adds the level population time and outlier flags, logs a summary and keeps the report on the asset.
+	void StoreImportReport(FQuakeImportReport& Target, FQuakeImportReport&& Report, double PopulateStartSeconds);
+
+	TSharedPtr<FQuakeBSPFileWatcher> FileWatcher;
+	bool bImportInProgress = false;
 };
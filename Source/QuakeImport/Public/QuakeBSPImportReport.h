@@ -0,0 +1,172 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuakeBSPImportReport.generated.h"
+
+// One generated static mesh (world chunk or brush entity) as built by the last import.
+USTRUCT(BlueprintType)
+struct QUAKEIMPORT_API FQuakeImportChunkReport
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	FString MeshName;
+
+	// Solid, Liquid, Sky or Trigger.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	FString Kind;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	int32 Faces = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	int32 Triangles = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	int32 Vertices = 0;
+
+	// Material sections, i.e. draw calls per mesh.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	int32 Sections = 0;
+
+	// Triangles cooked into the complex collision mesh (0 for NoCollision chunks).
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	int32 CollisionTriangles = 0;
+
+	// Lightmap resolution of the mesh (0 when UV1 samples the shared atlas).
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	int32 LightmapSize = 0;
+
+	// False when the content hash matched and the existing mesh was kept.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	bool bRebuilt = false;
+
+	// More sections than ReportMaxSectionsPerChunk.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	bool bTooManySections = false;
+
+	// Fewer triangles than ReportMinTrianglesPerChunk.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	bool bNearlyEmpty = false;
+};
+
+// Timings and content of one world or entities import, kept on the import asset and exportable as JSON / CSV.
+USTRUCT(BlueprintType)
+struct QUAKEIMPORT_API FQuakeImportReport
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	FString MapName;
+
+	// "World" or "Entities".
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	FString ImportKind;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	FDateTime Timestamp;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report")
+	bool bCancelled = false;
+
+	// Stage wall times, in seconds. Load to Geometry run on a background task, the rest on the game thread.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double LoadSeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double PrepareTexturesSeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double PrepareAtlasSeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double GeometrySeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double CommitTexturesSeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double CommitLightmapSeconds = 0.0;
+
+	// Chunk geometry, generated in parallel batches bounded by ChunkBuildMemoryBudgetMB.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double CommitAssembleSeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double CommitMeshesSeconds = 0.0;
+
+	// Generated level update (actors, save, Level Instance reload).
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double PopulateSeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Timings")
+	double TotalSeconds = 0.0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumChunks = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumRebuilt = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumFaces = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumTriangles = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumVertices = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumSections = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumCollisionTriangles = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int32 NumTextures = 0;
+
+	// Uncompressed source size of the generated textures (BGRA8, or 1 byte per texel palette indexed), mips excluded,
+	// plus LightmapAtlasBytes.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Content")
+	int64 TextureBytes = 0;
+
+	// More than one when the lightmaps overflow a 4096 page.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Lightmap")
+	int32 NumLightmapAtlasPages = 0;
+
+	// Size of the first page.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Lightmap")
+	int32 LightmapAtlasWidth = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Lightmap")
+	int32 LightmapAtlasHeight = 0;
+
+	// Size once encoded, style layers and mips included.
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Lightmap")
+	int64 LightmapAtlasBytes = 0;
+
+	// Fraction of atlas texels, over all pages, covered by face lightmaps, in [0, 1].
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Lightmap")
+	float LightmapAtlasOccupancy = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Outliers")
+	int32 NumChunksWithTooManySections = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Outliers")
+	int32 NumNearlyEmptyChunks = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Quake Import|Report|Chunks")
+	TArray<FQuakeImportChunkReport> Chunks;
+
+	bool IsValid() const { return !MapName.IsEmpty(); }
+
+	// Sets the outlier flags of every chunk and the outlier totals. A threshold <= 0 disables its check.
+	void FlagOutliers(int32 MaxSectionsPerChunk, int32 MinTrianglesPerChunk);
+
+	// Whole report as a JSON object, chunks included.
+	bool ToJsonString(FString& OutJson) const;
+
+	// One row per chunk, with a header row.
+	FString ToCsvString() const;
+};
@@ -45,8 +45,11 @@ public class QuakeImport : ModuleRules
 				"Projects",
 				"RawMesh",
 				"AssetRegistry",
+				"DirectoryWatcher",
 				"RenderCore",
-				"RHI"
+				"RHI",
+				"Json",
+				"JsonUtilities"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);